@@ -0,0 +1,156 @@
+//
+// Created by aurora on 2026/10/19.
+//
+/**
+ * 快速内存(Arena)的基准测试
+ * 用法: bench-arena [iterations] [max_threads]
+ *
+ * 1 resource_mark  每次进入ResourceArenaMark后申请若干内存 迫使Arena申请新的内存块
+ *                  退出时回滚并归还内存块 1..N 个线程并发执行
+ *                  用于观察 ArenaChunkPool 及线程缓存的竞争情况
+ * 2 grow           在ResourceArenaMark内将缓冲区从16字节倍增到16K 中间穿插少量的小申请
+ *                  realloc 使用Arena::realloc 原地扩展
+ *                  copy    每次重新申请并拷贝
+ *                  结束后输出从内存块尾部回收的字节
+ * 3 large          在ResourceArenaMark内申请一块大内存(48K 256K 1M)并写入 退出时回滚
+ *                  大内存单独映射 回滚时直接归还给操作系统
+ *
+ * 结束后清理一次内存池 并将内存池的统计信息输出到标准错误
+ */
+#include "bench.hpp"
+#include "plat/mem/Arena.hpp"
+#include "plat/thread/OSThread.hpp"
+
+using namespace bench;
+
+static const char *const BENCH_NAME = "arena";
+
+/**
+ * 每次标记内申请的字节 超过初始内存块 必然需要新的内存块
+ */
+static const size_t SPILL_SIZES[] = {512, 4 * K, 64 * K};
+static const char *const SPILL_NAMES[] = {"spill_512", "spill_4k", "spill_64k"};
+
+struct MarkArgs {
+    size_t spill_bytes;
+    size_t ops_per_thread;
+    Latency *latencies;
+};
+
+static void resource_mark_worker(uint32_t index, void *arg) {
+    const auto args = (MarkArgs *) arg;
+    const auto arena = OSThread::current()->resource_arena();
+    auto &latency = args->latencies[index];
+    for (size_t i = 0; i < args->ops_per_thread; ++i) {
+        const auto start = now();
+        {
+            ResourceArenaMark rm;
+            size_t allocated = 0;
+            while (allocated < args->spill_bytes) {
+                const auto bytes = MIN2<size_t>(args->spill_bytes - allocated, 256);
+                guarantee(arena->alloc(bytes, true) != nullptr, "arena alloc failed");
+                allocated += bytes;
+            }
+        }
+        latency.add(now() - start);
+    }
+}
+
+static void bench_resource_mark(size_t iterations, uint32_t max_threads) {
+    for (size_t s = 0; s < sizeof(SPILL_SIZES) / sizeof(size_t); ++s) {
+        for (uint32_t threads = 1; threads <= max_threads; threads <<= 1) {
+            std::vector<Latency> latencies(threads);
+            MarkArgs args{SPILL_SIZES[s], iterations / threads, latencies.data()};
+            const auto elapsed = run_threads(threads, resource_mark_worker, &args);
+            Latency all(iterations);
+            for (auto &latency: latencies) {
+                all.merge(latency);
+            }
+            report(BENCH_NAME, "resource_mark", SPILL_NAMES[s], threads,
+                   all.count(), elapsed, all);
+            if (threads == max_threads) {
+                break;
+            }
+            //保证最后一轮恰好是max_threads
+            if ((threads << 1) > max_threads) {
+                threads = max_threads >> 1;
+            }
+        }
+    }
+}
+
+static void *grow_buffer(Arena *arena, void *buf, size_t old_bytes, size_t new_bytes, bool use_realloc) {
+    if (use_realloc) {
+        return arena->realloc(buf, old_bytes, new_bytes, true);
+    }
+    const auto new_buf = arena->alloc(new_bytes, true);
+    ::memcpy(new_buf, buf, old_bytes);
+    return new_buf;
+}
+
+static void bench_grow(size_t iterations) {
+    const auto arena = OSThread::current()->resource_arena();
+    const char *const names[] = {"copy", "realloc"};
+    for (int use_realloc = 0; use_realloc <= 1; ++use_realloc) {
+        const auto recovered = arena->recovered_bytes();
+        Latency latency(iterations);
+        const auto begin = now();
+        for (size_t i = 0; i < iterations; ++i) {
+            const auto start = now();
+            {
+                ResourceArenaMark rm;
+                size_t bytes = 16;
+                auto buf = arena->alloc(bytes, true);
+                ::memset(buf, 0, bytes);
+                while (bytes < 16 * K) {
+                    buf = grow_buffer(arena, buf, bytes, bytes << 1, use_realloc);
+                    bytes <<= 1;
+                    //每次扩展之后都有一次小的申请 破坏最后一次申请的条件
+                    if ((bytes & 1023) == 0) {
+                        guarantee(arena->alloc(24, true) != nullptr, "arena alloc failed");
+                    }
+                }
+            }
+            latency.add(now() - start);
+        }
+        report(BENCH_NAME, "grow", names[use_realloc], 1, latency.count(), now() - begin, latency);
+        ::fprintf(stderr, "grow %s: recovered " SIZE_FORMAT " bytes\n",
+                  names[use_realloc], arena->recovered_bytes() - recovered);
+    }
+}
+
+static void bench_large(size_t iterations) {
+    static const size_t large_sizes[] = {48 * K, 256 * K, 1 * M};
+    static const char *const large_names[] = {"48k", "256k", "1m"};
+    const auto arena = OSThread::current()->resource_arena();
+    for (size_t s = 0; s < sizeof(large_sizes) / sizeof(size_t); ++s) {
+        Latency latency(iterations);
+        const auto begin = now();
+        for (size_t i = 0; i < iterations; ++i) {
+            const auto start = now();
+            {
+                ResourceArenaMark rm;
+                const auto p = (char *) arena->alloc(large_sizes[s], true);
+                //每页写入一次 包含提交物理内存的开销
+                for (size_t off = 0; off < large_sizes[s]; off += 4 * K) {
+                    p[off] = 1;
+                }
+            }
+            latency.add(now() - start);
+        }
+        report(BENCH_NAME, "large", large_names[s], 1, latency.count(), now() - begin, latency);
+    }
+    guarantee(arena->large_bytes() == 0, "large blocks must be released by rollback");
+}
+
+int main(int argc, char **argv) {
+    const auto iterations = bench::arg_or(argc, argv, 1, 200000);
+    const auto max_threads = (uint32_t) bench::arg_or(argc, argv, 2, MIN2<uint32_t>(os::avail_cpu_num(), 8));
+    bench::vm_initialize();
+    bench_resource_mark(iterations, max_threads);
+    bench_grow(iterations / 10);
+    bench_large(iterations / 100);
+    Arena::clean_pool();
+    Arena::print_pool_statistics(FileCharOStream::error_stream());
+    return 0;
+}
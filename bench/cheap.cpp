@@ -0,0 +1,154 @@
+//
+// Created by aurora on 2026/10/19.
+//
+/**
+ * 本地内存(CHeapObject)的基准测试
+ * 用法: BENCH_NMT=off|summary|detail BENCH_CHEAP=glibc|slab bench-cheap [iterations] [max_threads]
+ *
+ * 参数中依次带有内存追踪的级别 本地内存的后端 对象的大小
+ * 1 new_delete  申请并立即释放固定大小的CHeapObject 16 64 256 4096字节
+ *               1..N 个线程并发执行
+ *               用于比较不同的追踪级别下 每次申请和释放的额外开销
+ * 2 batch       先申请一批(256个)对象 再按照申请的顺序全部释放
+ *               释放时对象已经不在缓存中 读取头部的开销更加明显
+ * 3 churn       每个线程持有一个窗口(1024个)的存活对象 随机替换其中一个 大小在16~512字节之间
+ *               1..N 个线程并发执行 模拟虚拟机内部小对象的反复申请和释放
+ *
+ * 结束后将分级分配器的统计信息输出到标准错误
+ */
+#include <vector>
+#include "bench.hpp"
+#include "global/flag.hpp"
+#include "SlabAllocator.hpp"
+#include "plat/stream/FileCharOStream.hpp"
+
+using namespace bench;
+
+static const char *const BENCH_NAME = "cheap";
+
+template<size_t Bytes>
+class Payload : public CHeapObject<MEMFLAG::Internal> {
+public:
+    char _data[Bytes];
+};
+
+/**
+ * 每批申请的对象数量
+ */
+static const size_t BATCH = 256;
+
+/**
+ * churn 每个线程存活对象的数量
+ */
+static const size_t WINDOW = 1024;
+
+static void format_param(char *param, size_t len, size_t bytes) {
+    ::snprintf(param, len, "%s_%s_%lu", global::NMTLevel, global::CHeapBackend, (unsigned long) bytes);
+}
+
+struct CheapArgs {
+    size_t ops_per_thread;
+    Latency *latencies;
+};
+
+template<size_t Bytes>
+static void new_delete_worker(uint32_t index, void *arg) {
+    const auto args = (CheapArgs *) arg;
+    auto &latency = args->latencies[index];
+    for (size_t i = 0; i < args->ops_per_thread; ++i) {
+        const auto start = now();
+        auto p = new Payload<Bytes>();
+        p->_data[0] = (char) i;
+        delete p;
+        latency.add(now() - start);
+    }
+}
+
+template<size_t Bytes>
+static void bench_new_delete(size_t iterations, uint32_t max_threads) {
+    char param[64];
+    format_param(param, sizeof(param), Bytes);
+    for (uint32_t threads = 1; threads <= max_threads; threads = next_threads(threads, max_threads)) {
+        std::vector<Latency> latencies(threads);
+        CheapArgs args{iterations / threads, latencies.data()};
+        const auto elapsed = run_threads(threads, new_delete_worker<Bytes>, &args);
+        Latency all(iterations);
+        for (auto &latency: latencies) {
+            all.merge(latency);
+        }
+        report(BENCH_NAME, "new_delete", param, threads, all.count(), elapsed, all);
+    }
+}
+
+template<size_t Bytes>
+static void bench_batch(size_t iterations) {
+    char param[64];
+    format_param(param, sizeof(param), Bytes);
+    Payload<Bytes> *objects[BATCH];
+    const auto rounds = MAX2<size_t>(iterations / BATCH, 1);
+    Latency latency(rounds);
+    const auto begin = now();
+    for (size_t r = 0; r < rounds; ++r) {
+        const auto start = now();
+        for (auto &object: objects) {
+            object = new Payload<Bytes>();
+        }
+        for (auto object: objects) {
+            delete object;
+        }
+        latency.add(now() - start);
+    }
+    //每次操作是一对申请和释放
+    report(BENCH_NAME, "batch", param, 1, rounds * BATCH, now() - begin, latency);
+}
+
+static void churn_worker(uint32_t index, void *arg) {
+    const auto args = (CheapArgs *) arg;
+    auto &latency = args->latencies[index];
+    Random random(index + 1);
+    void *window[WINDOW];
+    for (auto &p: window) {
+        p = CHEAP_ALLOC(MEMFLAG::Internal, random.between(16, 512));
+    }
+    for (size_t i = 0; i < args->ops_per_thread; ++i) {
+        const auto slot = random.between(0, WINDOW - 1);
+        const auto bytes = random.between(16, 512);
+        const auto start = now();
+        CHEAP_FREE(MEMFLAG::Internal, window[slot]);
+        window[slot] = CHEAP_ALLOC(MEMFLAG::Internal, bytes);
+        latency.add(now() - start);
+    }
+    for (auto p: window) {
+        CHEAP_FREE(MEMFLAG::Internal, p);
+    }
+}
+
+static void bench_churn(size_t iterations, uint32_t max_threads) {
+    char param[64];
+    ::snprintf(param, sizeof(param), "%s_%s_16-512", global::NMTLevel, global::CHeapBackend);
+    for (uint32_t threads = 1; threads <= max_threads; threads = next_threads(threads, max_threads)) {
+        std::vector<Latency> latencies(threads);
+        CheapArgs args{iterations / threads, latencies.data()};
+        const auto elapsed = run_threads(threads, churn_worker, &args);
+        Latency all(iterations);
+        for (auto &latency: latencies) {
+            all.merge(latency);
+        }
+        report(BENCH_NAME, "churn", param, threads, all.count(), elapsed, all);
+    }
+}
+
+int main(int argc, char **argv) {
+    const auto iterations = bench::arg_or(argc, argv, 1, 200000);
+    const auto max_threads = (uint32_t) bench::arg_or(argc, argv, 2, 4);
+    bench::vm_initialize();
+    bench_new_delete<16>(iterations, max_threads);
+    bench_new_delete<64>(iterations, max_threads);
+    bench_new_delete<256>(iterations, max_threads);
+    bench_new_delete<4096>(iterations, max_threads);
+    bench_batch<64>(iterations);
+    bench_batch<4096>(iterations);
+    bench_churn(iterations, max_threads);
+    SlabAllocator::print_statistics(FileCharOStream::error_stream());
+    return 0;
+}
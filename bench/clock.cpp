@@ -0,0 +1,92 @@
+//
+// Created by aurora on 2026/10/19.
+//
+/**
+ * 时钟的基准测试
+ * 用法: bench-clock [iterations]
+ *
+ * 1 call    每次调用的耗时 连续调用一批后取平均 避免计时本身的开销
+ *           current_stamp        os::current_stamp 即CLOCK_REALTIME
+ *           monotonic_<source>   os::monotonic_stamp 来源由UseTSCClock以及硬件决定
+ *           clock_gettime        直接调用CLOCK_MONOTONIC 即退回时的开销
+ * 2 resync  os::clock_resync的耗时 并输出校准之后与CLOCK_MONOTONIC的偏差(stderr)
+ */
+#include "bench.hpp"
+#include "plat/os/time.hpp"
+#include <ctime>
+
+using namespace bench;
+
+static const char *const BENCH_NAME = "clock";
+
+/**
+ * 每个采样连续调用的次数
+ */
+static const size_t BATCH = 64;
+
+/**
+ * 防止编译器优化掉读取的结果
+ */
+static volatile ticks_t sink;
+
+static ticks_t clock_gettime_monotonic() {
+    struct ::timespec spec{};
+    ::clock_gettime(CLOCK_MONOTONIC, &spec);
+    return (ticks_t) spec.tv_sec * 1000000000 + spec.tv_nsec;
+}
+
+template<class F>
+static void run_call(const char *param, size_t iterations, F f) {
+    const auto samples = MAX2<size_t>(iterations / BATCH, 1);
+    Latency latency(samples);
+    ticks_t elapsed = 0;
+    for (size_t s = 0; s < samples; ++s) {
+        ticks_t value = 0;
+        const auto start = now();
+        for (size_t i = 0; i < BATCH; ++i) {
+            value += f();
+        }
+        const auto cost = now() - start;
+        sink = value;
+        latency.add(cost / BATCH);
+        elapsed += cost;
+    }
+    report(BENCH_NAME, "call", param, 1, samples * BATCH, elapsed, latency);
+}
+
+/**
+ * 手动校准若干次 每次之间间隔一段时间 观察TSC时钟与CLOCK_MONOTONIC的偏差
+ */
+static void run_resync(size_t rounds) {
+    Latency latency(rounds);
+    ticks_t elapsed = 0;
+    int64_t max_error = 0;
+    for (size_t r = 0; r < rounds; ++r) {
+        struct ::timespec spec{0, 10 * 1000 * 1000};
+        ::nanosleep(&spec, nullptr);
+        const auto start = now();
+        os::clock_resync();
+        const auto cost = now() - start;
+        latency.add(cost);
+        elapsed += cost;
+        const auto error = (int64_t) (os::monotonic_stamp() - clock_gettime_monotonic());
+        max_error = MAX2<int64_t>(max_error, error < 0 ? -error : error);
+    }
+    report(BENCH_NAME, "resync", os::clock_source_name(os::clock_source()), 1,
+           latency.count(), elapsed, latency);
+    ::fprintf(stderr, "clock %s: max error against CLOCK_MONOTONIC over %zu resyncs: %ld ns\n",
+              os::clock_source_name(os::clock_source()), rounds, (long) max_error);
+}
+
+int main(int argc, char **argv) {
+    const auto iterations = bench::arg_or(argc, argv, 1, 10000000);
+    bench::vm_initialize();
+
+    char param[32];
+    ::snprintf(param, sizeof(param), "monotonic_%s", os::clock_source_name(os::clock_source()));
+    run_call("current_stamp", iterations, os::current_stamp);
+    run_call(param, iterations, os::monotonic_stamp);
+    run_call("clock_gettime", iterations, clock_gettime_monotonic);
+    run_resync(50);
+    return 0;
+}
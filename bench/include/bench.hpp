@@ -0,0 +1,244 @@
+//
+// Created by aurora on 2026/10/19.
+//
+
+#ifndef BENCH_BENCH_HPP
+#define BENCH_BENCH_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <unistd.h>
+#include "stdtype.hpp"
+#include "global/flag.hpp"
+#include "plat/PlatInitialize.hpp"
+#include "plat/logger/LogOutput.hpp"
+#include "plat/logger/LogSingleFileOutput.hpp"
+#include "plat/stream/FileCharOStream.hpp"
+#include "plat/os/cpu.hpp"
+#include "plat/os/time.hpp"
+#include "kernel/KernelInitialize.hpp"
+#include "kernel/thread/LangThread.hpp"
+
+/**
+ * 基准测试的公共设施
+ *
+ * 每个用例输出一行 JSON(JSON Lines)到标准输出，日志仍然输出到标准错误
+ * {"bench":..,"case":..,"param":..,"threads":..,"ops":..,"ops_per_sec":..,
+ *  "p50_ns":..,"p99_ns":..,"p999_ns":..,"max_ns":..}
+ * 便于脚本收集并与历史结果比较
+ */
+namespace bench {
+    /**
+     * 单调时钟 单位纳秒
+     */
+    inline ticks_t now() {
+        return (ticks_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * 固定种子的伪随机数 保证多次运行的输入一致
+     */
+    class Random {
+    private:
+        uint64_t _state;
+    public:
+        explicit Random(uint64_t seed) : _state(seed * 0x9E3779B97F4A7C15ULL + 1) {};
+
+        inline uint64_t next() {
+            auto x = this->_state;
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            this->_state = x;
+            return x;
+        };
+
+        /**
+         * [low,high] 区间内的数
+         */
+        inline size_t between(size_t low, size_t high) {
+            return low + this->next() % (high - low + 1);
+        };
+    };
+
+    /**
+     * 延迟采样 可以合并多个线程的采样
+     */
+    class Latency {
+    private:
+        std::vector<ticks_t> _samples;
+    public:
+        explicit Latency(size_t reserve = 0) {
+            this->_samples.reserve(reserve);
+        };
+
+        inline void add(ticks_t ns) {
+            this->_samples.push_back(ns);
+        };
+
+        inline void merge(const Latency &other) {
+            this->_samples.insert(this->_samples.end(),
+                                  other._samples.begin(),
+                                  other._samples.end());
+        };
+
+        [[nodiscard]] inline size_t count() const {
+            return this->_samples.size();
+        };
+
+        /**
+         * 计算百分位 调用前需要排序
+         * @param permille 千分位 例如 p99 为 990
+         */
+        [[nodiscard]] ticks_t percentile(uint32_t permille) const {
+            if (this->_samples.empty()) {
+                return 0;
+            }
+            auto index = (this->_samples.size() * permille) / 1000;
+            index = std::min(index, this->_samples.size() - 1);
+            return this->_samples[index];
+        };
+
+        void sort() {
+            std::sort(this->_samples.begin(), this->_samples.end());
+        };
+
+        void clear() {
+            this->_samples.clear();
+        };
+    };
+
+    /**
+     * 输出一个用例的结果
+     * @param bench 测试集名称
+     * @param name 用例名称
+     * @param param 用例参数 例如尺寸分布
+     * @param threads 线程数
+     * @param ops 操作次数
+     * @param elapsed_ns 墙上时间
+     * @param latency 延迟采样 会被排序
+     */
+    inline void report(const char *bench,
+                       const char *name,
+                       const char *param,
+                       uint32_t threads,
+                       size_t ops,
+                       ticks_t elapsed_ns,
+                       Latency &latency) {
+        latency.sort();
+        const double ops_per_sec = elapsed_ns == 0 ? 0 : (double) ops * 1e9 / (double) elapsed_ns;
+        ::printf("{\"bench\":\"%s\",\"case\":\"%s\",\"param\":\"%s\",\"threads\":%u,"
+                 "\"ops\":%zu,\"elapsed_ns\":%lu,\"ops_per_sec\":%.1f,"
+                 "\"p50_ns\":%lu,\"p99_ns\":%lu,\"p999_ns\":%lu,\"max_ns\":%lu}\n",
+                 bench, name, param, threads,
+                 (size_t) ops, (unsigned long) elapsed_ns, ops_per_sec,
+                 (unsigned long) latency.percentile(500),
+                 (unsigned long) latency.percentile(990),
+                 (unsigned long) latency.percentile(999),
+                 (unsigned long) latency.percentile(1000));
+        ::fflush(stdout);
+    }
+
+    /**
+     * 执行测试函数的线程
+     * 需要是 OSThread 才能使用虚拟机内部的锁
+     */
+    class Worker : public LangThread {
+    public:
+        typedef void (*Func)(uint32_t index, void *arg);
+    private:
+        Func const _func;
+        void *const _arg;
+        const uint32_t _index;
+    protected:
+        void run() override {
+            this->_func(this->_index, this->_arg);
+        };
+    public:
+        Worker(Func func, void *arg, uint32_t index) :
+                LangThread(),
+                _func(func),
+                _arg(arg),
+                _index(index) {};
+
+        const char *name() override {
+            return "BenchWorker";
+        };
+    };
+
+    /**
+     * 启动 threads 个线程执行 func 并等待全部结束
+     * @return 墙上时间
+     */
+    inline ticks_t run_threads(uint32_t threads, Worker::Func func, void *arg) {
+        std::vector<Worker *> workers;
+        const auto start = now();
+        for (uint32_t i = 0; i < threads; ++i) {
+            auto worker = new Worker(func, arg, i);
+            guarantee(os::create_thread(worker, false), "create bench thread failed");
+            workers.push_back(worker);
+        }
+        for (auto worker: workers) {
+            //线程ID在线程内部设置 需要等待线程结束后才能join
+            while (worker->state() != OSThread::STATE_ZOMBIE) {
+                ::usleep(100);
+            }
+            os::join_thread(worker);
+        }
+        return now() - start;
+    }
+
+    /**
+     * 线程数按照1 2 4 ...递增 保证最后一轮恰好是max_threads
+     * for (uint32_t t = 1; t <= max_threads; t = next_threads(t, max_threads))
+     */
+    inline uint32_t next_threads(uint32_t threads, uint32_t max_threads) {
+        if ((threads << 1) > max_threads && threads < max_threads) {
+            return max_threads;
+        }
+        return threads << 1;
+    }
+
+    /**
+     * 解析命令行中的正整数 不存在时返回默认值
+     */
+    inline size_t arg_or(int argc, char **argv, int index, size_t default_value) {
+        if (index < argc) {
+            const auto value = ::strtoull(argv[index], nullptr, 10);
+            if (value > 0) {
+                return value;
+            }
+        }
+        return default_value;
+    }
+
+    /**
+     * 初始化虚拟机 日志只输出警告以上的级别
+     * 内存追踪默认关闭 可以通过环境变量 BENCH_NMT=off|summary|detail 指定
+     * 本地内存的后端默认glibc 可以通过环境变量 BENCH_CHEAP=glibc|slab 指定
+     * detail级别下追踪文件的格式默认compact 可以通过环境变量 BENCH_NMT_FORMAT=raw|compact 指定
+     * 撤销提交的默认方式为protect 可以通过环境变量 BENCH_UNCOMMIT=protect|dontneed|free 指定
+     */
+    inline void vm_initialize() {
+        const auto nmt = ::getenv("BENCH_NMT");
+        global::NMTLevel = nmt != nullptr ? nmt : "off";
+        const auto cheap = ::getenv("BENCH_CHEAP");
+        global::CHeapBackend = cheap != nullptr ? cheap : "glibc";
+        const auto format = ::getenv("BENCH_NMT_FORMAT");
+        global::NMTTraceFormat = format != nullptr ? format : "compact";
+        const auto uncommit = ::getenv("BENCH_UNCOMMIT");
+        global::UncommitStrategy = uncommit != nullptr ? uncommit : "protect";
+        static LogSingleFileOutput quiet(LogLevel::warn,
+                                         LogLayout::Default,
+                                         FileCharOStream::default_stream());
+        LogOutput::register_global(&quiet);
+        PlatInitialize::initialize(os::current_stamp(), new LangThread());
+        KernelInitialize::initialize();
+    }
+}
+
+#endif //BENCH_BENCH_HPP
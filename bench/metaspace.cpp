@@ -0,0 +1,560 @@
+//
+// Created by aurora on 2026/10/19.
+//
+/**
+ * 元空间的基准测试
+ * 用法: bench-metaspace [iterations] [max_threads]
+ *
+ * 1 arena_allocate/arena_deallocate  metaspace::Arena 在不同尺寸分布下的分配与回收
+ * 2 get_segment/return_segment        ContextHolder 获取与归还内存块
+ * 3 enlarge_segment                   ContextHolder::attempt_enlarge_segment
+ * 4 purge                             ContextHolder::purge 使用UncommitStrategy指定的方式
+ * 5 uncommit/uncommit_batch          交替撤销与重新提交提交粒度 比较各种撤销方式的耗时与映射(VMA)的个数
+ * 6 mt_private/mt_shared             1..N 个线程并发使用 MetaspaceArena
+ *                                     private 每个线程一个Arena 竞争元空间锁
+ *                                     shared  所有线程共享一个Arena 竞争Arena的锁
+ * 7 archive_build/archive_map/archive_map_relocated
+ *                                     在boot arena中构造一个符号表 与映射归档得到同样的符号表相比较
+ *                                     归档由另一个进程(环境变量BENCH_ARCHIVE_DUMP)写出
+ *                                     第一次映射使用归档时的地址 之后的映射需要重定位
+ */
+#include "bench.hpp"
+#include "Metaspace.hpp"
+#include "Arena.hpp"
+#include "ContextHolder.hpp"
+#include "Segment.hpp"
+#include "kernel/memory/MetaspaceArena.hpp"
+#include "kernel/memory/MetaspaceArchive.hpp"
+#include "kernel/metaspace/constants.hpp"
+#include "plat/thread/Mutex.hpp"
+#include "plat/os/mem.hpp"
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <sys/wait.h>
+
+using namespace bench;
+
+static const char *const BENCH_NAME = "metaspace";
+
+/**
+ * 请求尺寸的分布
+ */
+struct SizeDistribution {
+    const char *name;
+    size_t min_bytes;
+    size_t max_bytes;
+};
+
+static const SizeDistribution DISTRIBUTIONS[] = {
+        {"tiny_8_64",     8,    64},
+        {"small_64_512",  64,   512},
+        {"medium_512_4k", 512,  4 * K},
+        {"large_4k_64k",  4 * K, 64 * K},
+};
+
+static metaspace::SegmentLevel g_standard_levels[] = {
+        metaspace::SegmentLevel::LV_4K,
+        metaspace::SegmentLevel::LV_4K,
+        metaspace::SegmentLevel::LV_4K,
+        metaspace::SegmentLevel::LV_8K,
+        metaspace::SegmentLevel::LV_16K
+};
+static metaspace::ArenaGrowthPolicy g_standard_policy(g_standard_levels,
+                                           sizeof(g_standard_levels) / sizeof(metaspace::SegmentLevel));
+
+/**
+ * 每个用例结束后释放已提交的内存 避免达到元空间的GC阈值
+ */
+static void purge_between_cases() {
+    metaspace::ContextHolder::context()->purge();
+}
+
+/**
+ * @return 进程的映射(VMA)的个数 即/proc/self/maps的行数
+ */
+static size_t count_mappings() {
+    const auto file = ::fopen("/proc/self/maps", "r");
+    if (file == nullptr) {
+        return 0;
+    }
+    size_t lines = 0;
+    char buf[4096];
+    size_t n;
+    while ((n = ::fread(buf, 1, sizeof(buf), file)) > 0) {
+        for (size_t i = 0; i < n; ++i) {
+            lines += buf[i] == '\n';
+        }
+    }
+    ::fclose(file);
+    return lines;
+}
+
+/**
+ * bench_arena中存活的字节数的上限 大约一半的申请一直存活 不可以超过MetaspaceSize
+ */
+static constexpr size_t ArenaLiveBudget = 256 * M;
+
+static void bench_arena(size_t iterations) {
+    for (const auto &dist: DISTRIBUTIONS) {
+        //尺寸较大的分布减少次数
+        const auto num = MIN2<size_t>(iterations, 2 * ArenaLiveBudget / ((dist.min_bytes + dist.max_bytes) / 2));
+        Random random(1);
+        std::vector<std::pair<void *, size_t>> live;
+        live.reserve(num);
+        Latency alloc_latency(num);
+        Latency free_latency(num / 2);
+        auto arena = new metaspace::Arena(&g_standard_policy);
+        ticks_t alloc_elapsed = 0;
+        ticks_t free_elapsed = 0;
+        for (size_t i = 0; i < num; ++i) {
+            const auto bytes = random.between(dist.min_bytes, dist.max_bytes);
+            const auto start = now();
+            const auto p = arena->allocate(bytes);
+            const auto cost = now() - start;
+            guarantee(p != nullptr, "metaspace allocate failed");
+            alloc_latency.add(cost);
+            alloc_elapsed += cost;
+            live.emplace_back(p, bytes);
+            //每分配两次 随机归还一次 使BlockManager参与其中
+            if ((i & 1) == 1) {
+                const auto index = random.next() % live.size();
+                const auto victim = live[index];
+                live[index] = live.back();
+                live.pop_back();
+                const auto free_start = now();
+                arena->deallocate(victim.first, victim.second);
+                const auto free_cost = now() - free_start;
+                free_latency.add(free_cost);
+                free_elapsed += free_cost;
+            }
+        }
+        delete arena;
+        purge_between_cases();
+        report(BENCH_NAME, "arena_allocate", dist.name, 1,
+               alloc_latency.count(), alloc_elapsed, alloc_latency);
+        report(BENCH_NAME, "arena_deallocate", dist.name, 1,
+               free_latency.count(), free_elapsed, free_latency);
+    }
+}
+
+static void bench_segment(size_t iterations) {
+    const auto context = metaspace::ContextHolder::context();
+    const metaspace::SegmentLevel levels[] = {
+            metaspace::SegmentLevel::LV_4K,
+            metaspace::SegmentLevel::LV_64K,
+            metaspace::SegmentLevel::LV_1M
+    };
+    const char *const level_names[] = {"4k", "64k", "1m"};
+    constexpr size_t batch = 64;
+    metaspace::Segment *segments[batch];
+    for (size_t l = 0; l < sizeof(levels) / sizeof(metaspace::SegmentLevel); ++l) {
+        const auto level = levels[l];
+        const auto rounds = MAX2<size_t>(iterations / batch / 16, 1);
+        Latency get_latency(rounds * batch);
+        Latency return_latency(rounds * batch);
+        ticks_t get_elapsed = 0;
+        ticks_t return_elapsed = 0;
+        for (size_t r = 0; r < rounds; ++r) {
+            for (auto &segment: segments) {
+                const auto start = now();
+                segment = context->get_segment(level, level, metaspace::MetaAlignedBytes);
+                const auto cost = now() - start;
+                guarantee(segment != nullptr, "get segment failed");
+                get_latency.add(cost);
+                get_elapsed += cost;
+            }
+            for (auto segment: segments) {
+                const auto start = now();
+                context->return_segment(segment);
+                const auto cost = now() - start;
+                return_latency.add(cost);
+                return_elapsed += cost;
+            }
+        }
+        purge_between_cases();
+        report(BENCH_NAME, "get_segment", level_names[l], 1,
+               get_latency.count(), get_elapsed, get_latency);
+        report(BENCH_NAME, "return_segment", level_names[l], 1,
+               return_latency.count(), return_elapsed, return_latency);
+    }
+}
+
+static void bench_enlarge(size_t iterations) {
+    const auto context = metaspace::ContextHolder::context();
+    const auto rounds = MAX2<size_t>(iterations / 16, 1);
+    Latency latency(rounds);
+    ticks_t elapsed = 0;
+    size_t success = 0;
+    for (size_t r = 0; r < rounds; ++r) {
+        const auto segment = context->get_segment(metaspace::SegmentLevel::LV_4K,
+                                                  metaspace::SegmentLevel::LV_4K,
+                                                  metaspace::MetaAlignedBytes);
+        guarantee(segment != nullptr, "get segment failed");
+        const auto start = now();
+        if (context->attempt_enlarge_segment(segment)) {
+            ++success;
+        }
+        const auto cost = now() - start;
+        latency.add(cost);
+        elapsed += cost;
+        context->return_segment(segment);
+    }
+    purge_between_cases();
+    char param[32];
+    ::snprintf(param, sizeof(param), "success_%zu", success);
+    report(BENCH_NAME, "enlarge_segment", param, 1, latency.count(), elapsed, latency);
+}
+
+static void bench_purge(size_t iterations) {
+    const auto context = metaspace::ContextHolder::context();
+    const auto rounds = MAX2<size_t>(iterations / 1024, 4);
+    Latency latency(rounds);
+    ticks_t elapsed = 0;
+    Random random(2);
+    const auto mappings_before = count_mappings();
+    for (size_t r = 0; r < rounds; ++r) {
+        //先分配一批内存 然后归还 使得空闲块持有已提交内存
+        auto arena = new metaspace::Arena(&g_standard_policy);
+        for (size_t i = 0; i < 1024; ++i) {
+            guarantee(arena->allocate(random.between(64, 4 * K)) != nullptr,
+                      "metaspace allocate failed");
+        }
+        delete arena;
+        const auto start = now();
+        context->purge();
+        const auto cost = now() - start;
+        latency.add(cost);
+        elapsed += cost;
+    }
+    char param[64];
+    ::snprintf(param, sizeof(param), "1024_allocs_%s",
+               os::uncommit_type_name(os::default_uncommit_type()));
+    report(BENCH_NAME, "purge", param, 1, latency.count(), elapsed, latency);
+    ::fprintf(stderr, "purge %s: mappings " SIZE_FORMAT " -> " SIZE_FORMAT "\n",
+              param, mappings_before, count_mappings());
+}
+
+/**
+ * 直接在一段保留的空间上交替撤销与重新提交 每种方式显式指定 不受UncommitStrategy影响
+ * uncommit       逐个撤销奇数位置的提交粒度 每次撤销都不相邻
+ * uncommit_batch 通过UncommitBatch撤销全部的提交粒度 相邻的区间合并成一次调用
+ */
+static void bench_uncommit(size_t iterations) {
+    static const os::UncommitType types[] = {
+            os::UncommitType::protect,
+            os::UncommitType::dontneed,
+            os::UncommitType::free
+    };
+    const auto bytes = metaspace::VolumeDefaultBytes;
+    const auto granules = bytes / metaspace::CommitGranuleBytes;
+    const auto rounds = MAX2<size_t>(iterations / 16 / granules, 2);
+    for (const auto type: types) {
+        const auto name = os::uncommit_type_name(type);
+        const auto base = (char *) os::reserve_memory(MEMFLAG::Metaspace, bytes);
+        guarantee(base != nullptr, "reserve memory failed");
+        const auto mappings_before = count_mappings();
+        size_t mappings_after = 0;
+        Latency latency(rounds * granules / 2);
+        ticks_t elapsed = 0;
+        Latency batch_latency(rounds);
+        ticks_t batch_elapsed = 0;
+        size_t batch_calls = 0;
+        for (size_t r = 0; r < rounds; ++r) {
+            guarantee(os::commit_memory(MEMFLAG::Metaspace, base, bytes, os::CommitType::rwx),
+                      "commit memory failed");
+            os::pretouch_memory(base, bytes);
+            for (size_t g = 1; g < granules; g += 2) {
+                const auto p = base + g * metaspace::CommitGranuleBytes;
+                const auto start = now();
+                guarantee(os::uncommit_memory(MEMFLAG::Metaspace, p, metaspace::CommitGranuleBytes, type),
+                          "uncommit memory failed");
+                const auto cost = now() - start;
+                latency.add(cost);
+                elapsed += cost;
+            }
+            mappings_after = count_mappings();
+            //重新提交 再以批量的方式撤销全部
+            guarantee(os::commit_memory(MEMFLAG::Metaspace, base, bytes, os::CommitType::rwx),
+                      "commit memory failed");
+            os::pretouch_memory(base, bytes);
+            const auto start = now();
+            os::UncommitBatch batch(MEMFLAG::Metaspace, type);
+            //从高地址到低地址加入 每次都与之前的区间相接
+            for (size_t g = granules; g > 0; --g) {
+                guarantee(batch.add(base + (g - 1) * metaspace::CommitGranuleBytes, metaspace::CommitGranuleBytes),
+                          "uncommit memory failed");
+            }
+            guarantee(batch.flush(), "uncommit memory failed");
+            const auto cost = now() - start;
+            batch_latency.add(cost);
+            batch_elapsed += cost;
+            batch_calls += batch.num_calls();
+        }
+        report(BENCH_NAME, "uncommit", name, 1, latency.count(), elapsed, latency);
+        report(BENCH_NAME, "uncommit_batch", name, 1, batch_latency.count(), batch_elapsed, batch_latency);
+        ::fprintf(stderr, "uncommit %s: mappings " SIZE_FORMAT " -> " SIZE_FORMAT
+                          ", batch " SIZE_FORMAT " granules in " SIZE_FORMAT " calls\n",
+                  name, mappings_before, mappings_after, rounds * granules, batch_calls);
+        guarantee(os::release_memory(MEMFLAG::Metaspace, base, bytes), "release memory failed");
+    }
+}
+
+/**
+ * 归档用例中的符号 名称紧随其后
+ */
+struct ArchiveSymbol {
+    ArchiveSymbol *next;
+    uint32_t hash;
+    uint32_t length;
+
+    inline char *name() {
+        return (char *) (this + 1);
+    };
+};
+
+/**
+ * 归档的根对象
+ */
+struct ArchiveTable {
+    size_t num_buckets;
+    size_t num_symbols;
+    ArchiveSymbol **buckets;
+};
+
+static constexpr size_t ARCHIVE_BUCKETS = 16 * K;
+
+static uint32_t archive_hash(const char *name, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i) {
+        hash = (hash ^ (uint8_t) name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * 在arena中构造符号表 slots不为空时记录需要重定位的指针槽位
+ */
+static ArchiveTable *build_archive_table(MetaspaceArena *arena, size_t num_symbols,
+                                         std::vector<void **> *slots) {
+    auto table = (ArchiveTable *) arena->allocate(sizeof(ArchiveTable));
+    guarantee(table != nullptr, "metaspace allocate failed");
+    table->num_buckets = ARCHIVE_BUCKETS;
+    table->num_symbols = num_symbols;
+    table->buckets = (ArchiveSymbol **) arena->allocate(ARCHIVE_BUCKETS * sizeof(ArchiveSymbol *));
+    guarantee(table->buckets != nullptr, "metaspace allocate failed");
+    char name[64];
+    for (size_t i = 0; i < num_symbols; ++i) {
+        const auto length = (size_t) ::snprintf(name, sizeof(name), "bench/archive/Symbol_%zu", i);
+        const auto symbol = (ArchiveSymbol *) arena->allocate(sizeof(ArchiveSymbol) + length);
+        guarantee(symbol != nullptr, "metaspace allocate failed");
+        symbol->hash = archive_hash(name, length);
+        symbol->length = (uint32_t) length;
+        ::memcpy(symbol->name(), name, length);
+        auto &bucket = table->buckets[symbol->hash & (ARCHIVE_BUCKETS - 1)];
+        symbol->next = bucket;
+        bucket = symbol;
+    }
+    if (slots != nullptr) {
+        slots->push_back((void **) &table->buckets);
+        for (size_t b = 0; b < ARCHIVE_BUCKETS; ++b) {
+            slots->push_back((void **) &table->buckets[b]);
+            for (auto symbol = table->buckets[b]; symbol != nullptr; symbol = symbol->next) {
+                slots->push_back((void **) &symbol->next);
+            }
+        }
+    }
+    return table;
+}
+
+/**
+ * 遍历符号表 检查符号的个数以及哈希值
+ * @return 所有哈希值的和
+ */
+static uint64_t walk_archive_table(ArchiveTable *table) {
+    uint64_t sum = 0;
+    size_t count = 0;
+    for (size_t b = 0; b < table->num_buckets; ++b) {
+        for (auto symbol = table->buckets[b]; symbol != nullptr; symbol = symbol->next) {
+            guarantee(archive_hash(symbol->name(), symbol->length) == symbol->hash &&
+                      (symbol->hash & (ARCHIVE_BUCKETS - 1)) == b, "archive table is broken");
+            sum += symbol->hash;
+            ++count;
+        }
+    }
+    guarantee(count == table->num_symbols, "archive table lost symbols");
+    return sum;
+}
+
+/**
+ * 由另一个进程写出归档 使得映射时首选的地址有机会可用
+ */
+static void dump_archive(const char *path, size_t num_symbols) {
+    Mutex lock("BenchArchive_lock");
+    auto arena = new MetaspaceArena(MetaspaceType::Boot, &lock);
+    std::vector<void **> slots;
+    const auto table = build_archive_table(arena, num_symbols, &slots);
+    guarantee(MetaspaceArchive::dump(path, arena, table, slots.data(), slots.size()),
+              "metaspace archive dump failed");
+    delete arena;
+}
+
+static void bench_archive(size_t iterations) {
+    const auto num_symbols = MAX2<size_t>(iterations / 2, 1024);
+    const auto rounds = MAX2<size_t>(iterations / 20000, 4);
+    char path[64];
+    ::snprintf(path, sizeof(path), "/tmp/bench-metaspace-%d.msa", (int) ::getpid());
+    char symbols_env[32];
+    ::snprintf(symbols_env, sizeof(symbols_env), "%zu", num_symbols);
+    const auto pid = ::fork();
+    if (pid == 0) {
+        ::setenv("BENCH_ARCHIVE_DUMP", path, 1);
+        ::setenv("BENCH_ARCHIVE_SYMBOLS", symbols_env, 1);
+        ::execl("/proc/self/exe", "bench-metaspace", (char *) nullptr);
+        ::_exit(127);
+    }
+    int status = 0;
+    guarantee(pid > 0 && ::waitpid(pid, &status, 0) == pid &&
+              WIFEXITED(status) && WEXITSTATUS(status) == 0, "metaspace archive dump process failed");
+    Mutex lock("BenchArchive_lock");
+    char param[32];
+    ::snprintf(param, sizeof(param), "%zu_symbols", num_symbols);
+    //从头构造
+    Latency build_latency(rounds);
+    ticks_t build_elapsed = 0;
+    ticks_t build_walk = 0;
+    uint64_t expect = 0;
+    for (size_t r = 0; r < rounds; ++r) {
+        const auto start = now();
+        auto arena = new MetaspaceArena(MetaspaceType::Boot, &lock);
+        const auto table = build_archive_table(arena, num_symbols, nullptr);
+        const auto cost = now() - start;
+        build_latency.add(cost);
+        build_elapsed += cost;
+        const auto walk_start = now();
+        expect = walk_archive_table(table);
+        build_walk += now() - walk_start;
+        delete arena;
+    }
+    //第一次映射使用归档时的地址 之后该地址已被占用 需要重定位
+    Latency map_latency(1);
+    Latency relocated_latency(rounds);
+    ticks_t map_elapsed = 0;
+    ticks_t relocated_elapsed = 0;
+    ticks_t map_walk = 0;
+    size_t relocated_walk = 0;
+    for (size_t r = 0; r <= rounds; ++r) {
+        void *root = nullptr;
+        const auto start = now();
+        const auto arena = MetaspaceArchive::map(path, &lock, &root);
+        const auto cost = now() - start;
+        guarantee(arena != nullptr, "metaspace archive map failed");
+        const auto walk_start = now();
+        guarantee(walk_archive_table((ArchiveTable *) root) == expect, "metaspace archive mismatch");
+        const auto walk = now() - walk_start;
+        if (r == 0) {
+            map_latency.add(cost);
+            map_elapsed = cost;
+            map_walk = walk;
+        } else {
+            relocated_latency.add(cost);
+            relocated_elapsed += cost;
+            relocated_walk += walk;
+        }
+        delete arena;
+    }
+    ::unlink(path);
+    purge_between_cases();
+    report(BENCH_NAME, "archive_build", param, 1, build_latency.count(), build_elapsed, build_latency);
+    report(BENCH_NAME, "archive_map", param, 1, map_latency.count(), map_elapsed, map_latency);
+    report(BENCH_NAME, "archive_map_relocated", param, 1,
+           relocated_latency.count(), relocated_elapsed, relocated_latency);
+    ::fprintf(stderr, "archive %s: walk after build %.1fus, after map %.1fus, after relocated map %.1fus\n",
+              param, (double) build_walk / rounds / 1000, (double) map_walk / 1000,
+              (double) relocated_walk / rounds / 1000);
+}
+
+/**
+ * 多线程用例的共享参数
+ */
+struct ContentionArgs {
+    MetaspaceArena *shared;
+    size_t ops_per_thread;
+    Latency *latencies;
+};
+
+static void contention_worker(uint32_t index, void *arg) {
+    const auto args = (ContentionArgs *) arg;
+    Random random(index + 10);
+    Mutex *private_lock = nullptr;
+    auto arena = args->shared;
+    if (arena == nullptr) {
+        private_lock = new Mutex("BenchArena_lock");
+        arena = new MetaspaceArena(MetaspaceType::Standard, private_lock);
+    }
+    auto &latency = args->latencies[index];
+    for (size_t i = 0; i < args->ops_per_thread; ++i) {
+        const auto bytes = random.between(8, 512);
+        const auto start = now();
+        const auto p = arena->allocate(bytes);
+        latency.add(now() - start);
+        guarantee(p != nullptr, "metaspace allocate failed");
+    }
+    if (private_lock != nullptr) {
+        delete arena;
+        delete private_lock;
+    }
+}
+
+static void bench_contention(size_t iterations, uint32_t max_threads) {
+    for (int shared = 0; shared <= 1; ++shared) {
+        for (uint32_t threads = 1; threads <= max_threads; threads = next_threads(threads, max_threads)) {
+            std::vector<Latency> latencies(threads);
+            ContentionArgs args{};
+            args.ops_per_thread = iterations / threads;
+            args.latencies = latencies.data();
+            Mutex *shared_lock = nullptr;
+            if (shared) {
+                shared_lock = new Mutex("BenchArena_lock");
+                args.shared = new MetaspaceArena(MetaspaceType::Standard, shared_lock);
+            }
+            const auto elapsed = run_threads(threads, contention_worker, &args);
+            if (shared) {
+                delete args.shared;
+                delete shared_lock;
+            }
+            purge_between_cases();
+            Latency all(iterations);
+            for (auto &latency: latencies) {
+                all.merge(latency);
+            }
+            report(BENCH_NAME, shared ? "mt_shared" : "mt_private", "8_512", threads,
+                   all.count(), elapsed, all);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    const auto iterations = bench::arg_or(argc, argv, 1, 200000);
+    const auto max_threads = (uint32_t) bench::arg_or(argc, argv, 2, MIN2<uint32_t>(os::avail_cpu_num(), 8));
+    //基准测试不触发元空间GC 放宽阈值
+    global::MetaspaceSize = 1 * G;
+    bench::vm_initialize();
+    metaspace::Metaspace::ergo_initialize();
+    metaspace::Metaspace::global_initialize();
+    metaspace::Metaspace::post_initialize();
+
+    const auto archive = ::getenv("BENCH_ARCHIVE_DUMP");
+    if (archive != nullptr) {
+        dump_archive(archive, ::strtoull(::getenv("BENCH_ARCHIVE_SYMBOLS"), nullptr, 10));
+        return 0;
+    }
+    bench_archive(iterations);
+    bench_arena(iterations);
+    bench_segment(iterations);
+    bench_enlarge(iterations);
+    bench_purge(iterations);
+    bench_uncommit(iterations);
+    bench_contention(iterations, max_threads);
+    return 0;
+}
@@ -0,0 +1,101 @@
+//
+// Created by aurora on 2026/10/19.
+//
+/**
+ * 标准容器基于快速内存的基准测试
+ * 用法: bench-pmr [iterations]
+ *
+ * 1 vector_push  构造容器 依次追加N个元素 然后析构 N = 16 256 4096
+ *                std_vector        std::vector 经过malloc
+ *                pmr_arena         std::pmr::vector 使用独立的Arena 每次结束后回滚
+ *                pmr_resource      std::pmr::vector 使用 ResourceMemoryResource
+ *                growable_resource GrowableArray 使用resource arena
+ */
+#include <vector>
+#include <memory_resource>
+#include "bench.hpp"
+#include "plat/mem/ArenaMemoryResource.hpp"
+#include "kernel/utils/GrowableArray.hpp"
+
+using namespace bench;
+
+static const char *const BENCH_NAME = "pmr";
+
+static const int32_t ELEMENT_COUNTS[] = {16, 256, 4096};
+
+/**
+ * 防止编译器优化掉容器的操作
+ */
+static volatile int64_t sink;
+
+template<typename Func>
+static void run_case(const char *container, int32_t count, size_t iterations, Func func) {
+    Latency latency(iterations);
+    const auto begin = now();
+    for (size_t i = 0; i < iterations; ++i) {
+        const auto start = now();
+        sink = func(count);
+        latency.add(now() - start);
+    }
+    const auto elapsed = now() - begin;
+    char param[64];
+    ::snprintf(param, sizeof(param), "%s_%d", container, count);
+    report(BENCH_NAME, "vector_push", param, 1, latency.count(), elapsed, latency);
+}
+
+static int64_t std_vector(int32_t count) {
+    std::vector<int64_t> v;
+    for (int64_t i = 0; i < count; ++i) {
+        v.push_back(i);
+    }
+    return v.back();
+}
+
+static int64_t pmr_resource(int32_t count) {
+    ResourceMemoryResource resource;
+    std::pmr::vector<int64_t> v(&resource);
+    for (int64_t i = 0; i < count; ++i) {
+        v.push_back(i);
+    }
+    return v.back();
+}
+
+static int64_t growable_resource(int32_t count) {
+    ResourceArenaMark rm;
+    GrowableArray<int64_t> v;
+    for (int64_t i = 0; i < count; ++i) {
+        v.append(i);
+    }
+    return v.top();
+}
+
+static void bench_vector_push(size_t iterations) {
+    Arena arena(MEMFLAG::Internal);
+    ArenaMemoryResource arena_resource(&arena);
+    for (auto count: ELEMENT_COUNTS) {
+        const auto n = MAX2<size_t>(iterations * 16 / count, 100);
+        run_case("std_vector", count, n, std_vector);
+        run_case("pmr_arena", count, n, [&](int32_t c) -> int64_t {
+            Arena::SavedData saved(&arena);
+            int64_t last;
+            {
+                std::pmr::vector<int64_t> v(&arena_resource);
+                for (int64_t i = 0; i < c; ++i) {
+                    v.push_back(i);
+                }
+                last = v.back();
+            }
+            saved.rollback_to(&arena);
+            return last;
+        });
+        run_case("pmr_resource", count, n, pmr_resource);
+        run_case("growable_resource", count, n, growable_resource);
+    }
+}
+
+int main(int argc, char **argv) {
+    const auto iterations = bench::arg_or(argc, argv, 1, 100000);
+    bench::vm_initialize();
+    bench_vector_push(iterations);
+    return 0;
+}
@@ -0,0 +1,94 @@
+//
+// Created by aurora on 2026/10/19.
+//
+/**
+ * 安全点的基准测试
+ * 用法: BENCH_VMTHREAD_SCHED=other|batch|fifo BENCH_INTERNAL_CPUS=<cpu list> bench-safepoint [iterations] [load_threads]
+ *
+ * 主线程反复提交一个在安全点执行的空操作(VM_Operation) 参数中带有VMThread的调度策略 内部线程绑定的CPU 以及干扰线程的数量
+ * 1 begin  从提交操作到VMThread在安全点中开始执行 包括唤醒VMThread以及安全点的同步
+ * 2 end    从操作执行完毕到提交者恢复运行 包括退出安全点以及唤醒提交者
+ *
+ * 干扰线程是不受虚拟机管理的普通线程(不参与安全点) 一直占用CPU 模拟繁忙的应用线程
+ * 先在没有干扰的情况下执行一轮 再在有干扰的情况下执行一轮
+ * fifo需要CAP_SYS_NICE 没有权限时VMThread保持other 并输出警告
+ */
+#include <pthread.h>
+#include "bench.hpp"
+#include "kernel/thread/VM_Operation.hpp"
+
+using namespace bench;
+
+static const char *const BENCH_NAME = "safepoint";
+
+/**
+ * 干扰线程是否应当退出
+ */
+static volatile bool stop_load = false;
+
+static void *load_main(void *) {
+    uint64_t x = 0;
+    while (!OrderAccess::load(&stop_load)) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    }
+    return (void *) x;
+}
+
+/**
+ * 记录在安全点中开始执行的时间
+ */
+class NopOperation : public VM_Operation {
+public:
+    ticks_t _evaluated = 0;
+
+    void doit() override {
+        this->_evaluated = now();
+    }
+
+    const char *name() override {
+        return "BenchNop";
+    }
+};
+
+static void run_round(size_t iterations, uint32_t load_threads) {
+    std::vector<pthread_t> loads(load_threads);
+    OrderAccess::store(&stop_load, false);
+    for (auto &load: loads) {
+        guarantee(::pthread_create(&load, nullptr, load_main, nullptr) == 0, "create load thread failed");
+    }
+    Latency begin(iterations);
+    Latency end(iterations);
+    const auto start = now();
+    for (size_t i = 0; i < iterations; ++i) {
+        NopOperation operation;
+        const auto requested = now();
+        VM_Operation::execute(&operation);
+        const auto resumed = now();
+        begin.add(operation._evaluated - requested);
+        end.add(resumed - operation._evaluated);
+    }
+    const auto elapsed = now() - start;
+    OrderAccess::store(&stop_load, true);
+    for (auto load: loads) {
+        ::pthread_join(load, nullptr);
+    }
+    char param[96];
+    ::snprintf(param, sizeof(param), "%s_cpus-%s_load%u", global::VMThreadSchedPolicy,
+               global::InternalThreadCpus[0] == '\0' ? "all" : global::InternalThreadCpus, load_threads);
+    report(BENCH_NAME, "begin", param, 1, iterations, elapsed, begin);
+    report(BENCH_NAME, "end", param, 1, iterations, elapsed, end);
+}
+
+int main(int argc, char **argv) {
+    const auto iterations = bench::arg_or(argc, argv, 1, 2000);
+    const auto sched = ::getenv("BENCH_VMTHREAD_SCHED");
+    global::VMThreadSchedPolicy = sched != nullptr ? sched : "other";
+    const auto cpus = ::getenv("BENCH_INTERNAL_CPUS");
+    global::InternalThreadCpus = cpus != nullptr ? cpus : "";
+    bench::vm_initialize();
+    const auto load_threads = (uint32_t) bench::arg_or(argc, argv, 2, 2 * os::avail_cpu_num());
+
+    run_round(iterations, 0);
+    run_round(iterations, load_threads);
+    return 0;
+}
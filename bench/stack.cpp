@@ -0,0 +1,86 @@
+//
+// Created by aurora on 2026/10/19.
+//
+/**
+ * 获取调用堆栈的基准测试
+ * 用法: bench-stack [iterations]
+ *
+ * 1 walk  先递归到固定的深度 然后获取 1..MAX_DEPTH 帧的调用堆栈
+ *         fp          沿着栈帧指针(需要开启FRAME_POINTER)
+ *         backtrace   使用backtrace
+ * 2 capture 开启获取时构造 NativeCallStack 的耗时 即内存追踪时每次申请的额外开销
+ */
+#include "bench.hpp"
+#include "plat/utils/NativeCallStack.hpp"
+
+using namespace bench;
+
+static const char *const BENCH_NAME = "stack";
+
+/**
+ * 获取堆栈之前递归的深度 保证栈帧数量足够
+ */
+static const int32_t RECURSION_DEPTH = 16;
+
+/**
+ * 防止编译器优化掉获取的结果
+ */
+static volatile uintptr_t sink;
+
+using Walker = int (*)(void **pcs, int max_depth, int skip);
+
+static void run_walk(const char *name, Walker walker, size_t iterations) {
+    for (int depth = 1; depth <= NativeCallStack::MAX_DEPTH; ++depth) {
+        void *pcs[NativeCallStack::MAX_DEPTH];
+        if (walker(pcs, depth, 0) < 0) {
+            //没有开启栈帧指针
+            return;
+        }
+        Latency latency(iterations);
+        const auto begin = now();
+        for (size_t i = 0; i < iterations; ++i) {
+            const auto start = now();
+            const auto count = walker(pcs, depth, 0);
+            latency.add(now() - start);
+            sink = (uintptr_t) pcs[count - 1];
+        }
+        const auto elapsed = now() - begin;
+        char param[64];
+        ::snprintf(param, sizeof(param), "%s_%d", name, depth);
+        report(BENCH_NAME, "walk", param, 1, latency.count(), elapsed, latency);
+    }
+}
+
+static void run_capture(size_t iterations) {
+    NativeCallStack::set_capture_enabled(true);
+    Latency latency(iterations);
+    const auto begin = now();
+    for (size_t i = 0; i < iterations; ++i) {
+        const auto start = now();
+        const NativeCallStack stack(0);
+        latency.add(now() - start);
+        sink = (uintptr_t) stack.top();
+    }
+    const auto elapsed = now() - begin;
+    report(BENCH_NAME, "capture", "native_call_stack", 1, latency.count(), elapsed, latency);
+}
+
+__attribute__((noinline))
+static void recurse(int32_t depth, size_t iterations) {
+    if (depth > 0) {
+        recurse(depth - 1, iterations);
+        //阻止尾调用优化 保留栈帧
+        sink = sink + 1;
+        return;
+    }
+    run_walk("fp", NativeCallStack::walk_frame_pointers, iterations);
+    run_walk("backtrace", NativeCallStack::walk_backtrace, iterations);
+    run_capture(iterations);
+}
+
+int main(int argc, char **argv) {
+    const auto iterations = bench::arg_or(argc, argv, 1, 100000);
+    bench::vm_initialize();
+    recurse(RECURSION_DEPTH, iterations);
+    return 0;
+}
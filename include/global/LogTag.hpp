@@ -8,7 +8,10 @@
 #define LOG_TAG_LIST(def)   \
     def(safepoint)          \
     def(vmthread)           \
+    def(thread)             \
     def(metaspace)          \
+    def(nmt)                \
+    def(pressure)           \
     def(gc)
 
 enum class LogTag:uint16_t {
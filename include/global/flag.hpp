@@ -24,6 +24,22 @@ namespace global {
     product(const char* ,ErrorFilePath,"/tmp/demo.log","致命错误输出到文件") \
     product(const char *,NMTLevel,"detail","内存追踪模式。off不开启,summary记录基本信息,detail记录详细信息")                              \
     product(const char *,NMTFilePath,"/tmp/os_memory.trace","本地内存追踪文件路径")\
+    product(const char *,NMTTraceFormat,"compact","详细内存追踪文件的格式。raw直接写出每条记录,compact使用堆栈字典和变长编码")\
+    product(uint32_t,NMTDiffInterval,0,"相对于基线输出内存变化的间隔(毫秒),0表示不开启")\
+    product(size_t,NMTDiffThreshold,64*K,"变化小于该字节数的内存类型和调用位置不输出")\
+    product(bool,PrintNMTStatistics,false,"虚拟机退出时输出本地内存追踪的汇总,需要开启内存追踪(summary或者detail)")\
+    product(const char *,CHeapBackend,"glibc","本地内存的申请方式。glibc使用malloc,slab使用按照尺寸分级的线程缓存分配器")\
+    product(const char *,ArenaLargePages,"off","快速内存单独映射的大块使用大页的方式。off不使用,thp建议透明大页,hugetlb使用预留的大页(不足时退回普通页)")\
+    product(const char *,UncommitStrategy,"protect","撤销内存提交的默认方式。protect重新映射为不可访问,dontneed立即释放页框但保留映射,free由内核在内存紧张时回收")\
+    product(uint32_t,MemoryPressureInterval,1000,"采样系统内存压力的间隔(毫秒),压力上升时回收缓存和空闲内存,0表示不开启")\
+    product(bool,UseTSCClock,true,"单调时钟直接读取时间戳计数器(TSC)。TSC不是恒定速率或者内核没有选用时自动退回CLOCK_MONOTONIC")\
+    product(uint32_t,ClockSyncInterval,1000,"使用CLOCK_MONOTONIC校准TSC时钟的间隔(毫秒),0表示不校准")\
+    product(bool,UseContainerSupport,true,"根据cgroup的CPU配额(cpu.max/cpu.cfs_quota_us)限制可用的CPU数量")\
+    product(const char *,InternalThreadCpus,"","VM内部线程(VMThread,PeriodicThread)绑定的CPU列表,例如\"0-1,4\",空表示不绑定")\
+    product(bool,ReserveInternalThreadCpus,false,"语言线程不使用InternalThreadCpus中的CPU,避免安全点期间内部线程被抢占")\
+    product(const char *,VMThreadSchedPolicy,"other","VMThread的调度策略。other普通分时调度,batch批处理调度,fifo实时调度(需要CAP_SYS_NICE)")\
+    product(const char *,PeriodicThreadSchedPolicy,"other","PeriodicThread的调度策略。取值同VMThreadSchedPolicy")\
+    product(int32_t,InternalThreadRealtimePriority,1,"内部线程使用fifo调度策略时的实时优先级(1-99)")\
     product(bool,OutputToStderr,true,"将输出到标准输出流")                               \
     product(bool,UseThreadPriority,true,"是否开启ThreadPriority")                       \
     product(int16_t ,ThreadPriority1,-1,"1对应到底层的线程优先级,-1表示默认")               \
@@ -47,6 +63,8 @@ namespace global {
     range(0,100)                                    \
     product(size_t,MaxMetaspaceExpansion, 4 * M  ,"GC的情况下,Metaspace的最大扩展(以字节为单位)") \
     product(size_t,MinMetaspaceExpansion,256 * K ,"Metaspace的最小扩展(以字节为单位)")                  \
+    product(const char *,MetaspaceLargePages,"off","元空间使用大页的方式。off不使用,thp建议透明大页,hugetlb由于提交粒度小于大页 按照thp处理")\
+    product(const char *,MetaspaceArchivePath,"","启动时以写时复制的方式映射的元空间归档文件,根加载器的arena从中恢复。空表示不使用,映射失败时从头构造")\
 
 
 
@@ -26,6 +26,10 @@ namespace KernelConstants {
      * Arena 清理的 间隔 5000ms
      */
     constexpr inline uint32_t PeriodicTaskArenaClearInterval = 500;
+    /**
+     * 内存追踪 线程缓冲区写出的间隔 100ms
+     */
+    constexpr inline uint32_t PeriodicTaskNMTDrainInterval = 10;
     constexpr inline uint32_t PeriodicNoRunTaskCheckInterval = 10;
 }
 
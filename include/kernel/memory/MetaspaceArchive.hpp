@@ -0,0 +1,65 @@
+//
+// Created by aurora on 2026/10/19.
+//
+
+#ifndef KERNEL_MEMORY_METASPACE_ARCHIVE_HPP
+#define KERNEL_MEMORY_METASPACE_ARCHIVE_HPP
+
+#include "stdtype.hpp"
+#include "plat/mem/AllStatic.hpp"
+
+class MetaspaceArena;
+
+class Mutex;
+
+/**
+ * 元空间的归档
+ *
+ * 将一个MetaspaceArena使用的内存块原样写入文件 启动时以写时复制(MAP_PRIVATE)的方式映射回来
+ * 不必重新构造其中的数据 只有被写到的页面才会复制
+ * 启动时映射的文件由MetaspaceArchivePath指定 映射的结果作为根加载器的arena(Metaspace::boot_arena)
+ *
+ * 文件的格式(本机字节序 只用于同一台机器上的同一个构建)
+ *   文件头   魔数 版本 页大小 RegionBytes CommitGranuleBytes 虚拟节点的大小
+ *           虚拟节点的首地址(首选的映射地址) 根对象的偏移 内存块的数量 重定位的数量
+ *   内存块   相对于虚拟节点的偏移 等级 已使用的字节 映射的字节 数据在文件中的偏移(按页对齐)
+ *   重定位   需要调整的指针槽位相对于虚拟节点的偏移
+ *   数据     每个内存块已使用的部分 按照提交粒度向上对齐
+ *
+ * 首选的地址无法保留时 映射到新的虚拟节点 再按照重定位信息调整指针(只会复制这些页面)
+ *
+ * 限制:
+ * 1) 所有的内存块必须位于同一个虚拟节点 且不小于提交粒度 映射时不会覆盖伙伴块
+ * 2) 只有显式标记的指针槽位会被重定位 指向归档之外的指针不允许存在
+ * 3) Arena中已经释放的内存(BlockManager)不会被归档 映射后成为内存块中的空洞
+ * 4) 映射期间归档文件不可以被覆盖或者截断
+ */
+class MetaspaceArchive : public AllStatic {
+public:
+    /**
+     * 将arena使用的内存块写入归档文件 调用期间arena不可以被修改
+     * @param path 归档文件的路径 已经存在的文件会被覆盖
+     * @param arena 需要归档的arena
+     * @param root 根对象 映射之后通过它访问归档中的数据 必须位于归档中
+     * @param slots 需要重定位的指针槽位 槽位必须位于归档中 指向归档中的地址或者为空
+     * @param num_slots 槽位的数量
+     * @return 是否成功 失败时输出日志
+     */
+    static bool dump(const char *path,
+                     MetaspaceArena *arena,
+                     void *root,
+                     void **const *slots,
+                     size_t num_slots);
+
+    /**
+     * 映射归档文件 重建元空间内部内存块的状态 返回的arena可以继续正常的申请和释放
+     * 文件校验失败时不会修改元空间的状态
+     * @param path 归档文件的路径
+     * @param lock 新的arena使用的锁
+     * @param root 输出 映射之后根对象的地址
+     * @return 失败返回nullptr
+     */
+    static MetaspaceArena *map(const char *path, Mutex *lock, void **root);
+};
+
+#endif //KERNEL_MEMORY_METASPACE_ARCHIVE_HPP
@@ -6,6 +6,7 @@
 #define NUCLEUSVM_METASPACEARENA_HPP
 
 #include "stdtype.hpp"
+#include "kernel/metaspace/ArenaUsage.hpp"
 
 namespace metaspace {
     class Arena;
@@ -21,6 +22,8 @@ enum class MetaspaceType {
 class MetaspaceArena {
     friend class Metaspace;
 
+    friend class MetaspaceArchive;
+
 private:
     metaspace::Arena *_arena;
     Mutex *const _mutex;
@@ -35,9 +38,11 @@ public:
 
     void deallocate(void *ptr, size_t bytes);
 
-    void usage_numbers(size_t *used_bytes,
-                       size_t *committed_bytes,
-                       size_t *capacity_bytes);
+    /**
+     * 统计使用情况以及内部浪费
+     * @param usage 输出的统计结果
+     */
+    void usage_numbers(metaspace::ArenaUsage *usage);
 };
 
 
@@ -0,0 +1,81 @@
+//
+// Created by aurora on 2026/10/19.
+//
+
+#ifndef KERNEL_METASPACE_ARENA_USAGE_HPP
+#define KERNEL_METASPACE_ARENA_USAGE_HPP
+
+#include "stdtype.hpp"
+
+class CharOStream;
+namespace metaspace {
+    /**
+     * 元空间Arena的使用情况以及内部浪费的统计
+     * 既可以表示单个Arena 也可以表示所有存活Arena的汇总
+     *
+     * used_bytes 与 Segment::used_bytes 的含义一致
+     * 即包含了已经归还到BlockManager中的内存 所以浪费是used_bytes的一部分
+     */
+    struct ArenaUsage {
+        /**
+         * 内存块中已经被切分出去的字节
+         */
+        size_t used_bytes;
+        /**
+         * 内存块已提交的字节
+         */
+        size_t committed_bytes;
+        /**
+         * 内存块的总容量
+         */
+        size_t capacity_bytes;
+        /**
+         * 由于最小尺寸和对齐(get_raw_byte_for_requested)而多分配的字节
+         * 仅统计仍然存活的分配
+         */
+        size_t align_waste_bytes;
+        /**
+         * 更换当前块时 旧块剩余的已提交内存被放入BlockManager的字节 累计值
+         */
+        size_t salvaged_bytes;
+        /**
+         * BlockManager中空闲而未被复用的字节 包括回收的尾部以及用户归还的内存
+         */
+        size_t free_block_bytes;
+
+        /**
+         * 已提交但是尚未被切分的字节
+         */
+        [[nodiscard]] inline size_t committed_unused_bytes() const {
+            return this->committed_bytes > this->used_bytes ?
+                   this->committed_bytes - this->used_bytes : 0;
+        };
+
+        /**
+         * 总的浪费
+         * 已提交未使用 + 空闲块 + 对齐
+         */
+        [[nodiscard]] inline size_t waste_bytes() const {
+            return this->committed_unused_bytes() +
+                   this->free_block_bytes +
+                   this->align_waste_bytes;
+        };
+
+        /**
+         * 累加另一个统计
+         * @param other
+         */
+        inline void add(const ArenaUsage &other) {
+            this->used_bytes += other.used_bytes;
+            this->committed_bytes += other.committed_bytes;
+            this->capacity_bytes += other.capacity_bytes;
+            this->align_waste_bytes += other.align_waste_bytes;
+            this->salvaged_bytes += other.salvaged_bytes;
+            this->free_block_bytes += other.free_block_bytes;
+        };
+
+        void print_on(CharOStream *out) const;
+    };
+}
+
+#endif //KERNEL_METASPACE_ARENA_USAGE_HPP
@@ -64,6 +64,29 @@ public:
      * 开启清除arena的定时任务
      */
     static void start_arena_clean_task();
+
+    /**
+     * 开启内存追踪缓冲区写出的定时任务
+     * 仅仅在NMT为detail级别时开启
+     */
+    static void start_nmt_drain_task();
+
+    /**
+     * 记录内存追踪的基线 然后开启按照NMTDiffInterval输出变化的定时任务
+     * 仅仅在NMT开启并且NMTDiffInterval不为0时开启
+     */
+    static void start_nmt_diff_task();
+
+    /**
+     * 开启按照MemoryPressureInterval采样系统内存压力的定时任务
+     * 见MemoryPressureMonitor
+     */
+    static void start_memory_pressure_task();
+
+    /**
+     * 单调时钟使用TSC时 开启按照ClockSyncInterval校准的定时任务
+     */
+    static void start_clock_sync_task();
 };
 
 
@@ -21,6 +21,12 @@ private:
 
     void remove_from_list();
 
+    /**
+     * 按照线程的种类设置CPU亲和性和调度策略 由线程自己在pre_run中调用
+     * 失败时只输出警告
+     */
+    void apply_placement();
+
 protected:
 
     void pre_run() override;
@@ -50,6 +56,12 @@ public:
     inline static void thread_do_user(ThreadClosure* closure){
         thread_do(&PlatThread::_user_thread_list,closure);
     }
+    /**
+     * 解析线程放置相关的参数 InternalThreadCpus 以及各类线程的调度策略
+     * 必须在创建内部线程之前调用
+     */
+    static void placement_initialize();
+
     template<typename T = PlatThread>
     static inline T *current() {
         assert(dynamic_cast<T *>(OSThread::current()) != nullptr, "cannot convert");
@@ -27,8 +27,8 @@ protected:
     int32_t _capacity;
 
     explicit FixedArray() :
-            _len(0),
             _data(nullptr),
+            _len(0),
             _capacity(0) {
     }
 
@@ -150,9 +150,9 @@ bool FixedArray<E>::push(E &e) {
 
 template<typename E>
 FixedArray<E>::FixedArray(E *data, int32_t capacity, int32_t len):
-        _capacity(capacity),
+        _data(data),
         _len(len),
-        _data(data) {}
+        _capacity(capacity) {}
 
 template<typename E>
 void GrowableArray<E>::expand_to(int32_t new_capacity) {
@@ -163,12 +163,15 @@ void GrowableArray<E>::expand_to(int32_t new_capacity) {
     //根据元数据的类型不同 从不同地方创建数组
     E *new_data;
     if (this->on_resource()) {
-        new_data = NEW_RESOURCE_ARRAY(E, new_capacity);
+        //快速内存上如果是最后一次申请 可以原地扩展 否则由realloc负责拷贝
+        this->_data = REALLOC_RESOURCE_ARRAY(E, this->_data, old_capacity, new_capacity);
+        return;
     } else if (this->on_native()) {
         new_data = NEW_CHEAP_ARRAY(E, new_capacity, this->mem_flag());
     } else {
         assert(this->on_arena(), "unknown meta value");
-        new_data = NEW_ARENA_ARRAY(this->arena(), E, new_capacity);
+        this->_data = REALLOC_ARENA_ARRAY(this->arena(), E, this->_data, old_capacity, new_capacity);
+        return;
     }
     //将旧的数据拷贝到新的上面
     memcpy(new_data, this->_data, sizeof(E) * this->_len);
@@ -196,15 +199,16 @@ GrowableArray<E>::~GrowableArray() {
 
 template<typename E>
 GrowableArray<E>::GrowableArray(Arena *arena, int32_t init_capacity):
-        _meta((uintptr_t) arena),
-        FixedArray<E>() {
+        FixedArray<E>(),
+        _meta((uintptr_t) arena) {
     assert((this->_meta & 1) == 0 && arena != nullptr, "must be");
     this->expand_to(init_capacity);
 }
 
 template<typename E>
 GrowableArray<E>::GrowableArray(MEMFLAG F, int32_t init_capacity):
-        _meta(uintptr_t(F) << 1 | 1), FixedArray<E>() {
+        FixedArray<E>(),
+        _meta(uintptr_t(F) << 1 | 1) {
     assert(F != MEMFLAG::None, "must be");
     this->expand_to(init_capacity);
 }
@@ -213,7 +217,8 @@ template<typename E>
 void GrowableArray<E>::append(E &e) {
     if (this->_len == this->_capacity) {
         assert(this->_capacity <= INT32_MAX,"OVERFLOW");
-        auto new_capacity = (int32_t)round_up_power_of_2((uint32_t)this->_capacity);
+        //容量已经是2的幂 需要+1才能扩大
+        auto new_capacity = (int32_t)round_up_power_of_2((uint32_t)this->_capacity + 1);
         assert(new_capacity <= INT32_MAX,"overflow");
         this->expand_to(new_capacity);
     }
@@ -6,6 +6,7 @@
 #define NUCLEUSVM_LINKEDLIST_HPP
 
 #include <concepts>
+#include "plat/utils/robust.hpp"
 
 /**
  * 链表节点的定义 需要存在这些函数
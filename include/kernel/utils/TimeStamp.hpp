@@ -30,6 +30,13 @@
             this->_ticks = os::current_stamp();
         };
 
+        /**
+         * 使用单调时钟更新计数器的值 只用于计算时间间隔
+         */
+        inline void update_monotonic_ticks() {
+            this->_ticks = os::monotonic_stamp();
+        };
+
         [[nodiscard]] auto get_sec() const {
             return this->_ticks / TicksPerS;
         };
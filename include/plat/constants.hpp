@@ -52,6 +52,12 @@ constexpr inline int32_t BitsPerByte = 1 << LogBitsPerByte;
 constexpr inline int32_t BitsPerWord = 1 << LogBitsPerWord;
 
 
+/**
+ * CPU缓存行的字节数
+ * 用于避免多个线程频繁修改的数据出现伪共享
+ */
+constexpr inline size_t CacheLineBytes = 64;
+
 static_assert(sizeof(size_t) == sizeof(long) &&
               sizeof(long) == BytesPerWord &&
               sizeof(void *) == BytesPerWord,
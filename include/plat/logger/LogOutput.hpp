@@ -68,7 +68,7 @@ public:
      * 注册全局的日志输出流
      * @param stream 全局的日志输出流
      */
-    static inline void register_global(LogOutput *stream);
+    static void register_global(LogOutput *stream);
 
 };
 
@@ -6,19 +6,54 @@
 #define PLATFORM_ARENA_HPP
 
 #include "allocation.hpp"
+#include "plat/os/mem.hpp"
 class ArenaChunk;
 
 /**
  * 支持快速分配内存的对象
  *
  * 内存分配的策略是
- * 如果当前块(Chunk)无法满足要求
- * 那么当前块(Chunk)的剩余内存全部抛弃,被视为已经使用
+ * 如果当前块(Chunk)无法满足要求 则申请新的内存块
+ * 旧内存块的剩余部分作为备用区域 后续较小的申请优先从备用区域中分配
+ * 备用区域同样无法满足的 才被视为已经使用
  *
+ * 不小于 DirectMapBytes 的申请不进入内存块链表
+ * 而是单独映射一段按页对齐的内存 记录在独立的链表中
+ * 释放 回滚或者析构时直接归还给操作系统
  */
 class Arena : public CHeapObject<MEMFLAG::Arena> {
     friend class ArenaMark;
+public:
+    /**
+     * 大于等于该值的申请 单独映射内存
+     * 按字宽对齐后第一个超过大块(ArenaChunk::large_bytes)的大小 新的内存块总是可以容纳更小的申请
+     */
+    constexpr inline static size_t DirectMapBytes = 32 * 1024 - 32;
 private:
+    /**
+     * 单独映射的内存的头部 位于映射的起始位置
+     */
+    struct LargeBlock {
+        LargeBlock *_next;
+        /**
+         * 映射的序号 单调递增 回滚时释放标记之后映射的内存
+         */
+        size_t _serial;
+        /**
+         * 整个映射的大小 按页对齐
+         */
+        size_t _mapped_bytes;
+
+        [[nodiscard]] inline void *payload() {
+            return this + 1;
+        };
+    };
+
+    /**
+     * 单独映射的内存使用大页的方式 由ArenaLargePages指定
+     */
+    static os::LargePageMode _large_page_mode;
+
     /**
      * 用于标记区分快速内存的类别
      */
@@ -34,6 +69,28 @@ private:
      */
     uintptr_t _top_literal;
     uintptr_t _end_literal;
+    /**
+     * 备用区域 之前内存块中剩余的尾部
+     * 同样使用指针碰撞的方式分配
+     */
+    uintptr_t _spare_top_literal;
+    uintptr_t _spare_end_literal;
+    /**
+     * 从备用区域中分配的字节 即回收的内存块尾部
+     */
+    size_t _recovered_bytes;
+    /**
+     * 单独映射的内存 新的位于头部
+     */
+    LargeBlock *_large_head;
+    /**
+     * 下一次单独映射的序号
+     */
+    size_t _large_serial;
+    /**
+     * 单独映射的内存总大小 包括头部
+     */
+    size_t _large_bytes;
     /**
      * 当前已经管理的内存大小
      * 包括申请还没有使用的
@@ -54,6 +111,62 @@ private:
 
     void new_chunk(size_t chunk_bytes, bool exit_oom);
 
+    /**
+     * 从备用区域中分配
+     * @param request 已经对齐
+     * @return 备用区域不足时返回nullptr
+     */
+    void *alloc_from_spare(size_t request);
+
+    /**
+     * 单独映射一段内存
+     * @param request 已经对齐
+     * @param exit_oom 映射失败时退出虚拟机
+     */
+    void *alloc_large(size_t request, bool exit_oom);
+
+    /**
+     * 按照大页的方式映射并提交内存
+     * 不小于大页的映射 hugetlb使用预留的大页 预留不足时退回普通页 thp按照大页对齐后建议使用透明大页
+     * 这两种情况下映射的大小向上对齐到大页
+     * @param mapped_bytes 按页对齐 返回实际映射的大小
+     * @return 失败时返回nullptr
+     */
+    void *map_large(size_t *mapped_bytes) const;
+
+    /**
+     * 释放序号不小于serial的单独映射的内存 即从某个时刻之后映射的
+     * @param serial
+     */
+    void release_large_since(size_t serial);
+
+    /**
+     * 从链表中摘除并释放一块单独映射的内存
+     * @param block 需要释放的内存
+     * @param prev 链表中的前一个 block位于头部时为nullptr
+     */
+    void release_large(LargeBlock *block, LargeBlock *prev);
+
+    /**
+     * 查找单独映射的内存
+     * @param ptr 申请时候获取的首地址
+     * @param prev 输出链表中的前一个
+     * @return 不存在时返回nullptr
+     */
+    LargeBlock *find_large(void *ptr, LargeBlock **prev) const;
+
+    /**
+     * 尝试原地调整上一次申请的内存
+     * @param top 当前区域已分配的结束地址
+     * @param end 当前区域的结束地址
+     * @return true 表示调整成功
+     */
+    static bool grow_in_place(uintptr_t ptr,
+                              size_t old_bytes,
+                              size_t new_bytes,
+                              uintptr_t *top,
+                              uintptr_t end);
+
     /**
      * 删除chunk节点和之后的所有节点
      * @param chunk
@@ -79,7 +192,11 @@ public:
         ArenaChunk *_tail;
         uintptr_t _top_literal;
         uintptr_t _end_literal;
+        uintptr_t _spare_top_literal;
+        uintptr_t _spare_end_literal;
         size_t _total_bytes;
+        size_t _large_serial;
+        size_t _large_bytes;
     public:
         explicit SavedData(Arena *arena);
 
@@ -120,7 +237,8 @@ public:
      * 快速内存释放函数
      *  释放的条件较为苛刻
      *  仅仅上一次申请的内存 才会真正的释放
-     *  并且也仅能释放当前内存块的
+     *  并且也仅能释放当前内存块或者备用区域的
+     *  单独映射的内存总是可以释放
      * @param ptr 申请时候获取的首地址
      * @param request 申请的大小
      * @return true 表示内存释放掉了
@@ -129,9 +247,47 @@ public:
     bool free(void *ptr, size_t request);
 
     /**
-     * 清除全部的内存池
+     * 调整内存的大小
+     * 如果ptr是当前区域(或备用区域)上一次申请的内存 并且剩余空间足够
+     * 那么直接原地调整 不需要拷贝
+     * 否则重新申请 拷贝原有的内容 并尽可能释放旧的内存
+     * @param ptr 申请时候获取的首地址 可以为nullptr
+     * @param old_bytes 原本申请的大小
+     * @param new_bytes 新的大小
+     * @param exit_oom 内存申请失败时退出虚拟机
+     * @return 新的首地址 失败返回nullptr 此时原有的内存不变
+     */
+    void *realloc(void *ptr, size_t old_bytes, size_t new_bytes, bool exit_oom);
+
+    /**
+     * @return 从之前内存块的尾部中回收利用的字节
+     */
+    [[nodiscard]] inline size_t recovered_bytes() const {
+        return this->_recovered_bytes;
+    };
+
+    /**
+     * @return 单独映射的内存大小
+     */
+    [[nodiscard]] inline size_t large_bytes() const {
+        return this->_large_bytes;
+    };
+
+    /**
+     * 解析单独映射的内存使用大页的方式
+     */
+    static void initialize();
+
+    /**
+     * 按照需求清理内存池 仅仅释放超出保留目标的内存块
      */
     static void clean_pool();
+
+    /**
+     * 输出内存池的命中 未命中 以及保留的统计信息
+     * @param out
+     */
+    static void print_pool_statistics(CharOStream *out);
 };
 
 
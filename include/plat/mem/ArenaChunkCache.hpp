@@ -0,0 +1,76 @@
+//
+// Created by aurora on 2026/10/19.
+//
+
+#ifndef PLATFORM_ARENA_CHUNK_CACHE_HPP
+#define PLATFORM_ARENA_CHUNK_CACHE_HPP
+
+#include "stdtype.hpp"
+
+class ArenaChunk;
+
+/**
+ * 线程私有的快速内存块缓存 位于全局内存池(ArenaChunkPool)之前
+ * 每种标准尺寸各有一个槽位，申请和归还都不需要加锁
+ *
+ * 槽位为空时 从全局内存池中批量获取
+ * 槽位已满时 批量归还一半到全局内存池
+ * 每个槽位最多缓存 CacheBytesPerSlot 字节 且至少2块
+ *
+ * 仅仅可以被所属的线程访问
+ */
+class ArenaChunkCache {
+public:
+    constexpr inline static int SlotCount = 4;
+    constexpr inline static size_t CacheBytesPerSlot = 64 * 1024;
+private:
+    ArenaChunk *_heads[SlotCount];
+    uint32_t _counts[SlotCount];
+
+    /**
+     * 槽位最多缓存的内存块数量
+     * @param slot 槽位
+     */
+    static uint32_t capacity_of(int slot);
+
+    /**
+     * 从全局内存池中批量获取
+     * @param slot 槽位
+     */
+    void refill(int slot);
+
+    /**
+     * 将count个内存块批量归还到全局内存池
+     * @param slot 槽位
+     * @param count 数量
+     */
+    void drain(int slot, uint32_t count);
+
+public:
+    explicit ArenaChunkCache();
+
+    ~ArenaChunkCache();
+
+    /**
+     * 申请一个标准尺寸的内存块
+     * @param chunk_bytes 内存块的可用空间
+     * @return 非标准尺寸或者全局内存池也为空时返回nullptr
+     */
+    ArenaChunk *alloc(size_t chunk_bytes);
+
+    /**
+     * 归还一个内存块
+     * @param chunk 内存块
+     * @return 非标准尺寸返回false 此时调用者应该自行释放
+     */
+    bool free(ArenaChunk *chunk);
+
+    /**
+     * 将所有缓存的内存块归还到全局内存池
+     * 线程退出时调用
+     */
+    void drain_all();
+};
+
+
+#endif //PLATFORM_ARENA_CHUNK_CACHE_HPP
@@ -0,0 +1,62 @@
+//
+// Created by aurora on 2026/10/19.
+//
+
+#ifndef PLATFORM_ARENA_MEMORY_RESOURCE_HPP
+#define PLATFORM_ARENA_MEMORY_RESOURCE_HPP
+
+#include <memory_resource>
+#include "plat/mem/Arena.hpp"
+#include "plat/thread/OSThread.hpp"
+
+/**
+ * 基于快速内存(Arena)的 std::pmr::memory_resource
+ * 使标准容器(std::pmr::vector等)可以使用指针碰撞的方式申请内存 而不经过malloc
+ *
+ * 释放仅仅对最后一次申请有效(参考 Arena::free)
+ * 其余的内存在Arena析构或者回滚时统一释放
+ * 因此容器的生命周期不能超过Arena
+ *
+ * 申请失败时直接退出虚拟机 不会抛出std::bad_alloc
+ */
+class ArenaMemoryResource : public std::pmr::memory_resource {
+private:
+    Arena *const _arena;
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+
+    [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+public:
+    explicit ArenaMemoryResource(Arena *arena);
+
+    [[nodiscard]] inline Arena *arena() const {
+        return this->_arena;
+    };
+};
+
+/**
+ * 基于当前线程 resource arena 的 memory_resource
+ * 构造时进行标记 析构时回滚 与 ResourceArenaMark 的作用域相同
+ *
+ * 使用该资源的容器必须在它之前析构
+ * 仅仅可以被创建它的线程使用
+ */
+class ResourceMemoryResource : public ArenaMemoryResource {
+private:
+    ResourceArenaMark _mark;
+public:
+    explicit ResourceMemoryResource();
+
+    /**
+     * 仅仅可以在栈上创建 虚析构函数要求operator delete存在 所以只禁止new
+     */
+    void *operator new(size_t size) = delete;
+
+    void *operator new[](size_t size) = delete;
+};
+
+
+#endif //PLATFORM_ARENA_MEMORY_RESOURCE_HPP
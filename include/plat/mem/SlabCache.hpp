@@ -0,0 +1,89 @@
+//
+// Created by aurora on 2026/10/19.
+//
+
+#ifndef PLATFORM_SLAB_CACHE_HPP
+#define PLATFORM_SLAB_CACHE_HPP
+
+#include "stdtype.hpp"
+#include "plat/mem/allocation.hpp"
+
+/**
+ * 线程私有的小对象缓存 位于分级分配器(SlabAllocator)的中央仓库之前
+ * 每个尺寸等级各有一个空闲链表，申请和释放都不需要加锁
+ *
+ * 链表为空时 从中央仓库批量获取
+ * 链表已满时 批量归还一半到中央仓库
+ * 每个等级最多缓存 CacheBytesPerClass 字节 且至少 MinCapacity 个
+ *
+ * 各个内存类型占用的字节数先累计在缓存中 与中央仓库交换时一起合并
+ *
+ * 仅仅可以被所属的线程访问
+ */
+class SlabCache {
+public:
+    constexpr inline static int ClassCount = 20;
+    constexpr inline static size_t CacheBytesPerClass = 16 * 1024;
+    constexpr inline static uint32_t MinCapacity = 8;
+private:
+    void *_heads[ClassCount];
+    uint32_t _counts[ClassCount];
+    /**
+     * 尚未合并的各个内存类型字节数的变化 无符号数回绕表示减少
+     */
+    size_t _flag_bytes[(int32_t) MEMFLAG::num_of_type];
+
+    /**
+     * 等级最多缓存的对象数量
+     * @param cls 尺寸等级
+     */
+    static uint32_t capacity_of(int cls);
+
+    /**
+     * 从中央仓库批量获取
+     * @param cls 尺寸等级
+     */
+    void refill(int cls);
+
+    /**
+     * 将count个对象批量归还到中央仓库
+     * @param cls 尺寸等级
+     * @param count 数量
+     */
+    void drain(int cls, uint32_t count);
+
+    /**
+     * 将累计的内存类型字节数合并到全局
+     */
+    void flush_accounting();
+
+public:
+    explicit SlabCache();
+
+    ~SlabCache();
+
+    /**
+     * 申请一个对象
+     * @param F 内存类型
+     * @param cls 尺寸等级
+     * @return 中央仓库也无法提供时返回nullptr
+     */
+    void *alloc(MEMFLAG F, int cls);
+
+    /**
+     * 释放一个对象
+     * @param F 内存类型
+     * @param p 对象
+     * @param cls 尺寸等级
+     */
+    void free(MEMFLAG F, void *p, int cls);
+
+    /**
+     * 将所有缓存的对象归还到中央仓库
+     * 线程退出时调用
+     */
+    void drain_all();
+};
+
+
+#endif //PLATFORM_SLAB_CACHE_HPP
@@ -142,6 +142,16 @@ extern void ARENA_FREE(
         void *ptr,
         size_t bytes);
 
+/**
+ * 调整快速内存的大小 上一次申请的内存可以原地扩展
+ */
+extern void *ARENA_REALLOC(
+        Arena *arena,
+        void *ptr,
+        size_t old_bytes,
+        size_t new_bytes,
+        bool exit_oom);
+
 /**
  * -----------------------------
  * 线程栈资源申请和分配
@@ -153,6 +163,12 @@ extern void *RESOURCE_ARENA_ALLOC(
 
 extern void RESOURCE_ARENA_FREE(void *ptr, size_t bytes);
 
+extern void *RESOURCE_ARENA_REALLOC(
+        void *ptr,
+        size_t old_bytes,
+        size_t new_bytes,
+        bool exit_oom = true);
+
 
 #define NEW_RESOURCE_ARRAY(type, size)\
   (type*) RESOURCE_ARENA_ALLOC((size) * sizeof(type))
@@ -160,6 +176,12 @@ extern void RESOURCE_ARENA_FREE(void *ptr, size_t bytes);
 #define FREE_RESOURCE_ARRAY(ptr,bytes) \
     RESOURCE_ARENA_FREE(ptr,bytes)
 
+#define REALLOC_RESOURCE_ARRAY(type, old, old_size, new_size)\
+  (type*) RESOURCE_ARENA_REALLOC((old),(old_size) * sizeof(type),(new_size) * sizeof(type))
+
+#define REALLOC_ARENA_ARRAY(arena, type, old, old_size, new_size)\
+  (type*) ARENA_REALLOC((arena),(old),(old_size) * sizeof(type),(new_size) * sizeof(type),true)
+
 #define NEW_ARENA_ARRAY(arena, type, size)\
   (type*) ARENA_ALLOC((arena),(size) * sizeof(type))
 
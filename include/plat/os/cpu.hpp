@@ -9,10 +9,151 @@
 #include "plat/constants.hpp"
 
 class OSThread;
+
+class CharOStream;
 namespace os {
 
     /**
-     * 获取可用的CPU数量
+     * CPU编号的集合 编号小于MaxCpus
+     */
+    class CpuSet {
+    public:
+        constexpr inline static uint32_t MaxCpus = 1024;
+    private:
+        constexpr inline static uint32_t WordBits = 64;
+        uint64_t _bits[MaxCpus / WordBits];
+    public:
+        CpuSet() : _bits{} {}
+
+        inline void clear() {
+            for (auto &word: _bits) {
+                word = 0;
+            }
+        }
+
+        inline void add(uint32_t cpu) {
+            if (cpu < MaxCpus) {
+                _bits[cpu / WordBits] |= (uint64_t) 1 << (cpu % WordBits);
+            }
+        }
+
+        inline void remove(uint32_t cpu) {
+            if (cpu < MaxCpus) {
+                _bits[cpu / WordBits] &= ~((uint64_t) 1 << (cpu % WordBits));
+            }
+        }
+
+        [[nodiscard]] inline bool contains(uint32_t cpu) const {
+            return cpu < MaxCpus && (_bits[cpu / WordBits] >> (cpu % WordBits) & 1) != 0;
+        }
+
+        [[nodiscard]] inline bool is_empty() const { return count() == 0; }
+
+        /**
+         * 只保留同时位于other中的CPU
+         */
+        inline void intersect(const CpuSet &other) {
+            for (uint32_t i = 0; i < MaxCpus / WordBits; ++i) {
+                _bits[i] &= other._bits[i];
+            }
+        }
+
+        /**
+         * 去掉位于other中的CPU
+         */
+        inline void subtract(const CpuSet &other) {
+            for (uint32_t i = 0; i < MaxCpus / WordBits; ++i) {
+                _bits[i] &= ~other._bits[i];
+            }
+        }
+
+        [[nodiscard]] uint32_t count() const;
+
+        /**
+         * 遍历 for(auto c = set.next(0); c < MaxCpus; c = set.next(c + 1))
+         * @return 不小于from的第一个CPU 没有时返回MaxCpus
+         */
+        [[nodiscard]] uint32_t next(uint32_t from) const;
+
+        /**
+         * 解析内核的CPU列表格式 例如"0-3,8,10-11" 追加到集合中
+         * @return 格式是否正确
+         */
+        bool parse_list(const char *list);
+
+        /**
+         * 以CPU列表的格式输出
+         */
+        void print_on(CharOStream *out) const;
+    };
+
+    /**
+     * CPU拓扑的汇总 由sysfs和cgroup解析 启动时确定
+     * 解析失败的字段会退回到保守的值
+     */
+    struct CpuTopology {
+        //CPU编号的上限(possible) 编号可能不连续
+        uint32_t _num_possible;
+        //在线的CPU数量
+        uint32_t _num_online;
+        //在线 且被线程亲和性以及cpuset允许的CPU数量
+        uint32_t _num_allowed;
+        //允许的CPU覆盖的物理核心 插槽以及NUMA节点的数量
+        uint32_t _num_cores;
+        uint32_t _num_packages;
+        uint32_t _num_nodes;
+        //cgroup的CPU配额(quota/period) 0表示不限制
+        double _quota_cpus;
+        //实际可以并行使用的CPU数量 min(允许的CPU, 向上取整的配额) 至少为1
+        uint32_t _effective_cpus;
+        //缓存行 一级数据缓存 二级缓存 最后一级缓存的字节数
+        size_t _cache_line_bytes;
+        size_t _l1d_bytes;
+        size_t _l2_bytes;
+        size_t _llc_bytes;
+        //共享一个最后一级缓存的CPU数量
+        uint32_t _llc_cpus;
+    };
+
+    /**
+     * @return CPU拓扑 初始化之前所有的字段为0
+     */
+    extern const CpuTopology &cpu_topology();
+
+    /**
+     * @return 在线 且被线程亲和性以及cpuset允许的CPU
+     */
+    extern const CpuSet &allowed_cpus();
+
+    /**
+     * @return CPU所在的NUMA节点 未知时返回-1
+     */
+    extern int32_t cpu_node(uint32_t cpu);
+
+    /**
+     * 同一个物理核心上的超线程(SMT) 包括cpu本身
+     */
+    extern void cpu_core_siblings(uint32_t cpu, CpuSet *siblings);
+
+    /**
+     * 共享最后一级缓存的CPU 包括cpu本身
+     */
+    extern void cpu_llc_siblings(uint32_t cpu, CpuSet *siblings);
+
+    /**
+     * NUMA节点上的在线CPU
+     */
+    extern void node_cpus(int32_t node, CpuSet *cpus);
+
+    /**
+     * 输出CPU拓扑 用于诊断
+     */
+    extern void print_cpu_topology(CharOStream *out);
+
+    /**
+     * 获取可用的CPU数量 即CpuTopology::_effective_cpus
+     * 线程池等按照CPU数量决定并行度的地方应当使用它 在容器中不会按照宿主机的CPU数量计算
+     * 拓扑初始化之前退回在线的CPU数量
      * @return
      */
     extern uint32_t avail_cpu_num();
@@ -61,6 +202,55 @@ namespace os {
     extern OSReturn set_native_prio(int32_t thread_id,
                                     ThreadPriority lang_prio);
 
+    /**
+     * 线程的调度策略
+     */
+    enum class SchedPolicy : uint8_t {
+        //SCHED_OTHER 普通的分时调度 优先级由nice值(ThreadPriority)决定
+        other,
+        //SCHED_BATCH 按照CPU密集型对待 唤醒时不会抢占其他线程
+        batch,
+        //SCHED_FIFO 实时调度 可以抢占所有普通线程 需要CAP_SYS_NICE
+        fifo
+    };
+
+    /**
+     * 解析调度策略 other batch fifo
+     * @return 名称非法时返回false
+     */
+    extern bool parse_sched_policy(const char *name, SchedPolicy *policy);
+
+    extern const char *sched_policy_name(SchedPolicy policy);
+
+    /**
+     * 设置线程的调度策略
+     * @param thread_id OS的线程ID
+     * @param policy 调度策略
+     * @param rt_priority 实时优先级(1-99) 只对fifo有效
+     * @return 操作状态码 没有权限时返回ERR
+     */
+    extern OSReturn set_sched_policy(int32_t thread_id,
+                                     SchedPolicy policy,
+                                     int32_t rt_priority);
+
+    /**
+     * 设置线程的CPU亲和性
+     * @param thread_id OS的线程ID
+     * @param cpus 允许运行的CPU 不能为空
+     * @return 操作状态码
+     */
+    extern OSReturn set_thread_affinity(int32_t thread_id,
+                                        const CpuSet &cpus);
+
+    /**
+     * 获取线程的CPU亲和性
+     * @param thread_id OS的线程ID
+     * @param cpus 允许运行的CPU
+     * @return 操作状态码
+     */
+    extern OSReturn get_thread_affinity(int32_t thread_id,
+                                        CpuSet *cpus);
+
     /**
      * 创建线程
      * @param thread 线程对象
@@ -66,5 +66,25 @@ namespace os {
      */
     void close(int32_t fd);
 
+    /**
+     * 从文件的指定偏移读取 不改变文件的读写位置
+     * @param fd
+     * @param buf 读取的目的地
+     * @param bytes 需要读取的字节数
+     * @param offset 文件中的偏移
+     * @return 读满bytes字节才返回true
+     */
+    bool read_at(int32_t fd, void *buf, size_t bytes, size_t offset);
+
+    /**
+     * 写入文件的指定偏移 不改变文件的读写位置
+     * @param fd
+     * @param data 写入的数据
+     * @param bytes 需要写入的字节数
+     * @param offset 文件中的偏移
+     * @return 全部写入才返回true
+     */
+    bool write_at(int32_t fd, const void *data, size_t bytes, size_t offset);
+
 }
 #endif //PLATFORM_OS_FILE_HPP
@@ -75,6 +75,141 @@ namespace os {
                                    size_t bytes,
                                    int32_t fd = -1);
 
+    /**
+     * 使用大页的方式 每个模块各自选择
+     */
+    enum class LargePageMode : uint8_t {
+        //不使用
+        off,
+        //建议内核使用透明大页(THP) 由内核决定是否合并
+        thp,
+        //使用预留的大页(hugetlbfs) 预留不足时保留失败
+        hugetlb
+    };
+
+    /**
+     * 解析大页的方式 off thp hugetlb
+     * @return 名称非法时返回false
+     */
+    bool parse_large_page_mode(const char *name, LargePageMode *mode);
+
+    const char *large_page_mode_name(LargePageMode mode);
+
+    /**
+     * 获取系统支持的大页(hugetlbfs)的大小 从小到大排列
+     * @param sizes 输出的大小
+     * @param max_sizes sizes的容量
+     * @return 支持的大小的个数 可能大于max_sizes
+     */
+    int32_t huge_page_sizes(size_t *sizes, int32_t max_sizes);
+
+    /**
+     * 获取默认的大页大小 即透明大页以及不指定大小时hugetlbfs使用的大小
+     * @return 不支持大页时返回0
+     */
+    size_t default_huge_page_size();
+
+    enum class THPMode : uint8_t {
+        //内核不支持透明大页
+        unsupported,
+        never,
+        //仅仅对madvise(MADV_HUGEPAGE)的区间使用
+        madvise,
+        always
+    };
+
+    /**
+     * 获取系统透明大页的模式
+     * @return
+     */
+    THPMode thp_mode();
+
+    /**
+     * 保留由大页支持的虚拟地址空间
+     * 地址按照page_bytes对齐 之后的提交 撤销 释放 同样需要按照page_bytes对齐
+     * 大页的预留(HugePages_Free)不足时失败 由调用者退回普通页
+     * @param F 类型标记
+     * @param bytes 申请的字节数 按照page_bytes对齐
+     * @param page_bytes 大页的大小 必须是huge_page_sizes之一
+     * @return 内存地址 nullptr表示申请失败
+     */
+    void *reserve_memory_huge(MEMFLAG F, size_t bytes, size_t page_bytes);
+
+    /**
+     * 建议内核对区间使用或者不使用透明大页
+     * 只有区间内按照大页对齐的部分才可能被大页支持
+     * @param addr 按页对齐
+     * @param bytes 按页对齐
+     * @param enable true 使用 false 不使用
+     * @return 操作是否成功 内核不支持时返回false
+     */
+    bool advise_huge_pages(void *addr, size_t bytes, bool enable);
+
+    /**
+     * 区间实际使用的页框
+     */
+    struct PageInfo {
+        /**
+         * 区间所在映射(VMA)的页大小 跨越多个映射时取最大的
+         */
+        size_t _page_bytes;
+        /**
+         * 驻留在物理内存中的字节数
+         */
+        size_t _rss_bytes;
+        /**
+         * 由透明大页支持的字节数
+         */
+        size_t _thp_bytes;
+    };
+
+    /**
+     * 查询区间实际使用的页框 按照区间所在的映射(VMA)统计
+     * 读取/proc/self/smaps 开销较大 不可以在频繁的路径上调用
+     * @return 读取失败或者区间不属于任何映射时返回false
+     */
+    bool page_info(void *addr, size_t bytes, PageInfo *info);
+
+    /**
+     * 内存压力的来源 按照优先级排列
+     * 有cgroup内存限制时只使用cgroup自身的来源 整个系统的来源无法反映是否接近限制
+     */
+    enum class PressureSource : uint8_t {
+        //无法读取任何来源
+        none,
+        //cgroup v2的PSI(memory.pressure) cgroup内因为内存不足而停顿的时间比例
+        cgroup_psi,
+        //cgroup的内存限制 已使用的比例
+        cgroup,
+        //PSI(/proc/pressure/memory) 整个系统因为内存不足而停顿的时间比例
+        psi,
+        //整个系统的可用内存(MemAvailable 不支持时使用avail_pages) 已使用的比例
+        avail
+    };
+
+    const char *pressure_source_name(PressureSource source);
+
+    struct MemoryPressure {
+        PressureSource _source;
+        /**
+         * 压力的百分比 0~100 含义取决于来源
+         * cgroup_psi和psi为最近10秒的停顿比例(some avg10) 其余为已使用的比例
+         */
+        double _percent;
+        /**
+         * 自上一次采样以来 cgroup触及上限(memory.events的max oom)的次数
+         * 只有cgroup v2(cgroup_psi以及v2的cgroup)才有 其余来源总是0
+         */
+        uint64_t _limit_events;
+    };
+
+    /**
+     * 采样内存压力 第一次调用时选择来源 之后一直使用同一个来源
+     * 读取/proc或者/sys下的文件 不可以在频繁的路径上调用 也不是线程安全的
+     * @return 读取失败时返回false
+     */
+    bool memory_pressure(MemoryPressure *pressure);
+
     enum class CommitType {
         none = 0,
         //可读 可写 可执行
@@ -99,15 +234,119 @@ namespace os {
                        CommitType type);
 
     /**
-     * 撤销内存的提交并且会将内部的数据清除
+     * 将文件的一段以写时复制(MAP_PRIVATE)的方式映射到已经保留的地址空间 视为提交
+     * 之后的修改只对本进程可见 不会写回文件 文件在映射期间不可以被截断
+     * 撤销提交之后再次提交 读到的是文件原本的内容而不是零页
+     * @param F 类型标记
+     * @param addr 已经保留的地址 按页对齐
+     * @param bytes 映射的字节数 按页对齐
+     * @param fd 文件描述符 映射之后可以关闭
+     * @param offset 文件中的偏移 按页对齐
+     * @param type 访问的权限
+     * @return 操作是否成功
+     */
+    bool map_memory(MEMFLAG F,
+                    void *addr,
+                    size_t bytes,
+                    int32_t fd,
+                    size_t offset,
+                    CommitType type);
+
+    /**
+     * 撤销提交的方式
+     */
+    enum class UncommitType : uint8_t {
+        //使用UncommitStrategy指定的方式
+        global,
+        //重新映射为不可访问 立即释放页框 之后的访问会触发SIGSEGV
+        //每次撤销都会分裂映射(VMA)
+        protect,
+        //MADV_DONTNEED 立即释放页框 保持映射和访问权限不变 再次访问得到清零的页
+        dontneed,
+        //MADV_FREE 内存紧张时内核才回收页框 再次访问可能得到原来的数据
+        //内核不支持时退回dontneed
+        free
+    };
+
+    /**
+     * 解析撤销提交的方式 protect dontneed free
+     * @return 名称非法时返回false
+     */
+    bool parse_uncommit_type(const char *name, UncommitType *type);
+
+    const char *uncommit_type_name(UncommitType type);
+
+    /**
+     * @return UncommitStrategy指定的撤销提交方式
+     */
+    UncommitType default_uncommit_type();
+
+    /**
+     * 撤销内存的提交 数据是否保留取决于撤销的方式
+     * 除了protect之外 其余方式撤销之后的区间仍然可以访问 不能依赖访问失败发现错误
      * @param F 申请的内存标记
      * @param addr 虚拟进程地址
      * @param bytes 虚拟进程地址空间长度
+     * @param type 撤销提交的方式
      * @return 操作是否成功
      */
     bool uncommit_memory(MEMFLAG F,
                          void *addr,
-                         size_t bytes);
+                         size_t bytes,
+                         UncommitType type = UncommitType::global);
+
+    /**
+     * 批量撤销提交 相邻的区间合并成一次系统调用
+     * 区间按照地址有序保存 加入时与前后相接的区间合并 容量不足时先执行已有的区间
+     * 析构之前必须调用flush
+     */
+    class UncommitBatch : public StackObject {
+    private:
+        constexpr inline static int32_t Capacity = 32;
+
+        struct Range {
+            uintptr_t _base;
+            uintptr_t _end;
+        };
+
+        const MEMFLAG _flag;
+        const UncommitType _type;
+        int32_t _num_ranges;
+        /**
+         * 加入的区间的个数
+         */
+        size_t _num_added;
+        /**
+         * 实际调用uncommit_memory的次数
+         */
+        size_t _num_calls;
+        Range _ranges[Capacity];
+
+    public:
+        explicit UncommitBatch(MEMFLAG F, UncommitType type = UncommitType::global);
+
+        ~UncommitBatch();
+
+        /**
+         * 加入一个待撤销的区间 区间之间不可以重叠
+         * @return 容量不足时执行已有的区间 执行失败返回false
+         */
+        bool add(void *addr, size_t bytes);
+
+        /**
+         * 撤销全部的区间
+         * @return 任意一次撤销失败都返回false 失败之后剩余的区间不再撤销
+         */
+        bool flush();
+
+        inline size_t num_added() const {
+            return this->_num_added;
+        };
+
+        inline size_t num_calls() const {
+            return this->_num_calls;
+        };
+    };
 
     /**
      * 释放保留虚拟进程地址空间
@@ -118,6 +357,16 @@ namespace os {
      */
     bool release_memory(MEMFLAG F, void *addr, size_t bytes);
 
+    /**
+     * 释放整个区间都已经提交的进程地址空间 内存追踪中同时撤销提交
+     * 只需要一次munmap 不必为了平衡提交的大小先调用uncommit_memory
+     * @param F 申请的内存标记
+     * @param addr 释放的进程空间
+     * @param bytes 虚拟进程空间大小
+     * @return 操作是否成功
+     */
+    bool release_committed_memory(MEMFLAG F, void *addr, size_t bytes);
+
     /**
      * @param start 虚拟地址起始位置
      * @param bytes 虚拟地址空间大小
@@ -11,6 +11,11 @@
 namespace os {
     extern ticks_t VMStartStamp;
 
+    /**
+     * VM启动时的单调时钟
+     */
+    extern ticks_t VMStartMonotonicStamp;
+
 
     /**
    * 获取进程的 运行时间
@@ -29,12 +34,41 @@ namespace os {
      */
     ticks_t current_stamp();
 
+    /**
+     * 单调时钟的来源
+     */
+    enum class ClockSource {
+        monotonic,//clock_gettime(CLOCK_MONOTONIC)
+        tsc//时间戳计数器 启动时校准 之后定期使用CLOCK_MONOTONIC校准
+    };
+
+    const char *clock_source_name(ClockSource source);
+
+    /**
+     * @return 启动时选定的单调时钟的来源
+     */
+    ClockSource clock_source();
+
+    /**
+     * 单调递增的纳秒数 起点不确定 只能用于计算时间间隔
+     * 不受系统时间调整的影响 比current_stamp更快
+     * @return
+     */
+    ticks_t monotonic_stamp();
+
+    /**
+     * 使用CLOCK_MONOTONIC重新校准TSC时钟 由定时任务按照ClockSyncInterval调用
+     * 不会使时钟回退 误差在下一个间隔内逐渐消除
+     * 单调时钟的来源不是TSC时什么也不做
+     */
+    void clock_resync();
+
     /**
      * 返回距离启动的纳秒数
      * @return
      */
     inline ticks_t elapsed_stamp(){
-        return current_stamp() - VMStartStamp;
+        return monotonic_stamp() - VMStartMonotonicStamp;
     };
 
 
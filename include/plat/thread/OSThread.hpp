@@ -9,6 +9,8 @@
 #include "plat/utils//OrderAccess.hpp"
 #include "plat/utils/robust.hpp"
 #include "plat/mem/Arena.hpp"
+#include "plat/mem/ArenaChunkCache.hpp"
+#include "plat/mem/SlabCache.hpp"
 #include "plat/os/cpu.hpp"
 
 /**
@@ -71,6 +73,10 @@ private:
      * 10 最高
      */
     int8_t _priority;
+    /**
+     * 调度策略 默认继承创建者 即other
+     */
+    os::SchedPolicy _sched_policy;
     int32_t _kernel_id;
     /**
      * 线程库中的线程ID
@@ -82,6 +88,14 @@ private:
      * 内部的资源区域
      */
     Arena *_resource_arena;
+    /**
+     * 线程私有的快速内存块缓存
+     */
+    ArenaChunkCache _chunk_cache;
+    /**
+     * 线程私有的小对象缓存 仅仅在CHeapBackend=slab时使用
+     */
+    SlabCache _slab_cache;
     thread_local static OSThread *_current;
     NONCOPYABLE(OSThread);
 
@@ -116,6 +130,22 @@ public:
         return this->_resource_arena;
     };
 
+    /**
+     * 仅仅可以被当前线程访问
+     * @return
+     */
+    inline ArenaChunkCache *chunk_cache() {
+        return &this->_chunk_cache;
+    };
+
+    /**
+     * 仅仅可以被当前线程访问
+     * @return
+     */
+    inline SlabCache *slab_cache() {
+        return &this->_slab_cache;
+    };
+
     /**
      * 获取线程的ID，这里是pthread库的id
      * @return
@@ -132,6 +162,25 @@ public:
         return this->_priority;
     };
 
+    [[nodiscard]] inline auto get_sched_policy() const {
+        return this->_sched_policy;
+    };
+
+    /**
+     * 将线程绑定到一组CPU上 线程启动之后才可以调用
+     * @param cpus 允许运行的CPU
+     * @return 操作状态码
+     */
+    OSReturn set_affinity(const os::CpuSet &cpus);
+
+    /**
+     * 设置线程的调度策略 线程启动之后才可以调用
+     * @param policy 调度策略
+     * @param rt_priority 实时优先级 只对fifo有效
+     * @return 操作状态码 失败时保持原来的策略
+     */
+    OSReturn set_sched_policy(os::SchedPolicy policy, int32_t rt_priority);
+
 
     [[nodiscard]] inline auto state() const {
         return OrderAccess::load<uint8_t>(&_os_state);
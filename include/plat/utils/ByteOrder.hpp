@@ -30,6 +30,25 @@ public:
     };
 
 
+    /**
+     * 网络字节序转换为主机序 与network互逆
+     * @param value
+     * @return
+     */
+    template<typename T>
+    requires(sizeof(T) <= 8)
+    static inline T host(T value) {
+        if constexpr (sizeof(T) == 1) {
+            return value;
+        } else if constexpr (sizeof(T) == 2) {
+            return be16toh(value);
+        } else if constexpr (sizeof(T) == 4) {
+            return be32toh(value);
+        } else if constexpr (sizeof(T) == 8) {
+            return be64toh(value);
+        }
+    };
+
     /**
      * 获取主机序
      * @param value
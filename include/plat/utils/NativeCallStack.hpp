@@ -13,6 +13,12 @@
 /**
  * 打印
  * 内部C语言栈桢
+ *
+ * 开启 PLAT_FRAME_POINTER 时 沿着栈帧指针获取调用堆栈
+ * 每一帧都检查是否位于当前线程的栈范围内 栈帧指针必须单调递增
+ * 无法获取线程的栈范围 或者没有开启时 使用 backtrace(较慢)
+ *
+ * 仅仅在开启内存追踪时才会获取 否则为空的堆栈
  */
 class NativeCallStack {
 public:
@@ -22,6 +28,10 @@ private:
      * 空的堆栈
      */
     static NativeCallStack _empty_stack;
+    /**
+     * 是否需要获取调用堆栈
+     */
+    static bool _capture_enabled;
     /**
      * 存储堆栈的指针
      * 0 ~ DEPTH -1
@@ -36,9 +46,11 @@ public:
 
     /**
      * 获取调用堆栈信息
-     * @param depth
+     * 从创建对象的函数的调用者开始记录
+     * 优先沿着栈帧指针 其次使用backtrace 都失败时只记录创建者中的返回地址(return_thread_pc)
+     * @param skip 额外跳过的栈帧数量
      */
-    explicit NativeCallStack(uint16_t depth);
+    explicit NativeCallStack(uint16_t skip);
 
     /**
      * 拷贝数据
@@ -77,6 +89,25 @@ public:
     [[nodiscard]] inline bool is_empty() const{
         return this->_stack[0] == nullptr;
     };
+
+    static inline void set_capture_enabled(bool enabled) {
+        NativeCallStack::_capture_enabled = enabled;
+    };
+
+    /**
+     * 沿着栈帧指针获取调用堆栈
+     * 第0帧是调用该函数的位置
+     * @param pcs 存放指令地址
+     * @param max_depth 最多记录的帧数
+     * @param skip 跳过的帧数
+     * @return 记录的帧数 不支持时返回-1
+     */
+    static int walk_frame_pointers(void **pcs, int max_depth, int skip);
+
+    /**
+     * 使用backtrace获取调用堆栈 参数同上
+     */
+    static int walk_backtrace(void **pcs, int max_depth, int skip);
 };
 
 
@@ -22,7 +22,7 @@ inline constexpr bool is_power_of_2(T value) {
 
 
 template<std::integral T>
-inline constexpr bool max_power_2(){
+inline constexpr T max_power_2(){
     T max_val = std::numeric_limits<T>::max();
     return max_val - (max_val >> 1);
 }
@@ -5,15 +5,21 @@
 #include "PeriodicThread.hpp"
 #include "kernel_mutex.hpp"
 #include "VMThread.hpp"
+#include "kernel/thread/PeriodicTask.hpp"
 void KernelInitialize::daemon_thread_initialize() {
     //1. 创建周期性任务的守护线程
     PeriodicThread::create();
     VMThread::create();
+    PeriodicTask::start_nmt_drain_task();
+    PeriodicTask::start_nmt_diff_task();
+    PeriodicTask::start_memory_pressure_task();
+    PeriodicTask::start_clock_sync_task();
 
     PeriodicThread::start();
 }
 
 void KernelInitialize::initialize() {
     kernel_mutex_init();
+    PlatThread::placement_initialize();
     daemon_thread_initialize();
 }
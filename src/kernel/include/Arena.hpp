@@ -8,6 +8,7 @@
 #include "plat/mem/allocation.hpp"
 #include "kernel/utils/LinkedList.hpp"
 #include "kernel/metaspace/ArenaGrowthPolicy.hpp"
+#include "kernel/metaspace/ArenaUsage.hpp"
 
 class Mutex;
 namespace metaspace {
@@ -36,6 +37,13 @@ namespace metaspace {
          * 链表中内存块的数量
          */
         size_t _num_of_segments;
+        /**
+         * 内部浪费的统计 仅在已有的分配路径上累加 同时汇总到ContextHolder
+         * _align_waste_bytes 存活分配的对齐浪费
+         * _salvaged_bytes 回收旧块尾部的累计字节
+         */
+        size_t _align_waste_bytes;
+        size_t _salvaged_bytes;
 
 
         /**
@@ -88,6 +96,18 @@ namespace metaspace {
             return const_cast<Segment *>(this->_segments.head());
         };
 
+        /**
+         * BlockManager中空闲的字节
+         * @return
+         */
+        inline size_t free_block_bytes();
+
+        /**
+         * 将BlockManager空闲字节的变化同步到ContextHolder
+         * @param before 操作之前的空闲字节
+         */
+        void account_free_block_bytes(size_t before);
+
         inline SegmentLevel policy_suggest_next_level() {
             return this->_policy->get_level_by_step(this->_num_of_segments);
         };
@@ -125,14 +145,26 @@ namespace metaspace {
         ~Arena();
 
         /**
-         * 粗略统计内部内存块的使用情况
-         * @param used_bytes 已使用的内存大小
-         * @param committed_bytes  已提交内存大小
-         * @param capacity_bytes total内存容量
+         * 接管一个已经设为正在使用的内存块 放在链表头部成为当前块
+         * 块中已经使用的字节计入统计 用于映射元空间的归档
+         * @param segment
+         */
+        void adopt_segment(Segment *segment);
+
+        /**
+         * 从当前块开始 依次访问链表中的内存块
+         * @param f 返回false时停止
+         */
+        template<class F>
+        inline void segments_do(F f) {
+            this->_segments.node_head_do(f);
+        };
+
+        /**
+         * 统计内部内存块的使用情况以及各类浪费
+         * @param usage 输出的统计结果
          */
-        void usage_numbers(size_t *used_bytes,
-                           size_t *committed_bytes,
-                           size_t *capacity_bytes);
+        void usage_numbers(ArenaUsage *usage);
 
         void print_on(CharOStream *stream);
     };
@@ -0,0 +1,76 @@
+//
+// Created by aurora on 2026/10/19.
+//
+
+#ifndef KERNEL_MEMORY_MEMORY_PRESSURE_MONITOR_HPP
+#define KERNEL_MEMORY_MEMORY_PRESSURE_MONITOR_HPP
+
+#include "stdtype.hpp"
+#include "plat/mem/AllStatic.hpp"
+#include "plat/os/mem.hpp"
+
+/**
+ * 根据系统的内存压力回收虚拟机持有的空闲内存
+ * 由定时任务按照MemoryPressureInterval采样 见os::memory_pressure
+ *
+ * 压力上升时立即进入更高的级别 并且执行该级别的回收
+ *   moderate  清理快速内存的块池 撤销元空间空闲块的提交 写出内存追踪的缓冲区
+ *   critical  在moderate的基础上收紧元空间的GC阈值 并且在保持critical期间每次采样都回收
+ * 压力下降时需要连续ExitSamples次低于退出阈值才下降一级 避免在阈值附近反复切换
+ *
+ * 只在周期任务线程中调用 不需要同步
+ */
+class MemoryPressureMonitor : public AllStatic {
+public:
+    enum class Level : uint8_t {
+        normal,
+        moderate,
+        critical
+    };
+
+private:
+    /**
+     * 每种来源的阈值 单位都是百分比
+     */
+    struct Thresholds {
+        double _moderate;
+        double _critical;
+        /**
+         * 低于进入阈值减去该值时才认为压力下降
+         */
+        double _exit_margin;
+    };
+
+    constexpr inline static uint32_t ExitSamples = 3;
+
+    static Level _level;
+    static uint32_t _calm_samples;
+
+    static const Thresholds &thresholds_of(os::PressureSource source);
+
+    /**
+     * @return 只按照进入阈值判断的级别
+     */
+    static Level classify(const os::MemoryPressure &pressure, const Thresholds &thresholds);
+
+    static void transition(Level level, const os::MemoryPressure &pressure);
+
+    /**
+     * 执行对应级别的回收
+     */
+    static void relieve(Level level);
+
+public:
+    static const char *level_name(Level level);
+
+    static inline Level level() {
+        return _level;
+    };
+
+    /**
+     * 采样一次内存压力 必要时切换级别以及回收内存
+     */
+    static void sample();
+};
+
+#endif //KERNEL_MEMORY_MEMORY_PRESSURE_MONITOR_HPP
@@ -6,12 +6,53 @@
 #define VMACHINE_METASPACE_HPP
 #include "plat/mem/AllStatic.hpp"
 #include "stdtype.hpp"
+#include "plat/os/mem.hpp"
+#include "plat/utils/OrderAccess.hpp"
 class CharOStream;
+class MetaspaceArena;
 namespace metaspace {
-    class MetaspaceArena;
-
     class Metaspace : public AllStatic {
+    private:
+        /**
+         * 虚拟节点使用大页的方式 由MetaspaceLargePages指定
+         */
+        static os::LargePageMode _large_page_mode;
+        /**
+         * post_initialize完成之后为true 其他线程据此判断元空间是否可用
+         */
+        static volatile bool _initialized;
+        /**
+         * 根加载器使用的arena 设置了MetaspaceArchivePath时从归档中恢复
+         */
+        static MetaspaceArena *_boot_arena;
+        /**
+         * 归档中根对象的地址 没有使用归档时为nullptr
+         */
+        static void *_archive_root;
+
+        /**
+         * 映射元空间归档 失败或者没有指定时构造空的arena
+         */
+        static void boot_arena_initialize();
     public:
+        static inline os::LargePageMode large_page_mode() {
+            return _large_page_mode;
+        };
+
+        static inline bool is_initialized() {
+            return OrderAccess::load(&_initialized);
+        };
+
+        static inline MetaspaceArena *boot_arena() {
+            return _boot_arena;
+        };
+
+        /**
+         * @return 归档中的根对象 为nullptr时调用者需要从头构造元数据
+         */
+        static inline void *archive_root() {
+            return _archive_root;
+        };
 
         /**
          * 用于设置元空间的参数
@@ -34,6 +75,11 @@ namespace metaspace {
          */
         static void purge();
 
+        /**
+         * @return 元空间已提交的字节数
+         */
+        static size_t committed_bytes();
+
         /**
          * 在GC情况下再次进行申请 应该获取锁的情况下
          * @param arena
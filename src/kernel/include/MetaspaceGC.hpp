@@ -93,6 +93,13 @@ public:
      * @return 是否需要重试
      */
     static bool threshold_with_gc(size_t bytes);
+
+    /**
+     * 系统内存压力大时 将GC阈值收紧到已提交的字节数加上MinMetaspaceExpansion
+     * 使元空间尽早触发GC而不是继续提交内存 下一次GC之后按照空闲比例重新计算
+     * @return 收紧后的GC阈值 阈值已经足够小时不修改
+     */
+    static size_t tighten_threshold();
 };
 
 
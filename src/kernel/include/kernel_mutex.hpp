@@ -27,6 +27,7 @@
 
 #define VM_MUTEX_LIST(f)                                            \
 f(Mutex,Metaspace,"元空间全局扩展的锁")                                \
+f(Mutex,BootMetaspace,"根加载器元空间arena的锁")                          \
 f(Monitor,Heap,"语言层面堆的锁")                                   \
 f(Monitor,LangThreadList,"线程控制器 用于控制线程的分配和销毁")      \
 f(Mutex,Expand_Heap,"扩展heap时候的锁")                             \
@@ -46,6 +46,10 @@ private:
      * 开始通知线程同步的时间
      */
     static TimeStamp _beg_time;
+    /**
+     * 所有线程同步完成 进入安全点的时间
+     */
+    static TimeStamp _sync_time;
     static TimeStamp _end_time;
 
     static inline auto state() {
@@ -0,0 +1,113 @@
+//
+// Created by aurora on 2026/10/19.
+//
+
+#include "MemoryPressureMonitor.hpp"
+#include "MetaspaceGC.hpp"
+#include "Metaspace.hpp"
+#include "MemoryTracer.hpp"
+#include "plat/mem/Arena.hpp"
+#include "plat/logger/log.hpp"
+
+MemoryPressureMonitor::Level MemoryPressureMonitor::_level = MemoryPressureMonitor::Level::normal;
+uint32_t MemoryPressureMonitor::_calm_samples = 0;
+
+const MemoryPressureMonitor::Thresholds &MemoryPressureMonitor::thresholds_of(os::PressureSource source) {
+    //psi是停顿的时间比例 较小的值已经说明内核在频繁地回收内存
+    static const Thresholds stall = {10, 40, 5};
+    //其余来源是已使用的比例
+    static const Thresholds usage = {85, 95, 5};
+    return source == os::PressureSource::psi || source == os::PressureSource::cgroup_psi ? stall : usage;
+}
+
+MemoryPressureMonitor::Level MemoryPressureMonitor::classify(const os::MemoryPressure &pressure,
+                                                             const Thresholds &thresholds) {
+    //cgroup已经触及上限 内核正在回收或者OOM
+    if (pressure._limit_events > 0 || pressure._percent >= thresholds._critical) {
+        return Level::critical;
+    }
+    if (pressure._percent >= thresholds._moderate) {
+        return Level::moderate;
+    }
+    return Level::normal;
+}
+
+const char *MemoryPressureMonitor::level_name(Level level) {
+    switch (level) {
+        case Level::normal:
+            return "normal";
+        case Level::moderate:
+            return "moderate";
+        case Level::critical:
+            return "critical";
+    }
+    return "unknown";
+}
+
+void MemoryPressureMonitor::transition(Level level, const os::MemoryPressure &pressure) {
+    if (level == Level::critical) {
+        log_warn(pressure)("memory pressure %s -> %s, %s %.1f%%, " SIZE_FORMAT " limit events",
+                           level_name(_level), level_name(level),
+                           os::pressure_source_name(pressure._source), pressure._percent,
+                           (size_t) pressure._limit_events);
+    } else {
+        log_info(pressure)("memory pressure %s -> %s, %s %.1f%%",
+                           level_name(_level), level_name(level),
+                           os::pressure_source_name(pressure._source), pressure._percent);
+    }
+    _level = level;
+    _calm_samples = 0;
+}
+
+void MemoryPressureMonitor::relieve(Level level) {
+    if (level == Level::normal) {
+        return;
+    }
+    Arena::clean_pool();
+    if (MemoryTracer::nmt_level() == MemoryTracer::NMT_Level::detail) {
+        MemoryTracer::drain();
+    }
+    //元空间可能还没有初始化
+    if (!metaspace::Metaspace::is_initialized()) {
+        return;
+    }
+    const auto committed_before = metaspace::Metaspace::committed_bytes();
+    metaspace::Metaspace::purge();
+    const auto committed_after = metaspace::Metaspace::committed_bytes();
+    if (level == Level::critical) {
+        MetaspaceGC::tighten_threshold();
+    }
+    log_debug(pressure)("relieve %s: metaspace committed " SIZE_FORMAT "K -> " SIZE_FORMAT "K",
+                        level_name(level), committed_before / K, committed_after / K);
+}
+
+void MemoryPressureMonitor::sample() {
+    os::MemoryPressure pressure;
+    if (!os::memory_pressure(&pressure)) {
+        return;
+    }
+    const auto &thresholds = thresholds_of(pressure._source);
+    const auto level = classify(pressure, thresholds);
+    log_trace(pressure)("%s %.1f%%, level %s",
+                        os::pressure_source_name(pressure._source), pressure._percent, level_name(level));
+    if (level > _level) {
+        transition(level, pressure);
+        relieve(level);
+        return;
+    }
+    if (_level == Level::normal) {
+        return;
+    }
+    //低于当前级别的退出阈值 才开始计数
+    const auto enter = _level == Level::critical ? thresholds._critical : thresholds._moderate;
+    if (level < _level && pressure._percent < enter - thresholds._exit_margin) {
+        if (++_calm_samples >= ExitSamples) {
+            transition((Level) ((uint8_t) _level - 1), pressure);
+        }
+        return;
+    }
+    _calm_samples = 0;
+    if (_level == Level::critical) {
+        relieve(Level::critical);
+    }
+}
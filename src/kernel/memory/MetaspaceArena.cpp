@@ -81,12 +81,9 @@ void MetaspaceArena::deallocate(void *ptr, size_t bytes) {
     this->_arena->deallocate(ptr, bytes);
 }
 
-void MetaspaceArena::usage_numbers(
-        size_t *used_bytes,
-        size_t *committed_bytes,
-        size_t *capacity_bytes) {
+void MetaspaceArena::usage_numbers(metaspace::ArenaUsage *usage) {
     MutexLocker locker(this->_mutex);
-    this->_arena->usage_numbers(used_bytes, committed_bytes, capacity_bytes);
+    this->_arena->usage_numbers(usage);
 }
 
 
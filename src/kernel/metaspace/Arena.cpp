@@ -15,8 +15,10 @@
 namespace metaspace {
     Arena::Arena(ArenaGrowthPolicy *policy) :
             _block_manager(nullptr),
+            _policy(policy),
             _num_of_segments(0),
-            _policy(policy) {
+            _align_waste_bytes(0),
+            _salvaged_bytes(0) {
         meta_log(debug, "出生(born)");
         InternalStats::inc_num_arena_births();
     }
@@ -24,16 +26,19 @@ namespace metaspace {
     Arena::~Arena() {
         int count = 0;
         size_t total_bytes = 0;
+        size_t used_bytes = 0;
         const auto cm = ContextHolder::context();
 
-        auto deallocate_func = [&](Segment *segment) {
+        //归还前需要先从链表中摘除
+        for (auto segment = this->_segments.delete_from_list_head();
+             segment != nullptr;
+             segment = this->_segments.delete_from_list_head()) {
             total_bytes += segment->total_bytes();
+            used_bytes += segment->used_bytes();
             ++count;
             meta_log2(debug, "归还:" SEGMENT_FORMAT, SEGMENT_FORMAT_ARGS(segment));
             cm->return_segment(segment);
-            return true;
-        };
-        this->_segments.node_head_do(deallocate_func);
+        }
         assert(count == this->_num_of_segments, "程序错误");
         {
             meta_log_stream(debug);
@@ -42,8 +47,11 @@ namespace metaspace {
             log.print_human_bytes(total_bytes);
             log.print_raw_cr(".");
         }
-        //调整大小
-        ContextHolder::context()->sub_arena_used_bytes(total_bytes);
+        //调整大小 以及撤销本Arena对浪费统计的贡献
+        cm->sub_arena_used_bytes(used_bytes);
+        cm->sub_arena_align_waste_bytes(this->_align_waste_bytes);
+        cm->sub_arena_salvaged_bytes(this->_salvaged_bytes);
+        cm->sub_arena_free_block_bytes(this->free_block_bytes());
         if (this->_block_manager) {
             delete this->_block_manager;
             this->_block_manager = nullptr;
@@ -130,8 +138,15 @@ namespace metaspace {
         assert(p != nullptr && segment->free_below_committed_bytes() == 0, "健全");
         //更新统计的信息 由于申请后的内存仅仅放入到隶属于本类的BlockManager
         // 我们应该也认为这个内存被使用了
-        ContextHolder::context()->add_arena_used_bytes(remain_bytes);
+        const auto cm = ContextHolder::context();
+        cm->add_arena_used_bytes(remain_bytes);
+        if (this->_block_manager == nullptr) {
+            this->_block_manager = new BlockManager();
+        }
         this->_block_manager->deallocate(p, remain_bytes);
+        this->_salvaged_bytes += remain_bytes;
+        cm->add_arena_salvaged_bytes(remain_bytes);
+        cm->add_arena_free_block_bytes(remain_bytes);
     }
 
 
@@ -145,6 +160,12 @@ namespace metaspace {
             this->_block_manager = new BlockManager();
         }
         this->_block_manager->deallocate(p, raw_bytes);
+        //归还后这次分配的对齐浪费也就不存在了
+        const auto align_waste = MIN2(raw_bytes - bytes, this->_align_waste_bytes);
+        this->_align_waste_bytes -= align_waste;
+        const auto cm = ContextHolder::context();
+        cm->sub_arena_align_waste_bytes(align_waste);
+        cm->add_arena_free_block_bytes(raw_bytes);
     }
 
     void *Arena::allocate(size_t required_bytes) {
@@ -152,11 +173,14 @@ namespace metaspace {
         auto raw_bytes = get_raw_byte_for_requested(required_bytes);
         meta_log2(trace, "请求:" SIZE_FORMAT "B,实际:" SIZE_FORMAT "B",
                   required_bytes, raw_bytes);
+        const auto align_waste = raw_bytes - required_bytes;
         /**
          * 首先从BlockManager中获取
          */
         auto p = this->allocate_from_block(raw_bytes);
         if (p) {
+            this->_align_waste_bytes += align_waste;
+            ContextHolder::context()->add_arena_align_waste_bytes(align_waste);
             return p;
         }
         p = this->allocate_from_current_segment(raw_bytes);
@@ -176,7 +200,10 @@ namespace metaspace {
              * 说明肯定是申请成功了
              * 更新统计信息
              */
-            ContextHolder::context()->add_arena_used_bytes(raw_bytes);
+            const auto cm = ContextHolder::context();
+            cm->add_arena_used_bytes(raw_bytes);
+            this->_align_waste_bytes += align_waste;
+            cm->add_arena_align_waste_bytes(align_waste);
             InternalStats::inc_num_allocs();
             meta_log2(trace, "申请后:%u segment,当前:" SEGMENT_FULL_FORMAT,
                       this->_num_of_segments,
@@ -191,9 +218,30 @@ namespace metaspace {
         return p;
     }
 
-    void Arena::usage_numbers(size_t *used_bytes,
-                              size_t *committed_bytes,
-                              size_t *capacity_bytes) {
+    inline size_t Arena::free_block_bytes() {
+        return this->_block_manager == nullptr ? 0 : this->_block_manager->total_bytes();
+    }
+
+    void Arena::account_free_block_bytes(size_t before) {
+        const auto after = this->free_block_bytes();
+        const auto cm = ContextHolder::context();
+        if (after >= before) {
+            cm->add_arena_free_block_bytes(after - before);
+        } else {
+            cm->sub_arena_free_block_bytes(before - after);
+        }
+    }
+
+    void Arena::adopt_segment(Segment *segment) {
+        assert(segment->is_inuse() && segment->next() == nullptr, "健全");
+        this->_segments.head_add_to_list(segment);
+        ++this->_num_of_segments;
+        ContextHolder::context()->add_arena_used_bytes(segment->used_bytes());
+        meta_log2(debug, "接管:" SEGMENT_FORMAT, SEGMENT_FORMAT_ARGS(segment));
+    }
+
+    void Arena::usage_numbers(ArenaUsage *usage) {
+        assert(usage != nullptr, "must be not null");
         size_t used = 0, committed = 0, capacity = 0;
         auto iter_func = [&](Segment *segment) {
             used += segment->used_bytes();
@@ -202,12 +250,12 @@ namespace metaspace {
             return true;
         };
         this->_segments.node_head_do(iter_func);
-        if (used_bytes)
-            *used_bytes = used;
-        if (committed_bytes)
-            *committed_bytes = committed;
-        if (capacity_bytes)
-            *capacity_bytes = capacity;
+        usage->used_bytes = used;
+        usage->committed_bytes = committed;
+        usage->capacity_bytes = capacity;
+        usage->align_waste_bytes = this->_align_waste_bytes;
+        usage->salvaged_bytes = this->_salvaged_bytes;
+        usage->free_block_bytes = this->free_block_bytes();
     }
 
     void *Arena::allocate_from_block(size_t need_bytes) {
@@ -215,8 +263,10 @@ namespace metaspace {
             return nullptr;
         }
         size_t real_bytes;
+        const auto before = this->_block_manager->total_bytes();
         const auto p = this->_block_manager->allocate(need_bytes, &real_bytes);
         if (p) {
+            this->account_free_block_bytes(before);
             DEBUG_MODE_ONLY(InternalStats::inc_num_allocs_from_blocks_manager();)
             meta_log2(trace, "已从BlockManager申请:" SIZE_FORMAT " byte(实际:" SIZE_FORMAT
                     " byte).现在BlockManager: " SIZE_FORMAT " byte",
@@ -257,7 +307,7 @@ namespace metaspace {
          * 如果当前块不是太小 即 当前块的空闲空间 应该是满足要求的
          * 这是程序逻辑
          */
-        assert(!current_too_small &&
+        assert(current_too_small ||
                current->free_bytes() >= need_bytes, "健全");
         /**
          * 如果当前块空闲大小满足了需求
@@ -289,8 +339,7 @@ namespace metaspace {
          * 2 当前块太小了扩展失败
          * 3 内存提交失败了
          */
-        assert(p == nullptr && (current == nullptr ||
-                                current_too_small || commit_failure),
+        assert(p != nullptr || (current_too_small || commit_failure),
                "健全");
         return p;
     }
@@ -313,10 +362,10 @@ namespace metaspace {
             DEBUG_MODE_ONLY(InternalStats::inc_num_segments_retire();)
         }
         /**
-         * 将新块插入到链表中
-         * 形成新的链表
+         * 将新块插入到链表头部
+         * 链表头部即为正在使用的内存块
          */
-        this->_segments.tail_add_to_list(new_segment);
+        this->_segments.head_add_to_list(new_segment);
         ++this->_num_of_segments;
         /**
          * 接下来我们需要从新的块中再次执行申请
@@ -327,17 +376,10 @@ namespace metaspace {
     }
 
     void Arena::print_on(CharOStream *stream) {
-        size_t calc_used_bytes = 0;
-        size_t calc_reserved_bytes = 0;
-        size_t calc_committed_bytes = 0;
-        this->usage_numbers(&calc_used_bytes,
-                            &calc_committed_bytes,
-                            &calc_reserved_bytes);
-        stream->print_cr("arena : %d segments, total bytes: "
-                         SIZE_FORMAT ", committed bytes: " SIZE_FORMAT,
-                         this->_num_of_segments,
-                         calc_reserved_bytes,
-                         calc_committed_bytes);
+        ArenaUsage usage{};
+        this->usage_numbers(&usage);
+        stream->print("arena : %d segments, ", this->_num_of_segments);
+        usage.print_on(stream);
         stream->cr();
         stream->print_cr("growth-policy " PTR_FORMAT ", block_manager " PTR_FORMAT,
                          this->_policy,
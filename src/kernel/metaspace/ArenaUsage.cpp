@@ -0,0 +1,28 @@
+//
+// Created by aurora on 2026/10/19.
+//
+
+#include "kernel/metaspace/ArenaUsage.hpp"
+#include "plat/stream/CharOStream.hpp"
+
+namespace metaspace {
+    void ArenaUsage::print_on(CharOStream *out) const {
+        out->print_raw("used ");
+        out->print_human_bytes(this->used_bytes);
+        out->print_raw(",committed ");
+        out->print_human_bytes(this->committed_bytes);
+        out->print_raw(",capacity ");
+        out->print_human_bytes(this->capacity_bytes);
+        out->print_raw(",waste ");
+        out->print_human_bytes(this->waste_bytes());
+        out->print_raw("(committed-unused ");
+        out->print_human_bytes(this->committed_unused_bytes());
+        out->print_raw(",free-blocks ");
+        out->print_human_bytes(this->free_block_bytes);
+        out->print_raw(",align ");
+        out->print_human_bytes(this->align_waste_bytes);
+        out->print_raw("),salvaged ");
+        out->print_human_bytes(this->salvaged_bytes);
+        out->print_raw(".");
+    }
+}
@@ -93,7 +93,7 @@ namespace metaspace {
     }
 
     void BlockTree::remove_node_from_tree(BlockTree::Node *node) {
-        assert(node->_next != nullptr, "被删除的节点存在>1的内存块");
+        assert(node->_next == nullptr, "被删除的节点存在>1的内存块");
         if (!node->_left || !node->_right) {
             auto replace = node->_left ? node->_left : node->_right;
             replace_node_in_parent(node, replace);
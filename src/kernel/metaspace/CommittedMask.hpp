@@ -48,7 +48,8 @@ namespace metaspace {
 
             auto bit_no = ((uintptr_t) p - this->_base) /
                           CommittedMask::statistics_bytes_per_bit();
-            assert(this->is_within(bit_no), "is out of committed mask");
+            //区间的结束地址(不含)可以恰好位于映射区间的末尾
+            assert(bit_no <= this->total_bits(), "is out of committed mask");
             return bit_no;
         };
 
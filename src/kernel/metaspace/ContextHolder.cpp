@@ -9,6 +9,9 @@
 #include "Volume.hpp"
 #include "Region.hpp"
 #include "kernel/metaspace/InternalStats.hpp"
+#include "SegmentHeaderPool.hpp"
+#include "plat/os/mem.hpp"
+#include "plat/utils/robust.hpp"
 
 #define LOG_FMT         "ContextHolder @" PTR_FORMAT
 #define LOG_FMT_ARGS    this
@@ -19,7 +22,11 @@ namespace metaspace {
             VolumeList *volume_list) :
             _segment_mgr(segment_mgr),
             _volume_list(volume_list),
-            _used_bytes(0) {
+            _used_bytes(0),
+            _align_waste_bytes(0),
+            _salvaged_bytes(0),
+            _free_block_bytes(0),
+            _inuse_capacity_bytes(0) {
         meta_log(debug, "出生(born)");
     }
 
@@ -37,8 +44,10 @@ namespace metaspace {
     bool ContextHolder::attempt_enlarge_segment(Segment *segment) {
         MutexLocker fcl(Metaspace_lock);
         auto region = segment->container()->region_by_pointer(segment->base());
+        const auto old_bytes = segment->total_bytes();
         bool res = region->attempt_enlarge_segment(segment, this->_segment_mgr);
         if (res) {
+            this->_inuse_capacity_bytes += segment->total_bytes() - old_bytes;
             //增加 扩展的统计信息
             InternalStats::inc_num_segments_enlarged();
             meta_log(debug, "已扩展Segment");
@@ -188,6 +197,7 @@ namespace metaspace {
         assert(segment->used_bytes() == 0, "健全");
         //设置块的状态
         segment->set_inuse();
+        this->_inuse_capacity_bytes += segment->total_bytes();
         meta_log2(debug, "正在分发块 " SEGMENT_FORMAT, SEGMENT_FORMAT_ARGS(segment));
         //统计信息
         InternalStats::inc_num_segments_from_manager();
@@ -237,6 +247,52 @@ namespace metaspace {
         return segment;
     }
 
+    Volume *ContextHolder::add_volume(Space &space) {
+        assert_lock_strong(Metaspace_lock);
+        return this->_volume_list->create_volume_at(space);
+    }
+
+    Segment *ContextHolder::carve_segment(Volume *volume, void *base, SegmentLevel level) {
+        assert_lock_strong(Metaspace_lock);
+        assert(level_is_valid(level), "Segment Level错误");
+        assert_is_aligned((size_t) base, level_to_bytes(level));
+        const auto region = volume->region_by_pointer(base);
+        //根块按照Region的顺序分配 直到目标的Region拥有根块
+        while (region->first_segment() == nullptr) {
+            const auto root = volume->allocate_root_segment();
+            assert(root != nullptr, "目标Region之前不可能用完");
+            this->_segment_mgr->add(root);
+        }
+        //在伙伴链表中寻找包含base的空闲块
+        auto segment = region->first_segment();
+        while (segment != nullptr &&
+               !is_clamp<void *>(base, segment->base(), (void *) ((uintptr_t) segment->end() - 1))) {
+            segment = segment->next_buddy();
+        }
+        if (segment == nullptr || !segment->is_free() || segment->level() > level) {
+            meta_log2(info, "无法切割出segment:" PTR_FORMAT "," SEGMENT_LV_FORMAT, base, level);
+            return nullptr;
+        }
+        this->_segment_mgr->remove(segment);
+        //每次一分为二 目标位于后一半时 继续切割分裂块
+        while (segment->level() < level) {
+            region->split((SegmentLevel) ((SegementLevel_t) segment->level() + 1),
+                          segment, this->_segment_mgr);
+            const auto splinter = segment->next_buddy();
+            if ((uintptr_t) base >= (uintptr_t) splinter->base()) {
+                this->_segment_mgr->remove(splinter);
+                this->_segment_mgr->add(segment);
+                segment = splinter;
+            }
+            InternalStats::inc_num_segments_splits();
+        }
+        assert(segment->base() == base && segment->used_bytes() == 0, "健全");
+        segment->set_inuse();
+        this->_inuse_capacity_bytes += segment->total_bytes();
+        InternalStats::inc_num_segments_from_manager();
+        return segment;
+    }
+
     /**
      * 用于打印的辅助工具
      * @param out
@@ -274,6 +330,8 @@ namespace metaspace {
          * 那么将执行取消映射 释放内存
          */
         const auto max_level = bytes_to_level(CommitGranuleBytes);
+        //不同级别的空闲块可能在地址上相邻 合并之后统一撤销 减少系统调用
+        os::UncommitBatch batch(MEMFLAG::Metaspace, Volume::UncommitType);
         for (SegmentLevel i = SegmentLevel::LV_LOWEST; i <= max_level; i = (SegmentLevel)((SegementLevel_t)i + 1)) {
             /**
              * 因为我们在这个级别取消了所有的数据块，
@@ -282,9 +340,16 @@ namespace metaspace {
             for (auto segment = this->_segment_mgr->first_at_level(i);
                  segment != nullptr;
                  segment = segment->next()) {
-                segment->uncommit();
+                segment->uncommit(&batch);
             }
         }
+        if (!batch.flush()) {
+            vm_exit_out_of_memory(VMErrorType::OOM_MMAP_ERROR,
+                                  CommitGranuleBytes,
+                                  "为元空间(metaspace)撤销提交内存失败");
+        }
+        meta_log2(debug, "撤销提交" SIZE_FORMAT "个区间,合并为" SIZE_FORMAT "次调用",
+                  batch.num_added(), batch.num_calls());
 
 
         const auto reserved_after = this->_volume_list->reserved_bytes();
@@ -311,9 +376,40 @@ namespace metaspace {
         }
     }
 
+    void ContextHolder::arena_usage(ArenaUsage *usage) const {
+        assert(usage != nullptr, "must be not null");
+        size_t free_committed_bytes = 0;
+        {
+            MutexLocker fcl(Metaspace_lock);
+            for (SegmentLevel i = SegmentLevel::LV_LOWEST; i <= SegmentLevel::LV_HIGHEST;
+                 i = (SegmentLevel) ((SegementLevel_t) i + 1)) {
+                free_committed_bytes += this->_segment_mgr->calculate_committed_bytes_at_level(i);
+            }
+            usage->capacity_bytes = this->_inuse_capacity_bytes;
+        }
+        /**
+         * 小于提交粒度的空闲块与伙伴共享提交粒度 它们的已提交字节被低估
+         * 所以使用中的已提交字节不会超过使用中的容量
+         */
+        const auto committed_bytes = this->_volume_list->committed_bytes();
+        usage->committed_bytes = MIN2(usage->capacity_bytes,
+                                      committed_bytes > free_committed_bytes ?
+                                      committed_bytes - free_committed_bytes : 0);
+        usage->used_bytes = OrderAccess::load(&this->_used_bytes);
+        usage->align_waste_bytes = OrderAccess::load(&this->_align_waste_bytes);
+        usage->salvaged_bytes = OrderAccess::load(&this->_salvaged_bytes);
+        usage->free_block_bytes = OrderAccess::load(&this->_free_block_bytes);
+    }
+
     void ContextHolder::print_on(CharOStream *out) const {
         this->_volume_list->print_on(out);
         this->_segment_mgr->print_on(out);
+        SegmentHeaderPool::pool()->print_on(out);
+        ArenaUsage usage{};
+        this->arena_usage(&usage);
+        out->print_raw("Arena: ");
+        usage.print_on(out);
+        out->cr();
     }
 
     void ContextHolder::return_segment_with_lock(Segment *segment) {
@@ -321,6 +417,10 @@ namespace metaspace {
         meta_log2(debug, "正在归还 " SEGMENT_FORMAT, SEGMENT_FORMAT_ARGS(segment));
         assert(segment->is_free() || segment->is_inuse(), "Segment状态错误");
         assert(segment->next() == nullptr, "Segment还在链表中");
+        if (segment->is_inuse()) {
+            assert(this->_inuse_capacity_bytes >= segment->total_bytes(), "健全");
+            this->_inuse_capacity_bytes -= segment->total_bytes();
+        }
         //设置内存块的状态
         segment->set_free();
         segment->reset_used_top();
@@ -10,11 +10,14 @@
 #include "SegmentManager.hpp"
 #include "VolumeList.hpp"
 #include "plat/utils/OrderAccess.hpp"
+#include "kernel/metaspace/ArenaUsage.hpp"
 
 
 namespace metaspace {
     class Segment;
 
+    class Volume;
+
 
     class ContextHolder : public CHeapObject<MEMFLAG::Metaspace> {
     private:
@@ -31,6 +34,16 @@ namespace metaspace {
          * 实际使用的字节，所有的Arena
          */
         volatile size_t _used_bytes;
+        /**
+         * 所有存活Arena的浪费统计的汇总 含义参见ArenaUsage
+         */
+        volatile size_t _align_waste_bytes;
+        volatile size_t _salvaged_bytes;
+        volatile size_t _free_block_bytes;
+        /**
+         * 正在被使用的内存块的总容量 受元空间锁保护
+         */
+        size_t _inuse_capacity_bytes;
 
         /**
          * 在空闲的内存块中搜寻满足要求的
@@ -85,6 +98,30 @@ namespace metaspace {
             OrderAccess::fetch_and_sub(&this->_used_bytes, bytes);
         };
 
+        inline void add_arena_align_waste_bytes(size_t bytes) {
+            OrderAccess::fetch_and_add(&this->_align_waste_bytes, bytes);
+        };
+
+        inline void sub_arena_align_waste_bytes(size_t bytes) {
+            OrderAccess::fetch_and_sub(&this->_align_waste_bytes, bytes);
+        };
+
+        inline void add_arena_salvaged_bytes(size_t bytes) {
+            OrderAccess::fetch_and_add(&this->_salvaged_bytes, bytes);
+        };
+
+        inline void sub_arena_salvaged_bytes(size_t bytes) {
+            OrderAccess::fetch_and_sub(&this->_salvaged_bytes, bytes);
+        };
+
+        inline void add_arena_free_block_bytes(size_t bytes) {
+            OrderAccess::fetch_and_add(&this->_free_block_bytes, bytes);
+        };
+
+        inline void sub_arena_free_block_bytes(size_t bytes) {
+            OrderAccess::fetch_and_sub(&this->_free_block_bytes, bytes);
+        };
+
         static inline ContextHolder *context() {
             assert(_context != nullptr, "未初始化");
             return _context;
@@ -138,6 +175,25 @@ namespace metaspace {
          */
         void purge();
 
+        /**
+         * 使用已经保留的地址空间创建虚拟节点 用于映射元空间的归档
+         * 调用者需要持有元空间锁
+         * @param space 按照RegionBytes对齐
+         * @return
+         */
+        Volume *add_volume(Space &space);
+
+        /**
+         * 在虚拟节点中切割出首地址为base 等级为level的内存块 并设为正在使用
+         * 所在的Region之前的根块按顺序分配 切割出的其余部分交予SegmentManager
+         * 用于映射元空间的归档 调用者需要持有元空间锁
+         * @param volume 通过add_volume创建
+         * @param base 按照level对应的大小对齐 所在的区间必须仍然空闲
+         * @param level 内存块的等级
+         * @return 失败(区间已经被使用)返回nullptr
+         */
+        Segment *carve_segment(Volume *volume, void *base, SegmentLevel level);
+
         /**
          * 统计为元空间保留下来的进程空间
          * 统计的信息来自于 VolumeList
@@ -175,6 +231,14 @@ namespace metaspace {
             return OrderAccess::load(&this->_used_bytes);
         };
 
+        /**
+         * 汇总所有存活Arena的使用情况以及浪费
+         * 已提交的字节 = 总的已提交 - 空闲块持有的已提交
+         * 内部需要获取元空间锁
+         * @param usage 输出的统计结果
+         */
+        void arena_usage(ArenaUsage *usage) const;
+
         /**
          * 打印函数
          * @param out
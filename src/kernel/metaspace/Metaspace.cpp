@@ -10,6 +10,9 @@
 #include "MetaspaceGC.hpp"
 #include "global/flag.hpp"
 #include "kernel/metaspace/CommittedLimiter.hpp"
+#include "kernel/memory/MetaspaceArena.hpp"
+#include "kernel/memory/MetaspaceArchive.hpp"
+#include "kernel_mutex.hpp"
 /**
  * 参数设置规范
  *
@@ -18,6 +21,11 @@
  * MetaspaceSize是初始的大小
  * 这二者的参数是约束提交内存的大小但是无法约束保留的地址空间大小
  */
+os::LargePageMode metaspace::Metaspace::_large_page_mode = os::LargePageMode::off;
+volatile bool metaspace::Metaspace::_initialized = false;
+MetaspaceArena *metaspace::Metaspace::_boot_arena = nullptr;
+void *metaspace::Metaspace::_archive_root = nullptr;
+
 void metaspace::Metaspace::ergo_initialize() {
     meta_log_stream(info);
     metaspace::print_on_using_constants_setting(&log);
@@ -58,6 +66,17 @@ void metaspace::Metaspace::ergo_initialize() {
     global::MinMetaspaceExpansion = align_down_bounded(
             global::MinMetaspaceExpansion,
             commit_granule_bytes);
+    /**
+     * 大页的方式
+     * 提交和撤销以提交粒度为单位 小于大页 无法使用hugetlbfs 只能建议透明大页
+     */
+    guarantee(os::parse_large_page_mode(global::MetaspaceLargePages, &_large_page_mode),
+              "MetaspaceLargePages is error, must be selected from off, thp and hugetlb.");
+    if (_large_page_mode == os::LargePageMode::hugetlb) {
+        log_warn(metaspace)("元空间的提交粒度(" SIZE_FORMAT "K)小于大页,hugetlb按照thp处理.",
+                            commit_granule_bytes / K);
+        _large_page_mode = os::LargePageMode::thp;
+    }
 
 }
 
@@ -68,15 +87,36 @@ void metaspace::Metaspace::global_initialize() {
     //2 初始化内存块头部
     metaspace::SegmentHeaderPool::initialize();
     metaspace::ContextHolder::init_context();
+    //3 根加载器的arena 优先从归档中恢复
+    boot_arena_initialize();
     log_info(metaspace)("[元空间模块]初始化完成.");
 }
 
+void metaspace::Metaspace::boot_arena_initialize() {
+    const auto path = global::MetaspaceArchivePath;
+    if (path != nullptr && *path != '\0') {
+        _boot_arena = MetaspaceArchive::map(path, BootMetaspace_lock, &_archive_root);
+        if (_boot_arena == nullptr) {
+            log_warn(metaspace)("元空间归档%s无法使用,从头构造.", path);
+        }
+    }
+    if (_boot_arena == nullptr) {
+        _archive_root = nullptr;
+        _boot_arena = new MetaspaceArena(MetaspaceType::Boot, BootMetaspace_lock);
+    }
+}
+
 void metaspace::Metaspace::purge() {
     metaspace::ContextHolder::context()->purge();
 }
 
+size_t metaspace::Metaspace::committed_bytes() {
+    return metaspace::ContextHolder::context()->committed_bytes();
+}
+
 void metaspace::Metaspace::post_initialize() {
     MetaspaceGC::post_initialize();
+    OrderAccess::store(&_initialized, true);
 }
 //
 //void print_human_flag(const char *name, const size_t val, OutputStream *out) {
@@ -106,6 +146,11 @@ void metaspace::Metaspace::print_on(CharOStream *out) {
     out->print_raw(",reserved ");
     out->print_human_bytes(context->reserved_bytes());
     out->print_cr(".");
+    metaspace::ArenaUsage usage{};
+    context->arena_usage(&usage);
+    out->print_raw(" [metaspace]:arena ");
+    usage.print_on(out);
+    out->cr();
 }
 
 
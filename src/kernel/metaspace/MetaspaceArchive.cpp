@@ -0,0 +1,305 @@
+//
+// Created by aurora on 2026/10/19.
+//
+
+#include <cstring>
+#include "kernel/memory/MetaspaceArchive.hpp"
+#include "kernel/memory/MetaspaceArena.hpp"
+#include "kernel/metaspace/constants.hpp"
+#include "kernel/metaspace/CommittedLimiter.hpp"
+#include "kernel/utils/Space.hpp"
+#include "kernel/utils/locker.hpp"
+#include "kernel_mutex.hpp"
+#include "Arena.hpp"
+#include "ContextHolder.hpp"
+#include "Segment.hpp"
+#include "Volume.hpp"
+#include "plat/os/mem.hpp"
+#include "plat/os/file.hpp"
+#include "plat/logger/log.hpp"
+
+using namespace metaspace;
+
+static constexpr char ArchiveMagic[4] = {'G', 'M', 'S', 'A'};
+static constexpr uint32_t ArchiveVersion = 1;
+
+struct ArchiveHeader {
+    char _magic[4];
+    uint32_t _version;
+    uint64_t _page_bytes;
+    uint64_t _region_bytes;
+    uint64_t _granule_bytes;
+    uint64_t _volume_bytes;
+    /**
+     * 归档时虚拟节点的首地址 首选的映射地址
+     */
+    uint64_t _base;
+    uint64_t _root;
+    uint64_t _num_segments;
+    uint64_t _num_relocs;
+};
+
+struct ArchiveSegment {
+    uint64_t _offset;
+    uint64_t _level;
+    uint64_t _used;
+    uint64_t _mapped;
+    uint64_t _file_offset;
+};
+
+/**
+ * [offset,offset+bytes)是否完全位于某个内存块已经使用的部分
+ */
+static bool in_used(const ArchiveSegment *segments, size_t num, uint64_t offset, uint64_t bytes) {
+    for (size_t i = 0; i < num; ++i) {
+        if (offset >= segments[i]._offset && offset + bytes <= segments[i]._offset + segments[i]._used) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * 校验文件中的内存块和重定位信息 不修改任何状态
+ */
+static bool verify(const ArchiveHeader &header, const ArchiveSegment *segments,
+                   const uint64_t *relocs, size_t file_bytes) {
+    size_t mapped = 0;
+    for (size_t i = 0; i < header._num_segments; ++i) {
+        const auto &s = segments[i];
+        if (!level_is_valid((SegmentLevel) s._level)) {
+            return false;
+        }
+        const auto total = level_to_bytes((SegmentLevel) s._level);
+        if (total < CommitGranuleBytes || !is_aligned(s._offset, total) ||
+            s._offset + total > header._volume_bytes ||
+            s._used > s._mapped || s._mapped > total || !is_aligned(s._mapped, CommitGranuleBytes) ||
+            !is_aligned(s._file_offset, os::page_size()) || s._file_offset + s._mapped > file_bytes) {
+            return false;
+        }
+        //内存块之间不可以重叠
+        for (size_t k = 0; k < i; ++k) {
+            const auto other_total = level_to_bytes((SegmentLevel) segments[k]._level);
+            if (s._offset < segments[k]._offset + other_total && segments[k]._offset < s._offset + total) {
+                return false;
+            }
+        }
+        mapped += s._mapped;
+    }
+    for (size_t i = 0; i < header._num_relocs; ++i) {
+        if (!is_aligned(relocs[i], sizeof(void *)) ||
+            !in_used(segments, header._num_segments, relocs[i], sizeof(void *))) {
+            return false;
+        }
+    }
+    if (!in_used(segments, header._num_segments, header._root, 1)) {
+        return false;
+    }
+    if (mapped > CommittedLimiter::possible_expand_bytes()) {
+        log_info(metaspace)("metaspace archive needs " SIZE_FORMAT "K, exceeds the commit limit.", mapped / K);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * 保留虚拟节点的地址空间 优先使用归档时的地址
+ */
+static void *reserve_volume(void *preferred) {
+    auto p = os::reserve_memory_at(MEMFLAG::Metaspace, preferred, VolumeDefaultBytes);
+    if (p == preferred) {
+        return p;
+    }
+    if (p != nullptr) {
+        os::release_memory(MEMFLAG::Metaspace, p, VolumeDefaultBytes);
+    }
+    return os::reserve_memory_aligned(MEMFLAG::Metaspace, VolumeDefaultBytes, VolumeDefaultBytes);
+}
+
+bool MetaspaceArchive::dump(const char *path,
+                            MetaspaceArena *arena,
+                            void *root,
+                            void **const *slots,
+                            size_t num_slots) {
+    MutexLocker locker(arena->_mutex);
+    size_t num_segments = 0;
+    Volume *volume = nullptr;
+    bool valid = true;
+    arena->_arena->segments_do([&](Segment *segment) {
+        if (volume == nullptr) {
+            volume = segment->container();
+        }
+        valid = segment->container() == volume && segment->total_bytes() >= CommitGranuleBytes;
+        ++num_segments;
+        return valid;
+    });
+    if (!valid || num_segments == 0) {
+        log_info(metaspace)("metaspace archive: segments must be in one volume and not smaller than the commit granule.");
+        return false;
+    }
+    const auto base = (uintptr_t) volume->base();
+    //元数据之后是按页对齐的内存块数据 链表从当前块开始
+    const auto meta_bytes = sizeof(ArchiveHeader) +
+                            num_segments * sizeof(ArchiveSegment) +
+                            num_slots * sizeof(uint64_t);
+    auto segments = NEW_CHEAP_ARRAY(ArchiveSegment, num_segments, MEMFLAG::Metaspace);
+    auto relocs = NEW_CHEAP_ARRAY(uint64_t, num_slots + 1, MEMFLAG::Metaspace);
+    size_t i = 0;
+    size_t file_bytes = align_up(meta_bytes, os::page_size());
+    arena->_arena->segments_do([&](Segment *segment) {
+        auto &s = segments[i++];
+        s._offset = (uintptr_t) segment->base() - base;
+        s._level = (uint64_t) segment->level();
+        s._used = segment->used_bytes();
+        s._mapped = MIN2(align_up(segment->used_bytes(), CommitGranuleBytes), segment->total_bytes());
+        s._file_offset = file_bytes;
+        file_bytes += s._mapped;
+        return true;
+    });
+    ArchiveHeader header{};
+    ::memcpy(header._magic, ArchiveMagic, sizeof(ArchiveMagic));
+    header._version = ArchiveVersion;
+    header._page_bytes = os::page_size();
+    header._region_bytes = RegionBytes;
+    header._granule_bytes = CommitGranuleBytes;
+    header._volume_bytes = VolumeDefaultBytes;
+    header._base = base;
+    header._root = (uintptr_t) root - base;
+    header._num_segments = num_segments;
+    header._num_relocs = num_slots;
+    //槽位和它们指向的地址都必须位于归档中
+    for (size_t k = 0; k < num_slots && valid; ++k) {
+        relocs[k] = (uintptr_t) slots[k] - base;
+        const auto target = (uintptr_t) *slots[k];
+        valid = in_used(segments, num_segments, relocs[k], sizeof(void *)) &&
+                (target == 0 || in_used(segments, num_segments, target - base, 0));
+    }
+    valid = valid && (uintptr_t) root >= base && in_used(segments, num_segments, header._root, 1);
+    if (!valid) {
+        log_info(metaspace)("metaspace archive: root or pointer slots point outside of the archive.");
+        FREE_CHEAP_ARRAY(segments, MEMFLAG::Metaspace);
+        FREE_CHEAP_ARRAY(relocs, MEMFLAG::Metaspace);
+        return false;
+    }
+    const auto fd = os::open(path, os::fd_write | os::fd_create, file_bytes);
+    valid = fd >= 0;
+    if (valid) {
+        size_t offset = 0;
+        valid = os::write_at(fd, &header, sizeof(header), offset);
+        offset += sizeof(header);
+        valid = valid && os::write_at(fd, segments, num_segments * sizeof(ArchiveSegment), offset);
+        offset += num_segments * sizeof(ArchiveSegment);
+        valid = valid && os::write_at(fd, relocs, num_slots * sizeof(uint64_t), offset);
+        //映射的部分超过已经使用的部分 其中的内容没有意义 之后的申请总会清零
+        for (i = 0; i < num_segments && valid; ++i) {
+            const auto &s = segments[i];
+            valid = os::write_at(fd, (void *) (base + s._offset), s._used, s._file_offset);
+        }
+        os::close(fd);
+    }
+    if (valid) {
+        log_info(metaspace)("metaspace archive dumped to %s: " SIZE_FORMAT " segments, "
+                            SIZE_FORMAT " relocations, " SIZE_FORMAT "K.",
+                            path, num_segments, num_slots, file_bytes / K);
+    } else {
+        log_info(metaspace)("metaspace archive: write %s failed.", path);
+    }
+    FREE_CHEAP_ARRAY(segments, MEMFLAG::Metaspace);
+    FREE_CHEAP_ARRAY(relocs, MEMFLAG::Metaspace);
+    return valid;
+}
+
+MetaspaceArena *MetaspaceArchive::map(const char *path, Mutex *lock, void **root) {
+    size_t file_bytes = 0;
+    if (os::stat(path, &file_bytes) != os::FileType::regular) {
+        return nullptr;
+    }
+    const auto fd = os::open(path, os::fd_read, 0);
+    if (fd < 0) {
+        return nullptr;
+    }
+    ArchiveHeader header{};
+    if (!os::read_at(fd, &header, sizeof(header), 0) ||
+        ::memcmp(header._magic, ArchiveMagic, sizeof(ArchiveMagic)) != 0 ||
+        header._version != ArchiveVersion ||
+        header._page_bytes != (uint64_t) os::page_size() ||
+        header._region_bytes != RegionBytes ||
+        header._granule_bytes != CommitGranuleBytes ||
+        header._volume_bytes != VolumeDefaultBytes ||
+        header._num_segments == 0 ||
+        header._num_segments > VolumeDefaultBytes / CommitGranuleBytes ||
+        header._num_relocs > file_bytes / sizeof(uint64_t)) {
+        log_info(metaspace)("metaspace archive %s is not compatible.", path);
+        os::close(fd);
+        return nullptr;
+    }
+    const auto num_segments = (size_t) header._num_segments;
+    const auto num_relocs = (size_t) header._num_relocs;
+    auto segments = NEW_CHEAP_ARRAY(ArchiveSegment, num_segments, MEMFLAG::Metaspace);
+    auto relocs = NEW_CHEAP_ARRAY(uint64_t, num_relocs + 1, MEMFLAG::Metaspace);
+    auto valid = os::read_at(fd, segments, num_segments * sizeof(ArchiveSegment), sizeof(header)) &&
+                 os::read_at(fd, relocs, num_relocs * sizeof(uint64_t),
+                             sizeof(header) + num_segments * sizeof(ArchiveSegment)) &&
+                 verify(header, segments, relocs, file_bytes);
+    if (!valid) {
+        log_info(metaspace)("metaspace archive %s is corrupted.", path);
+        FREE_CHEAP_ARRAY(segments, MEMFLAG::Metaspace);
+        FREE_CHEAP_ARRAY(relocs, MEMFLAG::Metaspace);
+        os::close(fd);
+        return nullptr;
+    }
+    const auto base = (uintptr_t) reserve_volume((void *) header._base);
+    if (base == 0) {
+        vm_exit_out_of_memory(VMErrorType::OOM_MMAP_ERROR,
+                              VolumeDefaultBytes,
+                              "reserved volume bytes failed.");
+    }
+    auto result = new MetaspaceArena(MetaspaceType::Boot, lock);
+    {
+        MutexLocker fcl(Metaspace_lock);
+        const auto context = ContextHolder::context();
+        Space space((void *) base, VolumeDefaultBytes);
+        const auto volume = context->add_volume(space);
+        //链表从当前块开始 逆序接管之后当前块仍然位于头部
+        for (auto i = num_segments; i > 0 && valid; --i) {
+            const auto &s = segments[i - 1];
+            const auto segment = context->carve_segment(volume, (void *) (base + s._offset),
+                                                        (SegmentLevel) s._level);
+            assert(segment != nullptr, "新的虚拟节点不可能切割失败");
+            if (s._mapped > 0) {
+                valid = volume->map_range(segment->base(), s._mapped, fd, s._file_offset);
+                segment->set_committed_bytes(valid ? s._mapped : 0);
+            }
+            if (valid && s._used > 0) {
+                segment->allocate(s._used);
+            }
+            //失败时也交给arena 随着arena的销毁归还
+            result->_arena->adopt_segment(segment);
+        }
+    }
+    os::close(fd);
+    if (!valid) {
+        log_info(metaspace)("metaspace archive %s: commit limit reached while mapping.", path);
+        delete result;
+        FREE_CHEAP_ARRAY(segments, MEMFLAG::Metaspace);
+        FREE_CHEAP_ARRAY(relocs, MEMFLAG::Metaspace);
+        return nullptr;
+    }
+    //只有写入的页面会被复制
+    const auto delta = base - header._base;
+    if (delta != 0) {
+        for (size_t i = 0; i < num_relocs; ++i) {
+            const auto slot = (uintptr_t *) (base + relocs[i]);
+            if (*slot != 0) {
+                *slot += delta;
+            }
+        }
+    }
+    *root = (void *) (base + header._root);
+    log_info(metaspace)("metaspace archive %s mapped at " PTR_FORMAT "%s: " SIZE_FORMAT " segments, "
+                        SIZE_FORMAT " relocations.",
+                        path, base, delta == 0 ? "" : " (relocated)", num_segments, num_relocs);
+    FREE_CHEAP_ARRAY(segments, MEMFLAG::Metaspace);
+    FREE_CHEAP_ARRAY(relocs, MEMFLAG::Metaspace);
+    return result;
+}
@@ -8,6 +8,7 @@
 #include "global/flag.hpp"
 #include "meta_log.hpp"
 #include "plat/utils/align.hpp"
+#include "kernel_mutex.hpp"
 
 volatile size_t MetaspaceGC::_gc_threshold = 0;
 uint32_t MetaspaceGC::_shrink_factor = 0;
@@ -203,6 +204,25 @@ void MetaspaceGC::global_initialize() {
     MetaspaceGC::_gc_threshold = global::MaxMetaspaceSize;
 }
 
+size_t MetaspaceGC::tighten_threshold() {
+    //提交内存在元空间锁内检查阈值 持有锁保证已提交的字节数不会超过新的阈值
+    MutexLocker locker(Metaspace_lock);
+    const auto committed_bytes = metaspace::ContextHolder::context()->committed_bytes();
+    const auto desired = align_up(committed_bytes + global::MinMetaspaceExpansion,
+                                  metaspace::CommitGranuleBytes);
+    const auto old_gc_threshold = OrderAccess::load(&MetaspaceGC::_gc_threshold);
+    if (desired >= old_gc_threshold) {
+        return old_gc_threshold;
+    }
+    OrderAccess::store(&MetaspaceGC::_gc_threshold, desired);
+    //重新开始缩减的抑制
+    MetaspaceGC::_shrink_factor = 0;
+    log_debug(gc, metaspace)("GC threshold tightened:" SIZE_FORMAT "->" SIZE_FORMAT ".",
+                             old_gc_threshold,
+                             desired);
+    return desired;
+}
+
 bool MetaspaceGC::threshold_with_gc(size_t bytes) {
     bytes = align_up(bytes, metaspace::CommitGranuleBytes);
     //
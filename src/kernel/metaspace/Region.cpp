@@ -86,12 +86,12 @@ namespace metaspace {
              */
             leader->dec_level();
             leader->set_committed_bytes(merged_committed_bytes);
+            //合并后的块总是领导者 跟随者的头部已经归还
+            result_segment = segment = leader;
             //进行中止条件的判断
             if (leader->is_root_segment()) {
                 break;
             }
-            //进行下一次循环
-            result_segment = segment = leader;
         } while (true);
         return result_segment;
     }
@@ -222,7 +222,7 @@ namespace metaspace {
          * 否则提交内存会出现破洞
          */
         if (merged_committed_bytes == segment->total_bytes()) {
-            merged_committed_bytes += segment->committed_bytes();
+            merged_committed_bytes += buddy->committed_bytes();
         }
         //将伙伴块从伙伴关系链表中移除
         auto next = buddy->next_buddy();
@@ -33,6 +33,11 @@ namespace metaspace {
     }
 
     void Segment::clear() {
+        //复用的头部可能残留之前的伙伴关系
+        this->set_prev_buddy(nullptr);
+        this->set_next_buddy(nullptr);
+        this->set_prev(nullptr);
+        this->set_next(nullptr);
         this->_base = 0;
         this->_committed_bytes = this->_used_bytes = 0;
         this->_level = SegmentLevel::LV_ROOT;
@@ -95,20 +100,23 @@ namespace metaspace {
         if(res){
             this->set_committed_bytes(commit_to);
         }
-        return true;
+        return res;
     }
 
     bool Segment::ensure_committed_enough_and_acquire_lock(size_t bytes) {
         bool result = true;
         assert(this->free_bytes() >= bytes, "溢出");
-        if (bytes >= this->free_below_committed_bytes()) {
+        if (bytes > this->free_below_committed_bytes()) {
             MutexLocker fcl(Metaspace_lock);
-            result = this->commit_up_to(bytes);
+            //加锁后再次检查 其他线程可能已经提交了共享的提交粒度
+            if (bytes > this->free_below_committed_bytes()) {
+                result = this->commit_up_to(this->used_bytes() + bytes);
+            }
         }
         return result;
     }
 
-    void Segment::uncommit() {
+    void Segment::uncommit(os::UncommitBatch *batch) {
         assert_lock_strong(Metaspace_lock);
         assert(this->is_free() &&
                this->used_bytes() == 0 &&
@@ -116,7 +124,7 @@ namespace metaspace {
                "仅仅空闲块且尺寸大于提交粒度才允许撤销提交");
         const auto total_bytes = this->total_bytes();
         if (total_bytes >= CommitGranuleBytes) {
-            this->container()->uncommit_range(this->base(), total_bytes);
+            this->container()->uncommit_range(this->base(), total_bytes, batch);
             this->_committed_bytes = 0;
         }
     }
@@ -129,8 +137,8 @@ namespace metaspace {
         bool result = true;
         assert(this->free_bytes() >= bytes, "溢出");
         assert_lock_strong(Metaspace_lock);
-        if (bytes >= this->free_below_committed_bytes()) {
-            result = this->commit_up_to(bytes);
+        if (bytes > this->free_below_committed_bytes()) {
+            result = this->commit_up_to(this->used_bytes() + bytes);
         }
         return result;
     }
@@ -141,7 +149,7 @@ namespace metaspace {
         auto commit_granule = CommitGranuleBytes;
         uintptr_t range_base = align_down((size_t)base,commit_granule);
         uintptr_t range_end = align_up((size_t)base + bytes,commit_granule);
-        assert(bytes > 0 && is_aligned(bytes,commit_granule),"内存大小错误");
+        assert(range_end > range_base && is_aligned(range_end - range_base,commit_granule),"内存大小错误");
         return this->container()->commit_range((void *)range_base,range_end - range_base);
     }
 
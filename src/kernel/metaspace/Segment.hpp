@@ -9,6 +9,10 @@
 #include "kernel/metaspace/constants.hpp"
 #include "plat/utils/align.hpp"
 
+namespace os {
+    class UncommitBatch;
+}
+
 namespace metaspace {
     class Volume;
 
@@ -310,9 +314,10 @@ namespace metaspace {
          */
         [[nodiscard]] bool is_leader() const {
             assert(!this->is_root_segment(), "root segment does not have partner ");
+            //领导者位于伙伴对的低地址 即按照合并后的块大小对齐
             return is_aligned(
                     (size_t) this->base(),
-                    level_to_bytes(this->_level));
+                    this->total_bytes() << 1);
         };
 
         /**
@@ -341,8 +346,9 @@ namespace metaspace {
         /**
          * 将整个内存块的内存撤销提交
          * 这个必须已经获取元空间锁才可以调用
+         * @param batch 不为空时加入批量撤销 见Volume::uncommit_range
          */
-        void uncommit();
+        void uncommit(os::UncommitBatch *batch = nullptr);
 
         /**
          * 打印当前节点的信息
@@ -3,78 +3,128 @@
 //
 
 #include "SegmentHeaderPool.hpp"
+#include "plat/utils/OrderAccess.hpp"
+#include "plat/stream/CharOStream.hpp"
+
 namespace metaspace {
-    SegmentHeaderPool* SegmentHeaderPool::_pool = nullptr;
+    SegmentHeaderPool *SegmentHeaderPool::_pool = nullptr;
+
     SegmentHeaderPool::SegmentHeaderPool() :
-            _slab_nums(0),
-            _first_slab(nullptr),
-            _dead_segments(),
-            _dead_segments_num(0),
-            _slab_top(0),
-            _used_headers(0) {
+            _free_top(0),
+            _current_slab(nullptr),
+            _live_headers(0),
+            _free_headers(0),
+            _slab_nums(0) {
 
     }
 
     SegmentHeaderPool::~SegmentHeaderPool() {
-        auto slab = this->_first_slab;
+        auto slab = this->_current_slab;
         while (slab) {
             auto next = slab->_next;
-            delete slab;
+            slab->~Slab();
+            CHEAP_FREE(MEMFLAG::Metaspace, slab);
             slab = next;
         }
         SegmentHeaderPool::_pool = nullptr;
     }
 
-    void SegmentHeaderPool::allocate_new_slab() {
-        auto slab = new Slab();
-        slab->_next = this->_first_slab;
-        this->_first_slab = slab;
-        ++this->_slab_nums;
-        this->_slab_top = 0;
+    Segment *SegmentHeaderPool::pop_free() {
+        auto top = OrderAccess::load(&this->_free_top);
+        while (true) {
+            const auto head = untag(top);
+            if (head == nullptr) {
+                return nullptr;
+            }
+            /**
+             * head可能已经被其他线程弹出并再次使用 此时读到的next是脏数据
+             * 但由于版本号已经变化 下面的CAS必然失败
+             */
+            const auto next = head->next();
+            const auto witness = OrderAccess::cas(&this->_free_top, top, make_tag(next, top));
+            if (witness == top) {
+                OrderAccess::fetch_and_sub(&this->_free_headers, 1);
+                head->set_next(nullptr);
+                return head;
+            }
+            top = witness;
+        }
+    }
+
+    Segment *SegmentHeaderPool::allocate_from_slab() {
+        while (true) {
+            const auto slab = OrderAccess::load(&this->_current_slab);
+            if (slab != nullptr) {
+                const auto index = OrderAccess::fetch_and_add(&slab->_top, 1);
+                if (index < SlabCapacity) {
+                    return slab->_elems + index;
+                }
+            }
+            /**
+             * 当前没有Slab或者已经使用完毕了 那么就需要申请一个新的
+             * 新的Slab的第0个元素直接留给自己
+             */
+            const auto mem = CHEAP_ALLOC_ALIGN(MEMFLAG::Metaspace, sizeof(Slab), alignof(Slab));
+            const auto new_slab = ::new(mem) Slab(slab, 1);
+            if (OrderAccess::cas(&this->_current_slab, slab, new_slab) == slab) {
+                OrderAccess::fetch_and_add(&this->_slab_nums, 1);
+                return new_slab->_elems;
+            }
+            //其他线程已经安装了新的Slab 放弃本次申请的
+            new_slab->~Slab();
+            CHEAP_FREE(MEMFLAG::Metaspace, mem);
+        }
     }
 
     Segment *SegmentHeaderPool::allocate_segment_header() {
         /**
-         * 首先从_dead_chunk中获取
+         * 首先从死亡头部形成的栈中获取
          */
-        Segment *chunk_head = nullptr;
-        if (!this->_dead_segments.is_empty()) {
-            //存在死亡的内存块
-            chunk_head = this->_dead_segments.delete_from_list_head();
-            --this->_dead_segments_num;
+        auto chunk_head = this->pop_free();
+        if (chunk_head != nullptr) {
             //获取到了 但是我们需要进行数据的擦除 给与一个干净的头部
             chunk_head->clear();
-        }
-        assert(chunk_head == nullptr || chunk_head->is_dead(), "错误");
-        if (chunk_head == nullptr) {
+        } else {
             //没有现成可用的Dead内存块 那么就需要从Slab中申请
-            if (this->_first_slab == nullptr ||
-                this->_slab_top == SlabCapacity) {
-                //如果当前没有Slab或者已经使用完毕了 那么就需要申请一个新的
-                this->allocate_new_slab();
-                assert(this->_slab_top == 0,"错误");
-            }
-            //申请 并调整ID
-            chunk_head = this->_first_slab->_elems + this->_slab_top;
-            ++this->_slab_top;
+            chunk_head = this->allocate_from_slab();
         }
-        assert(chunk_head->is_dead(),"ChunkHeader状态设置错误");
-        this->_used_headers++;
+        assert(chunk_head->is_dead(), "ChunkHeader状态设置错误");
+        OrderAccess::fetch_and_add(&this->_live_headers, 1);
         //将内存块头部的状态设置为空闲
         chunk_head->set_free();
         return chunk_head;
     }
 
     void SegmentHeaderPool::deallocate_segment_header(Segment *chunk) {
-        assert(chunk!= nullptr&&chunk->is_free(),"错误");
+        assert(chunk != nullptr && chunk->is_free(), "错误");
+        assert(((uintptr_t) chunk & ~PtrMask) == 0, "地址超出了可以携带版本号的范围");
         chunk->set_dead();
-        this->_dead_segments.head_add_to_list(chunk);
-        ++this->_dead_segments_num;
-        --this->_used_headers;
+        auto top = OrderAccess::load(&this->_free_top);
+        while (true) {
+            chunk->set_next(untag(top));
+            const auto witness = OrderAccess::cas(&this->_free_top, top, make_tag(chunk, top));
+            if (witness == top) {
+                break;
+            }
+            top = witness;
+        }
+        OrderAccess::fetch_and_add(&this->_free_headers, 1);
+        OrderAccess::fetch_and_sub(&this->_live_headers, 1);
+    }
+
+    void SegmentHeaderPool::print_on(CharOStream *out) const {
+        out->print_cr("SegmentHeaderPool: live %d,free %d,slab %d(" SIZE_FORMAT " bytes).",
+                      this->live_headers(),
+                      this->free_headers(),
+                      this->slab_nums(),
+                      (size_t) this->slab_nums() * sizeof(Slab));
     }
 
     void SegmentHeaderPool::initialize() {
         assert(SegmentHeaderPool::_pool == nullptr, "ChunkHeaderPool仅仅可以初始化一次");
-        SegmentHeaderPool::_pool = new SegmentHeaderPool();
+        const auto mem = CHEAP_ALLOC_ALIGN(MEMFLAG::Metaspace,
+                                           sizeof(SegmentHeaderPool),
+                                           alignof(SegmentHeaderPool));
+        SegmentHeaderPool::_pool = ::new(mem) SegmentHeaderPool();
     }
-}
\ No newline at end of file
+}
@@ -6,50 +6,84 @@
 #define KERNEL_METASPACE_SEGMENT_HEADER_POOL_HPP
 
 #include "plat/mem/allocation.hpp"
+#include "plat/constants.hpp"
+#include "plat/utils/OrderAccess.hpp"
 #include "Segment.hpp"
-#include "kernel/utils/LinkedList.hpp"
 
+class CharOStream;
 namespace metaspace {
     /**
      * 用于管理所有的Segment的内存块头部信息，即这个对象本身
+     *
+     * 分配和归还都是无锁的:
+     * 1 归还的头部进入 Treiber 栈(_free_top)，栈顶指针的高位携带版本号，用于避免ABA问题
+     * 2 栈为空时 从当前Slab中以原子加的方式切分，Slab用尽时通过CAS安装新的Slab
+     * Slab申请后不会被释放(直到池被销毁)，因此并发读取已出栈节点的_next是安全的
      */
     class SegmentHeaderPool : public CHeapObject<MEMFLAG::Metaspace> {
     private:
         constexpr inline static int SlabCapacity = 128;
+        /**
+         * 栈顶指针的低 TagShift 位存放地址，高位存放版本号
+         * 用户态地址空间不会超过48位
+         */
+        constexpr inline static int TagShift = 48;
+        constexpr inline static uintptr_t PtrMask = (uintptr_t(1) << TagShift) - 1;
 
-        struct Slab : public CHeapObject<MEMFLAG::Metaspace> {
+        struct alignas(CacheLineBytes) Slab {
+            /**
+             * _next 指向上一个被安装的Slab 用于释放内存时候使用
+             * _top 下一次切分的索引，可能超过SlabCapacity，超过表示已经用尽
+             */
             Slab *_next;
+            volatile int _top;
             Segment _elems[SlabCapacity];
-            explicit Slab() :
-                    _next(nullptr),
+
+            explicit Slab(Slab *next, int top) :
+                    _next(next),
+                    _top(top),
                     _elems() {
             };
         };
 
         /**
+         * 频繁修改的字段分别独占缓存行 避免伪共享
+         * _free_top 归还头部形成的栈 带版本号
+         * _current_slab 正在切分的Slab，它的_next串联之前所有用尽的Slab
+         * _live_headers 被使用的内存块头部的数量
+         * _free_headers 位于栈中的头部的数量
          * _slab_nums 表示当前总共申请得到Slab的数量
-         * _dead_segments_num 表示其管理的MetaChunk数量，即 _dead_chunk 形成链表的长度
-         * _slab_top 表示下一次申请内存块头部信息时候，位于Slab::_elems的索引
-         *              即下一次的内存块头部 是 Slab->elems[_slab_top]
-         *  _used_headers 被使用的内存块头部的数量
-         *  _first_slab 表示Slab形成的链表用于释放内存时候使用
-         *              这个链表中第一块是正在使用的 之后的都是被使用完毕的
          */
-        int _slab_nums;
-        int _dead_segments_num;
-        int _slab_top;
-        int _used_headers;
-        LinkList<Segment> _dead_segments;
-        Slab *_first_slab;
+        alignas(CacheLineBytes) volatile uintptr_t _free_top;
+        alignas(CacheLineBytes) Slab *volatile _current_slab;
+        alignas(CacheLineBytes) volatile int _live_headers;
+        volatile int _free_headers;
+        volatile int _slab_nums;
+
+        static SegmentHeaderPool *_pool;
+
+        explicit SegmentHeaderPool();
+
+        static inline Segment *untag(uintptr_t top) {
+            return (Segment *) (top & PtrMask);
+        };
+
+        static inline uintptr_t make_tag(Segment *segment, uintptr_t old_top) {
+            const auto version = (old_top >> TagShift) + 1;
+            return (version << TagShift) | (uintptr_t) segment;
+        };
 
         /**
-         * 申请得到一块新的Slab内存
+         * 从栈中弹出一个头部
+         * @return 栈为空时返回null
          */
-        void allocate_new_slab();
+        Segment *pop_free();
 
-        static SegmentHeaderPool *_pool;
+        /**
+         * 从Slab中切分一个头部 必要时申请新的Slab
+         */
+        Segment *allocate_from_slab();
 
-        explicit SegmentHeaderPool();
     public:
         /**
          * 析构函数 释放申请到的内存
@@ -71,6 +105,24 @@ namespace metaspace {
          */
         void deallocate_segment_header(Segment *chunk);
 
+        [[nodiscard]] inline int live_headers() const {
+            return OrderAccess::load(&this->_live_headers);
+        };
+
+        [[nodiscard]] inline int free_headers() const {
+            return OrderAccess::load(&this->_free_headers);
+        };
+
+        [[nodiscard]] inline int slab_nums() const {
+            return OrderAccess::load(&this->_slab_nums);
+        };
+
+        /**
+         * 输出头部池的统计信息
+         * @param out
+         */
+        void print_on(CharOStream *out) const;
+
         /**
          * 获取内存块头部的池
          * @return
@@ -128,11 +128,14 @@ namespace metaspace {
         };
         list->node_head_do(find_func);
         list->add_to_list_target(insert_target, segment, false);
+        ++this->_num_segments_at_level[(SegementLevel_t)segment->level()];
     }
 
     void SegmentManager::remove(Segment *segment) {
         auto list = this->list_for_level(segment->level());
         list->delete_from_list(segment);
+        assert(this->_num_segments_at_level[(SegementLevel_t)segment->level()] > 0, "计数错误");
+        --this->_num_segments_at_level[(SegementLevel_t)segment->level()];
     }
 
     bool SegmentManager::contain(Segment *segment) {
@@ -148,7 +148,35 @@ namespace metaspace {
         return true;
     }
 
-    void Volume::uncommit_range(void* p, size_t bytes) {
+    bool Volume::map_range(void *p, size_t bytes, int32_t fd, size_t offset) {
+        assert_is_aligned((size_t) p, CommitGranuleBytes);
+        assert(bytes > 0 && is_aligned(bytes, CommitGranuleBytes),
+               "映射区间大小非法");
+        assert_lock_strong(Metaspace_lock);
+        assert(this->_commit_mask.get_committed_bytes_in_range(p, bytes) == 0,
+               "映射的区间不可以已经提交");
+        if (CommittedLimiter::possible_expand_bytes() < bytes) {
+            meta_log2(debug, "!!达到限制!!无法映射:[" PTR_FORMAT "," PTR_FORMAT "),"
+                    SIZE_FORMAT "K.",
+                      p, (void *)((uintptr_t)p + bytes), bytes / K);
+            return false;
+        }
+        if (!os::map_memory(MEMFLAG::Metaspace, p, bytes, fd, offset, os::CommitType::rwx)) {
+            vm_exit_out_of_memory(VMErrorType::OOM_MMAP_ERROR,
+                                  bytes,
+                                  "为元空间(metaspace)映射归档失败");
+        }
+        meta_log2(debug, "映射:[" PTR_FORMAT "," PTR_FORMAT "),"
+                SIZE_FORMAT "K,文件偏移" SIZE_FORMAT ".",
+                  p, (void *)((uintptr_t)p + bytes), bytes / K, offset);
+        CommittedLimiter::increase_committed_bytes(bytes);
+        *this->_committed_statistics += bytes;
+        this->_commit_mask.mark_range_as_committed(p, bytes);
+        InternalStats::inc_num_range_committed();
+        return true;
+    }
+
+    void Volume::uncommit_range(void* p, size_t bytes, os::UncommitBatch *batch) {
         /**
          * 首先校验要提交区间的首地址和区间大小
          * 必须都要和内存的提交粒度对齐
@@ -174,7 +202,10 @@ namespace metaspace {
         /**
          * 下面开始实际上的取消提交
          */
-        if (!os::uncommit_memory(MEMFLAG::Metaspace,p, bytes)) {
+        const auto success = batch == nullptr ?
+                             os::uncommit_memory(MEMFLAG::Metaspace, p, bytes, Volume::UncommitType) :
+                             batch->add(p, bytes);
+        if (!success) {
             /**
              * 如果 提交失败 那么直接中止
              * 这个的确是可能发生的 因为撤销内存提交会导致映射增加
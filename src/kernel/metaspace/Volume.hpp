@@ -9,6 +9,7 @@
 #include "kernel/utils/Space.hpp"
 #include "CommittedMask.hpp"
 #include "Region.hpp"
+#include "plat/os/mem.hpp"
 
 namespace metaspace {
     class Segment;
@@ -21,6 +22,12 @@ namespace metaspace {
      * 基于伙伴分配算法 应该是Root Segment的整数倍
      */
     class Volume : public CHeapObject<MEMFLAG::Metaspace> {
+    public:
+        /**
+         * 撤销提交的方式 空闲块很快会被重新提交
+         * 保留映射 避免每次撤销都分裂映射(VMA) 重新提交时mprotect也不会改变权限
+         */
+        constexpr inline static os::UncommitType UncommitType = os::UncommitType::dontneed;
     private:
         /**
          * 指向下一个 虚拟节点，用于维持链表
@@ -108,6 +115,14 @@ namespace metaspace {
             return this->_commit_mask.get_committed_bytes();
         };
 
+        /**
+         * 获取Volume覆盖的地址空间的首地址
+         * @return
+         */
+        [[nodiscard]] inline void *base() const {
+            return this->_reserved.start();
+        };
+
         /**
          * 获取Volume覆盖的地址空间的大小
          * @return
@@ -160,12 +175,24 @@ namespace metaspace {
          */
         bool commit_range(void* p, size_t bytes);
 
+        /**
+         * 将文件的一段以写时复制的方式映射到[p,p+bytes) 统计上与commit_range相同
+         * 区间必须完全未提交 用于映射元空间的归档
+         * @param p 与提交粒度(CommitGranuleBytes)对齐
+         * @param bytes 与提交粒度(CommitGranuleBytes)对齐
+         * @param fd 归档文件
+         * @param offset 文件中的偏移 按页对齐
+         * @return 达到提交的限制时返回false
+         */
+        bool map_range(void *p, size_t bytes, int32_t fd, size_t offset);
+
         /**
          * 将[p,p+bytes)区间的内存释放掉
          * @param p
          * @param bytes
+         * @param batch 不为空时只加入批量撤销 由调用者统一执行 统计信息立即更新 撤销方式应当是UncommitType
          */
-        void uncommit_range(void* p, size_t bytes);
+        void uncommit_range(void* p, size_t bytes, os::UncommitBatch *batch = nullptr);
 
         /**
          * 是否包含指定的虚拟地址
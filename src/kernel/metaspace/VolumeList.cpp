@@ -3,6 +3,7 @@
 //
 #include "plat/os/mem.hpp"
 #include "VolumeList.hpp"
+#include "Metaspace.hpp"
 #include "Volume.hpp"
 #include "kernel_mutex.hpp"
 #include "meta_log.hpp"
@@ -28,13 +29,22 @@ namespace metaspace {
                                   VolumeDefaultBytes,
                                   "reserved volume bytes failed.");
         }
+        if (Metaspace::large_page_mode() == os::LargePageMode::thp) {
+            //虚拟节点按照自身大小对齐 大于大页 按照提交粒度提交后由内核合并
+            os::advise_huge_pages(ptr, VolumeDefaultBytes, true);
+        }
         Space space(ptr, VolumeDefaultBytes);
+        this->create_volume_at(space);
+    }
+
+    Volume *VolumeList::create_volume_at(Space &space) {
+        assert_lock_strong(Metaspace_lock);
         this->_reserved_bytes += space.capacity_bytes();
         auto volume = new Volume(space, &this->_committed_bytes);
         volume->set_next(this->_list_head);
         this->_list_head = volume;
-        //更新信息
         ++this->_list_length;
+        return volume;
     }
 
     VolumeList::~VolumeList() {
@@ -7,6 +7,8 @@
 
 #include "plat/mem/allocation.hpp"
 
+class Space;
+
 namespace metaspace {
     class Volume;
     class Segment;
@@ -71,6 +73,14 @@ namespace metaspace {
          */
         ~VolumeList();
 
+        /**
+         * 使用已经保留的地址空间创建虚拟节点 用于映射元空间的归档
+         * 新的节点位于链表头部 剩余的根块之后可以正常分配
+         * @param space 按照RegionBytes对齐
+         * @return
+         */
+        Volume *create_volume_at(Space &space);
+
         /**
          * 分配一个根块
          * @return 失败 nullptr
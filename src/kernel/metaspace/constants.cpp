@@ -13,7 +13,7 @@ namespace metaspace {
             return SegmentLevel::LV_HIGHEST;
         }
         size_t aligned_bytes = round_up_power_of_2(bytes);
-        auto level =  (SegementLevel_t)SegmentLevel::LV_NUM - 1 - log2i_exact<size_t>(aligned_bytes);
+        auto level = log2i_exact<size_t>(RegionBytes) - log2i_exact<size_t>(aligned_bytes);
         return (SegmentLevel) level;
     }
 
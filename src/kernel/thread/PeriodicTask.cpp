@@ -6,6 +6,11 @@
 #include "kernel_mutex.hpp"
 #include "kernel/thread/PlatThread.hpp"
 #include "kernel/constants.hpp"
+#include "MemoryTracer.hpp"
+#include "MemoryPressureMonitor.hpp"
+#include "plat/logger/log.hpp"
+#include "global/flag.hpp"
+#include "plat/os/time.hpp"
 uint16_t PeriodicTask::_num_of_tasks = 0;
 PeriodicTask *PeriodicTask::_tasks[ KernelConstants::PeriodicTaskMaxNum];
 
@@ -76,3 +81,161 @@ void PeriodicTask::start_arena_clean_task() {
     const auto  task = new ArenaChunkPoolCleanTask();
     task->activate();
 }
+
+/**
+ * ------------------
+ *  内存追踪缓冲区写出的定时任务 NMTDrain
+ * ------------------
+ */
+class NMTDrainTask : public PeriodicTask {
+protected:
+
+    inline void task() override {
+        MemoryTracer::drain();
+    }
+
+public:
+    inline explicit NMTDrainTask() :
+            PeriodicTask(KernelConstants::PeriodicTaskNMTDrainInterval) {
+    }
+};
+
+void PeriodicTask::start_nmt_drain_task() {
+    if (MemoryTracer::nmt_level() != MemoryTracer::NMT_Level::detail) {
+        return;
+    }
+    const auto task = new NMTDrainTask();
+    task->activate();
+}
+
+/**
+ * ------------------
+ *  按照毫秒指定间隔的定时任务
+ *  超过最大间隔时 按照较短的周期执行 每执行_every次处理一次
+ * ------------------
+ */
+class ThrottledPeriodicTask : public PeriodicTask {
+private:
+    const uint32_t _every;
+    uint32_t _count;
+
+    /**
+     * 将毫秒的间隔换算为定时任务的周期数 不小于最小间隔
+     */
+    static inline uint32_t units_of(uint32_t interval_ms) {
+        return MAX2(interval_ms / KernelConstants::PeriodicTaskInternalUnit,
+                    KernelConstants::PeriodicTaskMinInterval);
+    }
+
+    /**
+     * 向上取整 保证每次的间隔不超过最大值
+     */
+    static inline uint32_t every_of(uint32_t interval_ms) {
+        return (units_of(interval_ms) + KernelConstants::PeriodicTaskMaxInterval - 1) /
+               KernelConstants::PeriodicTaskMaxInterval;
+    }
+
+protected:
+    /**
+     * 每经过指定的间隔执行一次
+     */
+    virtual void throttled_task() = 0;
+
+    inline void task() final {
+        if (++this->_count < this->_every) {
+            return;
+        }
+        this->_count = 0;
+        this->throttled_task();
+    }
+
+public:
+    inline explicit ThrottledPeriodicTask(uint32_t interval_ms) :
+            PeriodicTask(units_of(interval_ms) / every_of(interval_ms)),
+            _every(every_of(interval_ms)),
+            _count(0) {
+    }
+};
+
+/**
+ * ------------------
+ *  内存追踪相对于基线的变化的定时任务 NMTDiff
+ * ------------------
+ */
+class NMTDiffTask : public ThrottledPeriodicTask {
+protected:
+
+    inline void throttled_task() override {
+        //日志的行缓冲区可能在资源区域中扩展
+        ResourceArenaMark mark;
+        log_stream(info, nmt);
+        if (log.is_enable()) {
+            MemoryTracer::print_diff(&log, global::NMTDiffThreshold);
+        }
+    }
+
+public:
+    inline explicit NMTDiffTask(uint32_t interval_ms) :
+            ThrottledPeriodicTask(interval_ms) {
+    }
+};
+
+void PeriodicTask::start_nmt_diff_task() {
+    if (global::NMTDiffInterval == 0 || !MemoryTracer::baseline()) {
+        return;
+    }
+    const auto task = new NMTDiffTask(global::NMTDiffInterval);
+    task->activate();
+}
+
+/**
+ * ------------------
+ *  采样系统内存压力的定时任务 MemoryPressure
+ * ------------------
+ */
+class MemoryPressureTask : public ThrottledPeriodicTask {
+protected:
+
+    inline void throttled_task() override {
+        MemoryPressureMonitor::sample();
+    }
+
+public:
+    inline explicit MemoryPressureTask(uint32_t interval_ms) :
+            ThrottledPeriodicTask(interval_ms) {
+    }
+};
+
+/**
+ * ------------------
+ *  校准TSC时钟的定时任务 ClockSync
+ * ------------------
+ */
+class ClockSyncTask : public ThrottledPeriodicTask {
+protected:
+
+    inline void throttled_task() override {
+        os::clock_resync();
+    }
+
+public:
+    inline explicit ClockSyncTask(uint32_t interval_ms) :
+            ThrottledPeriodicTask(interval_ms) {
+    }
+};
+
+void PeriodicTask::start_clock_sync_task() {
+    if (global::ClockSyncInterval == 0 || os::clock_source() != os::ClockSource::tsc) {
+        return;
+    }
+    const auto task = new ClockSyncTask(global::ClockSyncInterval);
+    task->activate();
+}
+
+void PeriodicTask::start_memory_pressure_task() {
+    if (global::MemoryPressureInterval == 0) {
+        return;
+    }
+    const auto task = new MemoryPressureTask(global::MemoryPressureInterval);
+    task->activate();
+}
@@ -18,9 +18,10 @@ void PeriodicThread::create() {
     PeriodicThread::_should_terminate = false;
     assert(PeriodicThread::periodic_thread() == nullptr, "must be");
     const auto thread = new PeriodicThread();
-    if (os::create_thread(thread)) {
-        PeriodicThread::_periodic_thread = thread;
-    } else {
+    //线程启动后会立即检查自身 所以需要先发布
+    OrderAccess::store(&PeriodicThread::_periodic_thread, thread);
+    if (!os::create_thread(thread)) {
+        OrderAccess::store(&PeriodicThread::_periodic_thread, (PeriodicThread *) nullptr);
         delete thread;
     }
 
@@ -83,13 +84,13 @@ uint32_t PeriodicThread::calculate_next_task_interval() {
     auto remains = PeriodicThread::min_task_interval();
     uint32_t time_next_interval;
     //GC前获取时间戳
-    auto time_before_loop = os::current_stamp();
+    auto time_before_loop = os::monotonic_stamp();
 
     while (true) {
         //等待一会
         bool timeout = lock.wait(remains);
         //再次获取当前的时间
-        const auto now = os::current_stamp();
+        const auto now = os::monotonic_stamp();
         if (remains == 0) {
             /**
              * 如果我们没有任何任务，可能会等待很长时间，
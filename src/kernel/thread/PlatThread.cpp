@@ -4,8 +4,17 @@
 #include "kernel/thread/PlatThread.hpp"
 #include "plat/utils/OrderAccess.hpp"
 #include "kernel_mutex.hpp"
+#include "plat/logger/log.hpp"
+#include "global/flag.hpp"
 PlatThread *volatile PlatThread::_user_thread_list = nullptr;
 PlatThread *volatile PlatThread::_daemon_thread_list = nullptr;
+
+/**
+ * 内部线程绑定的CPU 为空表示不绑定
+ */
+static os::CpuSet _internal_cpus;
+static os::SchedPolicy _vm_thread_policy = os::SchedPolicy::other;
+static os::SchedPolicy _periodic_thread_policy = os::SchedPolicy::other;
 void PlatThread::add_to_list() {
     PlatThread *volatile *list_ptr;
     if (this->is_user_thread()) {
@@ -40,7 +49,7 @@ void PlatThread::remove_from_list() {
             if (prev == nullptr) {
                 OrderAccess::store(list_ptr, next);
             } else {
-                OrderAccess::store<PlatThread *>(&this->_next, next);
+                OrderAccess::store<PlatThread *>(&prev->_next, next);
             }
             break;
         }
@@ -69,8 +78,56 @@ PlatThread::PlatThread() :
 void PlatThread::pre_run() {
     assert(this->is_daemon_thread() ^ this->is_user_thread(), "Thread类型错误");
     auto lock = this->is_user_thread() ? LangThreadList_lock : NonLangThreadList_lock;
-    MutexLocker locker(lock);
-    this->add_to_list();
+    {
+        MutexLocker locker(lock);
+        this->add_to_list();
+    }
+    this->apply_placement();
+}
+
+void PlatThread::placement_initialize() {
+    guarantee(os::parse_sched_policy(global::VMThreadSchedPolicy, &_vm_thread_policy),
+              "VMThreadSchedPolicy is error, must be selected from other, batch and fifo.");
+    guarantee(os::parse_sched_policy(global::PeriodicThreadSchedPolicy, &_periodic_thread_policy),
+              "PeriodicThreadSchedPolicy is error, must be selected from other, batch and fifo.");
+    _internal_cpus.clear();
+    if (global::InternalThreadCpus[0] == '\0') {
+        return;
+    }
+    guarantee(_internal_cpus.parse_list(global::InternalThreadCpus),
+              "InternalThreadCpus is error, must be a cpu list like 0-1,4.");
+    _internal_cpus.intersect(os::allowed_cpus());
+    if (_internal_cpus.is_empty()) {
+        log_warn(thread)("InternalThreadCpus(%s)中没有允许使用的CPU,内部线程不绑定CPU.",
+                         global::InternalThreadCpus);
+    }
+}
+
+void PlatThread::apply_placement() {
+    auto policy = os::SchedPolicy::other;
+    const auto internal = this->is_VM_thread() || this->is_watcher_thread();
+    if (this->is_VM_thread()) {
+        policy = _vm_thread_policy;
+    } else if (this->is_watcher_thread()) {
+        policy = _periodic_thread_policy;
+    }
+    if (!_internal_cpus.is_empty()) {
+        auto cpus = _internal_cpus;
+        if (!internal) {
+            //语言线程避开内部线程的CPU 全部被保留时不做限制
+            cpus = os::allowed_cpus();
+            cpus.subtract(_internal_cpus);
+        }
+        const auto bind = internal || (this->is_user_thread() && global::ReserveInternalThreadCpus);
+        if (bind && !cpus.is_empty() && this->set_affinity(cpus) != OSReturn::OK) {
+            log_warn(thread)("%s绑定CPU失败.", this->name());
+        }
+    }
+    if (policy != os::SchedPolicy::other &&
+        this->set_sched_policy(policy, global::InternalThreadRealtimePriority) != OSReturn::OK) {
+        log_warn(thread)("%s设置调度策略%s失败,可能缺少CAP_SYS_NICE.",
+                         this->name(), os::sched_policy_name(policy));
+    }
 }
 
 void PlatThread::post_run() {
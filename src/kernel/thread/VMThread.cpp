@@ -25,11 +25,9 @@ void VMThread::run() {
 
 void VMThread::create() {
     const auto thread = new VMThread();
-    if (os::create_thread(thread)) {
-        VMThread::_vm_thread = thread;
-    } else {
-        guarantee(false, "init failed");
-    }
+    //线程启动后可能立即访问VMThread::vm_thread() 所以需要先发布
+    VMThread::_vm_thread = thread;
+    guarantee(os::create_thread(thread), "init failed");
 }
 
 void VMThread::destroy() {
@@ -15,6 +15,7 @@
 volatile SafepointSynchronize::SynchronizeState SafepointSynchronize::_state =
         SynchronizeState::not_synchronized;
 TimeStamp SafepointSynchronize::_beg_time;
+TimeStamp SafepointSynchronize::_sync_time;
 TimeStamp SafepointSynchronize::_end_time;
 WaitBarrier SafepointSynchronize::_wait_barrier;
 volatile int32_t SafepointSynchronize::_safe_point_check = 0;
@@ -24,7 +25,7 @@ void SafepointSynchronize::begin() {
     assert(state() == SynchronizeState::not_synchronized, "应未设置同步才可以开始");
     assert(PlatThread::current()->is_VM_thread(), "仅仅VMThread可以调用");
     //开始记录时间
-    _beg_time.update_realtime_ticks();
+    _beg_time.update_monotonic_ticks();
     /**
      * 调用 LangThreadList_lock
      * 我们确保从此刻到退出安全点期间没有LangThread被创建和销毁
@@ -53,6 +54,7 @@ void SafepointSynchronize::begin() {
                         init_running,
                         iteration);
     assert(LangThreadList_lock->owned_by_self(), "我们必须持有这个锁");
+    _sync_time.update_monotonic_ticks();
     OrderAccess::store(&_state, SynchronizeState::synchronized);
 }
 
@@ -69,12 +71,13 @@ void SafepointSynchronize::end() {
     /**
      * 释放Lang线程创建和销毁的锁 允许语言层面的线程创建和销毁
      */
-    LangThreadList_lock->lock();
+    LangThreadList_lock->unlock();
 
     //唤醒所有等待在_wait_barrier上的锁
     _wait_barrier.disarm();
-    _end_time.update_realtime_ticks();
-    log_info(safepoint)("safepoint持续时间:%ld ns.",
+    _end_time.update_monotonic_ticks();
+    log_info(safepoint)("safepoint同步耗时:%ld ns,持续时间:%ld ns.",
+                        _sync_time.during_ns(_beg_time),
                         _end_time.during_ns(_beg_time));
 }
 
@@ -101,7 +104,7 @@ int SafepointSynchronize::synchronize_threads(
      * 我们需要自旋 进行等待
      */
     assert(still_running_list != nullptr, "异常");
-    const auto start_time = os::current_stamp();
+    const auto start_time = os::monotonic_stamp();
     do {
         closure.clear();
         PlatThread::thread_do(&still_running_list,&closure);
@@ -130,7 +133,7 @@ void SafepointSynchronize::back_off(ticks_t start_time) {
      */
     constexpr auto ns_per_ms = TicksPerMS / TicksPerNS;
     constexpr auto ns_per_us = TicksPerUS / TicksPerNS;
-    if (os::current_stamp() - start_time < ns_per_ms) {
+    if (os::monotonic_stamp() - start_time < ns_per_ms) {
         SpinYield::sleep(10 * ns_per_us);
     } else {
         SpinYield::sleep(ns_per_ms);
@@ -5,6 +5,8 @@
 #include "inner_os.hpp"
 #include "MemoryTracer.hpp"
 #include "ArenaChunkPool.hpp"
+#include "plat/mem/Arena.hpp"
+#include "SlabAllocator.hpp"
 #include "plat/stream/FileCharOStream.hpp"
 #include "plat/logger/LogTagSet.hpp"
 #include "plat/thread/OSThread.hpp"
@@ -13,8 +15,12 @@ void PlatInitialize::initialize(ticks_t vm_start_time,
                                 OSThread *os_thread) {
     os::time_initialize(vm_start_time);
     os::native_prio_initialize();
+    os::memory_initialize();
+    os::cpu_topology_initialize();
     MemoryTracer::initialize();
     ArenaChunkPool::initialize();
+    Arena::initialize();
+    SlabAllocator::initialize();
     OSThread::attach_main_thread(os_thread);
 }
 
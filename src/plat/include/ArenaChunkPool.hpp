@@ -7,33 +7,101 @@
 
 #include "plat/mem/allocation.hpp"
 #include "plat/utils/robust.hpp"
+#include "plat/utils/OrderAccess.hpp"
 
 class ArenaChunk;
+class CharOStream;
 
 /**
  * 持有快速内存中空闲的内存池
  * 每个内存池仅仅持有统一大小的内存块
+ *
+ * 每个内存池拥有自己的自旋锁 临界区仅仅是链表的拼接
+ * 线程优先使用 ArenaChunkCache 批量的从内存池获取和归还
+ *
+ * 清理时按照需求保留内存块:
+ * 内存池记录两次清理之间被取走(含线程缓存持有)的内存块数量的峰值
+ * 保留的目标取 本次峰值 与 上次目标衰减一半 的较大值
+ * 池中仅仅保留 目标 - 仍被取走的数量 个内存块 其余释放
+ * 因此需求下降后 保留的内存块会在几个清理周期内逐渐释放
  */
 class ArenaChunkPool : public CHeapObject<MEMFLAG::Internal> {
+public:
+    /**
+     * 标准尺寸的数量 依次为 tiny small medium large
+     */
+    constexpr inline static int PoolCount = 4;
+    /**
+     * 每次清理 保留目标右移的位数
+     */
+    constexpr inline static int RetainDecayShift = 1;
 private:
     /**
      * 内存池 所持有的 快速内存块 链表
      */
     ArenaChunk *_list_head;
     /**
-     * 下面四个是不同尺寸的内存池
+     * 链表中内存块的数量
+     */
+    size_t _num_chunks;
+    /**
+     * 内存块的可用空间
      */
-    static ArenaChunkPool *_large_pool;
-    static ArenaChunkPool *_medium_pool;
-    static ArenaChunkPool *_small_pool;
-    static ArenaChunkPool *_tiny_pool;
+    const size_t _chunk_bytes;
+    /**
+     * 以下统计均受锁保护
+     * _in_use 被取走尚未归还到池中的内存块数量 包括线程缓存中的
+     * _peak_in_use 自上次清理以来_in_use的峰值
+     * _retain_target 上次清理得到的保留目标
+     * _hits 从池中直接获取到的内存块数量
+     * _misses 池为空 只能申请新内存的次数
+     * _released 清理时释放的内存块数量
+     */
+    size_t _in_use;
+    size_t _peak_in_use;
+    size_t _retain_target;
+    size_t _hits;
+    size_t _misses;
+    size_t _released;
+    /**
+     * 保护链表的锁 0表示未锁定
+     */
+    volatile int _lock;
+    /**
+     * 不同尺寸的内存池
+     */
+    static ArenaChunkPool *_pools[PoolCount];
 
 
     /**
      * 内存池的构造函数
      */
-    explicit ArenaChunkPool() :
-            _list_head(nullptr) {};
+    explicit ArenaChunkPool(size_t chunk_bytes) :
+            _list_head(nullptr),
+            _num_chunks(0),
+            _chunk_bytes(chunk_bytes),
+            _in_use(0),
+            _peak_in_use(0),
+            _retain_target(0),
+            _hits(0),
+            _misses(0),
+            _released(0),
+            _lock(0) {};
+
+    void lock();
+
+    inline void unlock() {
+        OrderAccess::xchg(&this->_lock, 0);
+    };
+
+    /**
+     * 增加被取走的数量 并更新峰值 需要持有锁
+     * @param count
+     */
+    inline void inc_in_use(size_t count) {
+        this->_in_use += count;
+        this->_peak_in_use = MAX2(this->_peak_in_use, this->_in_use);
+    };
 
     /**
      * 仅仅当内存池缓存的内存块数量
@@ -43,12 +111,26 @@ private:
      * 线程安全的
      * @param chunk_to_keep 内存池可以保持的内存块数量
      */
-    void purge();
+    void purge(size_t chunk_to_keep);
+
+    /**
+     * 根据需求计算保留的数量 然后释放多余的内存块
+     */
+    void purge_adaptive();
+
+    void print_on(CharOStream *out);
 
     inline ~ArenaChunkPool() {
-        this->purge();
+        this->purge(0);
     };
 public:
+    /**
+     * 获取标准尺寸的序号
+     * @param chunk_bytes 实际的可用空间
+     * @return 非标准尺寸返回 -1
+     */
+    static int pool_index(size_t chunk_bytes);
+
     /**
      * 获取指定大小的内存池 ，获取不到的返回 nullptr
      * @param chunk_bytes 实际的可用空间
@@ -56,6 +138,12 @@ public:
      */
     static ArenaChunkPool *get_pool(size_t chunk_bytes);
 
+    static inline ArenaChunkPool *pool_at(int index) {
+        assert(index >= 0 && index < PoolCount, "index out of range");
+        assert(ArenaChunkPool::_pools[index] != nullptr, "必须被初始化");
+        return ArenaChunkPool::_pools[index];
+    };
+
     /**
      * 从内存池中申请得到一个内存块
      * 线程安全的
@@ -71,6 +159,45 @@ public:
      */
     void free(ArenaChunk *chunk);
 
+    /**
+     * 一次取出至多count个内存块 仅持有一次锁
+     * 线程安全的
+     * @param count 期望的数量
+     * @param taken 实际取出的数量
+     * @return 通过next串联的链表
+     */
+    ArenaChunk *alloc_batch(size_t count, size_t *taken);
+
+    /**
+     * 一次归还通过next串联的多个内存块 仅持有一次锁
+     * 线程安全的
+     * @param first 链表的头部
+     * @param last 链表的尾部
+     * @param count 内存块的数量
+     */
+    void free_batch(ArenaChunk *first, ArenaChunk *last, size_t count);
+
+    /**
+     * 池为空 调用者直接申请了新的内存块
+     * 线程安全的
+     */
+    void record_miss();
+
+    /**
+     * 以下用于观察清理的效果 不加锁 可能读到其他线程修改之前的值
+     */
+    [[nodiscard]] inline size_t num_chunks() const {
+        return this->_num_chunks;
+    };
+
+    [[nodiscard]] inline size_t in_use() const {
+        return this->_in_use;
+    };
+
+    [[nodiscard]] inline size_t retain_target() const {
+        return this->_retain_target;
+    };
+
     /**
      * 初始化内存池
      */
@@ -80,11 +207,17 @@ public:
      * 在GC结束后 包括YoungGC
      * 但是并不会直接清理完毕所有空闲的内存块
      * 因为这个是快速内存 可能需要频繁申请
-     * 内部并没有上锁
-     * 所以需要
+     * 每个内存池按照自身的需求 仅仅释放超出保留目标的部分
+     * 线程安全的
      */
     static void clean();
 
+    /**
+     * 输出所有内存池的统计信息
+     * @param out
+     */
+    static void print_statistics(CharOStream *out);
+
 };
 
 
@@ -0,0 +1,103 @@
+//
+// Created by aurora on 2026/10/19.
+//
+
+#ifndef PLAT_MALLOC_SITE_TABLE_HPP
+#define PLAT_MALLOC_SITE_TABLE_HPP
+
+#include "stdtype.hpp"
+#include "plat/utils/NativeCallStack.hpp"
+#include "plat/mem/allocation.hpp"
+
+class CharOStream;
+
+/**
+ * 按照调用位置(NativeCallStack)汇总的本地内存表
+ * 记录每个调用位置 仍然存活的字节数 数量 以及存活字节数的峰值
+ *
+ * 使用开放寻址(线性探测)的固定大小哈希表 没有全局锁
+ * 槽位通过CAS占用 占用之后永远不会删除
+ * 表满之后的申请不再按位置统计 只记录溢出的次数
+ *
+ * 申请时返回位置编号 保存在申请的头部 释放时使用
+ */
+class MallocSiteTable : public AllStatic {
+public:
+    /**
+     * 槽位数量 必须是2的幂
+     */
+    constexpr inline static uint32_t TableSize = 4096;
+    /**
+     * 表示没有按照位置统计
+     */
+    constexpr inline static uint32_t NoSite = 0;
+private:
+    struct Site {
+        /**
+         * 0 表示槽位空闲
+         */
+        volatile uint64_t _hash;
+        /**
+         * 占用槽位的线程写完堆栈后设置为1
+         */
+        volatile int _ready;
+        MEMFLAG _flag;
+        void *_stack[NativeCallStack::MAX_DEPTH];
+        volatile size_t _live_bytes;
+        volatile size_t _live_count;
+        volatile size_t _peak_bytes;
+    };
+    static Site _sites[TableSize];
+    /**
+     * 基线时每个槽位存活的字节数
+     */
+    static size_t _baseline_bytes[TableSize];
+    /**
+     * 表满而没有统计的申请次数
+     */
+    static volatile size_t _overflow;
+
+    static uint64_t hash_of(const NativeCallStack &stack);
+
+    static bool same_stack(const Site *site, const NativeCallStack &stack);
+
+public:
+    /**
+     * 记录一次申请
+     * @param F 内存类型 以第一次出现的为准
+     * @param stack 调用位置
+     * @param bytes 申请的字节数
+     * @return 位置编号 表满或者没有调用堆栈时返回NoSite
+     */
+    static uint32_t record_alloc(MEMFLAG F, const NativeCallStack &stack, size_t bytes);
+
+    /**
+     * 记录一次释放
+     * @param site 申请时返回的位置编号
+     * @param bytes 申请时的字节数
+     */
+    static void record_free(uint32_t site, size_t bytes);
+
+    /**
+     * 按照存活字节数 输出前top_n个调用位置
+     * @param out 输出流
+     * @param top_n 最多输出的数量
+     */
+    static void print_top_sites(CharOStream *out, int top_n);
+
+    /**
+     * 记录每个调用位置当前存活的字节数 作为基线
+     */
+    static void baseline();
+
+    /**
+     * 按照相对于基线增长的字节数 输出前top_n个调用位置
+     * @param out 输出流
+     * @param top_n 最多输出的数量
+     * @param threshold 增长小于该字节数的不输出
+     */
+    static void print_site_diff(CharOStream *out, int top_n, size_t threshold);
+};
+
+
+#endif //PLAT_MALLOC_SITE_TABLE_HPP
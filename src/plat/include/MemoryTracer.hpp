@@ -9,6 +9,8 @@
 #include "plat/utils/NativeCallStack.hpp"
 #include "plat/mem/allocation.hpp"
 
+class CharOStream;
+
 class MemoryTracer {
 public:
     enum class OperationType : uint8_t {
@@ -28,8 +30,46 @@ public:
         summary,
         detail
     };
+
+    /**
+     * 一种内存类型的使用情况
+     */
+    struct Usage {
+        size_t _virtual_reserved;
+        size_t _virtual_committed;
+        size_t _native_alloc;
+        size_t _native_count;
+        size_t _arena_alloc;
+        size_t _arena_count;
+    };
+
+    /**
+     * 所有内存类型使用情况的快照 按照MEMFLAG索引
+     */
+    struct Snapshot {
+        Usage _usage[(int32_t) MEMFLAG::num_of_type];
+
+        [[nodiscard]] inline const Usage &usage(MEMFLAG F) const {
+            return this->_usage[(int32_t) F];
+        };
+    };
 private:
     static NMT_Level _nmt_level;
+    /**
+     * 基线 以及是否已经记录
+     */
+    static Snapshot _baseline;
+    static bool _has_baseline;
+
+    /**
+     * 解析NMTLevel
+     */
+    static NMT_Level parse_level();
+
+    /**
+     * PrintNMTStatistics 虚拟机退出时输出到默认的输出流
+     */
+    static void print_report_at_exit();
 public:
     /**
      * 记录内存记录
@@ -47,6 +87,79 @@ public:
 
     static void initialize();
 
+    /**
+     * 确定追踪的等级 只在第一次调用时解析NMTLevel
+     * 第一次申请本地内存可能早于initialize(例如构造主线程) 此时就必须确定是否带有头部
+     * 之后NMTLevel不可以再改变
+     */
+    static void level_initialize();
+
+    static inline NMT_Level nmt_level() {
+        return MemoryTracer::_nmt_level;
+    };
+
+    /**
+     * 开启内存追踪(summary或者detail)后 本地内存的申请带有头部
+     * 在level_initialize之后不会再改变
+     */
+    static inline bool malloc_header_enabled() {
+        return MemoryTracer::_nmt_level == NMT_Level::summary ||
+               MemoryTracer::_nmt_level == NMT_Level::detail;
+    };
+
+    /**
+     * 按照存活字节数 输出前top_n个本地内存的申请位置
+     * 仅仅在detail级别时有数据(summary级别不捕获调用堆栈)
+     * @param out
+     * @param top_n
+     */
+    static void print_malloc_sites(CharOStream *out, int top_n);
+
+    /**
+     * 输出保留的虚拟内存区间 以及其中已经提交的子区间
+     * 仅仅在开启内存追踪时有数据
+     * @param out
+     */
+    static void print_virtual_memory(CharOStream *out);
+
+    /**
+     * 将线程缓冲区中的详细记录写入追踪文件
+     * 仅仅在detail级别下有效 由周期性任务调用
+     */
+    static void drain();
+
+    /**
+     * 获取汇总的内存使用情况 不需要进入安全点
+     * @param out 快照
+     * @return 没有开启内存追踪(summary或者detail)时返回false
+     */
+    static bool snapshot(MemoryTracer::Snapshot *out);
+
+    /**
+     * 记录当前的汇总信息以及每个调用位置存活的字节数 作为基线
+     * 与print_diff不可以并发调用
+     * @return 没有开启内存追踪时返回false
+     */
+    static bool baseline();
+
+    /**
+     * 输出相对于基线的变化
+     * 每种内存类型 保留 提交 本地内存 快速内存 中任意一项变化达到阈值才会输出
+     * 之后输出增长达到阈值的调用位置(仅仅detail级别)
+     * @param out 输出流
+     * @param threshold 变化的字节数阈值 用于忽略噪声
+     * @return 输出的内存类型数量 没有基线时返回-1
+     */
+    static int print_diff(CharOStream *out, size_t threshold);
+
+    /**
+     * 输出每种内存类型的使用情况 保留的虚拟内存区间
+     * detail级别下还会输出存活字节数最多的申请位置
+     * 没有开启内存追踪时不输出
+     * @param out
+     */
+    static void print_report(CharOStream *out);
+
     static void flush();
 };
 
@@ -0,0 +1,152 @@
+//
+// Created by aurora on 2026/10/19.
+//
+
+#ifndef PLAT_SLAB_ALLOCATOR_HPP
+#define PLAT_SLAB_ALLOCATOR_HPP
+
+#include "plat/mem/allocation.hpp"
+#include "plat/constants.hpp"
+#include "plat/mem/SlabCache.hpp"
+#include "plat/utils/OrderAccess.hpp"
+#include "plat/utils/robust.hpp"
+
+class CharOStream;
+
+/**
+ * 按照尺寸分级的小对象分配器 作为CHEAP_ALLOC的另一种后端(CHeapBackend=slab)
+ *
+ * 启动时保留一段连续的虚拟地址空间 划分为 SpanBytes 大小的区段
+ * 每个区段提交后只服务于一个尺寸等级 被切分为等大的对象
+ * 释放时根据地址所在的区段得到尺寸等级 不需要额外的头部
+ *
+ * 线程优先使用 SlabCache 批量的从中央仓库获取和归还
+ * 中央仓库每个等级拥有自己的自旋锁 提交新的区段时不持有锁
+ *
+ * 超过 MaxBytes 的申请 以及地址空间耗尽后 由调用者退回到malloc
+ * 区段一旦提交不再归还给操作系统
+ * 地址空间的保留和提交不计入内存追踪 其中的对象已经由CHEAP_ALLOC按照申请者的类型记录
+ */
+class SlabAllocator {
+public:
+    constexpr inline static int ClassCount = SlabCache::ClassCount;
+    constexpr inline static size_t MaxBytes = 1024;
+    constexpr inline static size_t SpanBytes = 64 * K;
+    constexpr inline static size_t RegionBytes = 256 * M;
+    constexpr inline static size_t SpanCount = RegionBytes / SpanBytes;
+private:
+    /**
+     * 一个尺寸等级的中央仓库
+     */
+    struct alignas(CacheLineBytes) Depot {
+        void *_head;
+        size_t _count;
+        /**
+         * 分配给该等级的区段数量
+         */
+        size_t _spans;
+        /**
+         * 保护链表的锁 0表示未锁定
+         */
+        volatile int _lock;
+    };
+
+    static const uint32_t _class_bytes[ClassCount];
+    /**
+     * 按照16字节的粒度 映射到尺寸等级
+     */
+    static uint8_t _class_index[MaxBytes / 16 + 1];
+    static Depot _depots[ClassCount];
+    /**
+     * 区段所属的尺寸等级 + 1 , 0表示尚未使用
+     */
+    static uint8_t _span_class[SpanCount];
+    static char *_base;
+    static char *_end;
+    static volatile size_t _next_span;
+    /**
+     * 各个内存类型占用的字节数(按照等级的尺寸计算)
+     */
+    static volatile size_t _flag_bytes[(int32_t) MEMFLAG::num_of_type];
+
+    static void lock(Depot *depot);
+
+    static inline void unlock(Depot *depot) {
+        OrderAccess::xchg(&depot->_lock, 0);
+    };
+
+    /**
+     * 提交一个新的区段 切分后放入中央仓库 调用时不可以持有锁
+     * @param cls 尺寸等级
+     * @return 地址空间耗尽或者提交失败返回false
+     */
+    static bool new_span(int cls);
+
+public:
+    static void initialize();
+
+    static inline bool is_enabled() {
+        return SlabAllocator::_base != nullptr;
+    };
+
+    /**
+     * 地址是否由分级分配器提供 未开启时总是false
+     */
+    static inline bool contains(const void *p) {
+        return p >= SlabAllocator::_base && p < SlabAllocator::_end;
+    };
+
+    /**
+     * @return 超过MaxBytes返回-1
+     */
+    static inline int class_of(size_t bytes) {
+        return bytes <= MaxBytes ? SlabAllocator::_class_index[(bytes + 15) >> 4] : -1;
+    };
+
+    static inline size_t class_bytes(int cls) {
+        return SlabAllocator::_class_bytes[cls];
+    };
+
+    static inline int class_of_pointer(const void *p) {
+        assert(contains(p), "not a slab pointer");
+        return SlabAllocator::_span_class[((const char *) p - SlabAllocator::_base) / SpanBytes] - 1;
+    };
+
+    /**
+     * 从中央仓库批量获取 仓库为空时提交新的区段
+     * @param cls 尺寸等级
+     * @param count 期望的数量
+     * @param taken 实际获取的数量
+     * @return 链表的头部
+     */
+    static void *alloc_batch(int cls, uint32_t count, uint32_t *taken);
+
+    /**
+     * 批量归还到中央仓库
+     * @param first 链表的头部
+     * @param last 链表的尾部
+     */
+    static void free_batch(int cls, void *first, void *last, uint32_t count);
+
+    static inline void add_flag_bytes(int32_t flag, size_t delta) {
+        OrderAccess::fetch_and_add(SlabAllocator::_flag_bytes + flag, delta);
+    };
+
+    /**
+     * 申请内存
+     * @return 超过MaxBytes或者无法提供时返回nullptr
+     */
+    static void *allocate(MEMFLAG F, size_t bytes);
+
+    /**
+     * 释放内存 p必须满足contains
+     */
+    static void free(MEMFLAG F, void *p);
+
+    /**
+     * 输出区段的使用情况 以及各个内存类型占用的字节数
+     */
+    static void print_statistics(CharOStream *out);
+};
+
+#endif //PLAT_SLAB_ALLOCATOR_HPP
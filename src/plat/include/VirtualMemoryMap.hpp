@@ -0,0 +1,130 @@
+//
+// Created by aurora on 2026/10/19.
+//
+
+#ifndef PLAT_VIRTUAL_MEMORY_MAP_HPP
+#define PLAT_VIRTUAL_MEMORY_MAP_HPP
+
+#include "stdtype.hpp"
+#include "plat/mem/allocation.hpp"
+#include "plat/utils/NativeCallStack.hpp"
+
+class CharOStream;
+
+/**
+ * 虚拟内存区域表
+ * 记录保留的地址区间 以及每个区间内已经提交的子区间 各自带有内存类型和调用位置
+ *
+ * 保留的区间按照地址有序的存放在数组中 查找使用二分
+ * 每个区间内已提交的子区间同样有序
+ * 相邻(首尾相接) 且内存类型与调用位置都相同的区间会被合并
+ * 释放或者撤销提交区间的一部分时 会截断或者分裂原有的区间
+ *
+ * 数组直接使用malloc 不经过CHEAP_ALLOC 避免分配器提交内存时的重入
+ * 所有操作由一个自旋锁保护
+ *
+ * 仅仅在开启内存追踪时 由MemoryTracer::record维护
+ */
+class VirtualMemoryMap : public AllStatic {
+public:
+    /**
+     * 查找的结果
+     */
+    struct Info {
+        uintptr_t _reserved_base;
+        size_t _reserved_bytes;
+        MEMFLAG _reserved_flag;
+        void *_reserved_stack[NativeCallStack::MAX_DEPTH];
+        /**
+         * 地址是否位于已提交的子区间中 为false时以下字段无效
+         */
+        bool _committed;
+        uintptr_t _committed_base;
+        size_t _committed_bytes;
+        MEMFLAG _committed_flag;
+        void *_committed_stack[NativeCallStack::MAX_DEPTH];
+    };
+private:
+    /**
+     * [_base,_end) 区间
+     */
+    struct Range {
+        uintptr_t _base;
+        uintptr_t _end;
+        MEMFLAG _flag;
+        void *_stack[NativeCallStack::MAX_DEPTH];
+    };
+
+    struct Region : public Range {
+        Range *_committed;
+        uint32_t _num_committed;
+        uint32_t _cap_committed;
+    };
+
+    static Region *_regions;
+    static uint32_t _num_regions;
+    static uint32_t _cap_regions;
+    /**
+     * 提交的内存不属于任何保留区间的次数
+     */
+    static size_t _untracked_commits;
+    static volatile int _lock;
+
+    static void lock();
+
+    static void unlock();
+
+    /**
+     * 保证数组至少可以容纳need个元素 失败时退出虚拟机
+     */
+    template<typename T>
+    static void ensure_capacity(T *&items, uint32_t &cap, uint32_t need);
+
+    /**
+     * 第一个 _end > addr 的序号
+     */
+    template<typename T>
+    static uint32_t lower_bound(const T *items, uint32_t num, uintptr_t addr);
+
+    static bool can_merge(const Range &left, const Range &right);
+
+    /**
+     * 从有序的子区间数组中删除 [lo,hi) 必要时截断或者分裂
+     */
+    static void remove_ranges(Region *region, uintptr_t lo, uintptr_t hi);
+
+    /**
+     * 插入子区间 之后与前后相邻的子区间合并 插入之前不可以有重叠
+     */
+    static void insert_range(Region *region, const Range &range);
+
+    static Region *region_containing(uintptr_t addr);
+
+    static void remove_regions(uintptr_t lo, uintptr_t hi);
+
+    static void init_range(Range *range, MEMFLAG F, void *addr, size_t bytes, const NativeCallStack &stack);
+
+public:
+    static void add_reserved(MEMFLAG F, void *addr, size_t bytes, const NativeCallStack &stack);
+
+    static void remove_reserved(void *addr, size_t bytes);
+
+    static void add_committed(MEMFLAG F, void *addr, size_t bytes, const NativeCallStack &stack);
+
+    static void remove_committed(void *addr, size_t bytes);
+
+    /**
+     * 查找地址所在的保留区间 以及已提交的子区间
+     * @return 不属于任何保留区间时返回false
+     */
+    static bool lookup(const void *addr, Info *info);
+
+    /**
+     * 保留和提交的字节数总和
+     */
+    static void totals(size_t *reserved, size_t *committed);
+
+    static void print_on(CharOStream *out);
+};
+
+#endif //PLAT_VIRTUAL_MEMORY_MAP_HPP
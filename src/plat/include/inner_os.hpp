@@ -6,6 +6,7 @@
 #define PLAT_INNER_OS_HPP
 
 #include "stdtype.hpp"
+#include <sys/types.h>
 /**
  * 模块内使用的init头文件
  */
@@ -22,6 +23,50 @@ namespace os {
      * 内部会自行进行判断
      */
     extern void native_prio_initialize();
+
+    /**
+     * 解析本地内存相关的参数 例如撤销提交的默认方式
+     */
+    extern void memory_initialize();
+
+    /**
+     * 解析CPU的拓扑以及cgroup的CPU限制 必须在memory_initialize之后调用
+     */
+    extern void cpu_topology_initialize();
+
+    /**
+     * 读取整个文件 文件过大时截断 用于读取/proc和/sys下的小文件
+     * @return 读取的字节数 失败返回-1
+     */
+    extern ssize_t read_small_file(const char *path, char *buf, size_t bytes);
+
+    /**
+     * @return 文件中的第一个无符号整数 内容为max(不限制)或者读取失败时返回0
+     */
+    extern uint64_t read_u64_file(const char *path);
+
+    /**
+     * 定位自己所在cgroup中某个层级的目录
+     * 挂载点和挂载的根从/proc/self/mountinfo解析 不假定挂载在/sys/fs/cgroup下
+     * @param controller v1的控制器 例如cpu memory cpuset nullptr表示v2的统一层级
+     * @param dir 输出 挂载点加上cgroup路径中相对于挂载根的部分
+     * @param mount_len 输出挂载点的长度 向上遍历层级时不越过挂载点 可以为nullptr
+     * @return 不在该层级中或者层级没有挂载时返回false
+     */
+    extern bool locate_cgroup(const char *controller, char *dir, size_t bytes, size_t *mount_len);
+
+    /**
+     * 保留按照align对齐的地址空间 不计入内存追踪
+     * 用于本地内存分配器的后备内存 其中的申请已经由CHEAP_ALLOC按照申请者的类型记录
+     * 再记录一次会重复计算
+     * @return 失败返回nullptr
+     */
+    extern void *reserve_untracked_aligned(size_t bytes, size_t align);
+
+    /**
+     * 将reserve_untracked_aligned保留的一段提交为可读写 不计入内存追踪
+     */
+    extern bool commit_untracked(void *addr, size_t bytes);
     /**
      * 当 *uaddr == tag时 挂起线程
      * @param uaddr
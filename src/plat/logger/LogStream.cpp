@@ -92,17 +92,22 @@ void LogStream::LineBuffer::try_ensure_cap(size_t capacity_needed) {
     constexpr size_t addition_expansion = 256;
     size_t new_cap = align_up(capacity_needed + addition_expansion, addition_expansion);
     new_cap = MIN2<size_t>(OStreamDefaultBufSize, new_cap);
-    auto new_buf = (char *) NEW_RESOURCE_ARRAY(char, new_cap);
-    if (new_buf == nullptr) {
-        return;
-    }
-    if (this->_pos > 0) {
-        //还要+1包括结束符
-        ::memcpy(new_buf, this->_buf, this->_pos + 1);
-    }
+    char *new_buf;
     if (this->_buf != this->_small_buf) {
-        //说明原本的内存块也是malloc申请的
-        FREE_RESOURCE_ARRAY(this->_buf, this->_cap);
+        //原本的内存块也是快速内存申请的 尽量原地扩展
+        new_buf = REALLOC_RESOURCE_ARRAY(char, this->_buf, this->_cap, new_cap);
+        if (new_buf == nullptr) {
+            return;
+        }
+    } else {
+        new_buf = (char *) NEW_RESOURCE_ARRAY(char, new_cap);
+        if (new_buf == nullptr) {
+            return;
+        }
+        if (this->_pos > 0) {
+            //还要+1包括结束符
+            ::memcpy(new_buf, this->_buf, this->_pos + 1);
+        }
     }
     this->_buf = new_buf;
     this->_cap = new_cap;
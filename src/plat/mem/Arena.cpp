@@ -9,11 +9,14 @@
 #include "ArenaChunkPool.hpp"
 #include "plat/utils/robust.hpp"
 #include "plat/utils/align.hpp"
+#include "plat/os/mem.hpp"
+#include "global/flag.hpp"
+#include <cstring>
 void Arena::new_chunk(size_t chunk_bytes,
                       bool exit_oom) {
     assert_is_aligned(chunk_bytes, BytesPerWord);
     auto chunk = new(chunk_bytes, exit_oom)
-            ArenaChunk(chunk_bytes);
+            ArenaChunk(sizeof(ArenaChunk) + chunk_bytes);
     if (chunk == nullptr) {
         //申请失败 返回
         return;
@@ -24,6 +27,12 @@ void Arena::new_chunk(size_t chunk_bytes,
                          chunk_bytes,
                          CALLER_STACK);
     this->_total_bytes += chunk_bytes;
+    //保留剩余空间更多的区域作为备用区域 另一个被抛弃
+    if (this->_end_literal - this->_top_literal >
+        this->_spare_end_literal - this->_spare_top_literal) {
+        this->_spare_top_literal = this->_top_literal;
+        this->_spare_end_literal = this->_end_literal;
+    }
     this->_top_literal = chunk->bottom_literal();
     this->_end_literal = chunk->end_literal();
     if (this->_head == nullptr) {
@@ -31,7 +40,7 @@ void Arena::new_chunk(size_t chunk_bytes,
         this->_tail = this->_head = chunk;
     } else {
         //插入到尾部
-        chunk->set_next(this->_tail);
+        this->_tail->set_next(chunk);
         this->_tail = chunk;
     }
 
@@ -59,10 +68,16 @@ size_t Arena::chop_list(ArenaChunk *chunk) const {
 
 Arena::Arena(MEMFLAG flag, size_t init_bytes) :
         _flag(flag),
-        _top_literal(0),
-        _end_literal(0),
         _head(nullptr),
         _tail(nullptr),
+        _top_literal(0),
+        _end_literal(0),
+        _spare_top_literal(0),
+        _spare_end_literal(0),
+        _recovered_bytes(0),
+        _large_head(nullptr),
+        _large_serial(0),
+        _large_bytes(0),
         _total_bytes(0) {
     //对可使用的长度 进行对齐 应该机器最大的对宽度对齐
     init_bytes = align_up(init_bytes, BytesPerWord);
@@ -76,11 +91,26 @@ void *Arena::alloc(size_t request,bool exit_oom) {
     if (this->check_overflow(request, exit_oom)) {
         return nullptr;
     }
+    if (request >= DirectMapBytes) {
+        //大块内存单独映射 不破坏当前的指针碰撞区域
+        return this->alloc_large(request, exit_oom);
+    }
 
+    //优先消耗之前内存块剩余的尾部 备用区域为空时仅仅多一次比较
+    const auto spare = this->alloc_from_spare(request);
+    if (spare != nullptr) {
+        return spare;
+    }
     if (this->_end_literal - this->_top_literal < request) {
-        //说明当前申请不下 那么默认当前块使用完毕 重新申请 当前块就浪费了
-        auto new_chunk_bytes = MAX2<size_t>(request, ArenaChunk::large_bytes);
-        this->new_chunk(new_chunk_bytes, exit_oom);
+        //说明当前申请不下 重新申请 当前块剩余的部分可能成为备用区域
+        //新的大块必须能够容纳所有不单独映射的申请
+        static_assert(DirectMapBytes <= align_up<size_t>(ArenaChunk::large_bytes + 1, BytesPerWord),
+                      "超过大块的申请必须单独映射");
+        this->new_chunk(ArenaChunk::large_bytes, exit_oom);
+        if (this->_end_literal - this->_top_literal < request) {
+            //申请失败 当前区域没有变化
+            return nullptr;
+        }
     }
     /**
      * 当前的chunk可以申请的下
@@ -116,17 +146,178 @@ bool Arena::free(void *ptr, size_t request) {
     if (ptr == nullptr)
         return true;
     request = align_up(request, BytesPerWord);
+    if (request >= DirectMapBytes) {
+        LargeBlock *prev;
+        const auto block = this->find_large(ptr, &prev);
+        if (block != nullptr) {
+            this->release_large(block, prev);
+            return true;
+        }
+        return false;
+    }
     if ((uintptr_t) ptr + request == this->_top_literal) {
         this->_top_literal = (uintptr_t) ptr;
         return true;
+    } else if ((uintptr_t) ptr + request == this->_spare_top_literal) {
+        this->_spare_top_literal = (uintptr_t) ptr;
+        return true;
+    } else {
+        return false;
+    }
+}
+
+void *Arena::alloc_from_spare(size_t request) {
+    if (this->_spare_end_literal - this->_spare_top_literal < request) {
+        return nullptr;
+    }
+    auto old = this->_spare_top_literal;
+    this->_spare_top_literal += request;
+    this->_recovered_bytes += request;
+    return (void *) old;
+}
+
+void *Arena::map_large(size_t *mapped_bytes) const {
+    const auto huge_bytes = os::default_huge_page_size();
+    const auto use_huge = _large_page_mode != os::LargePageMode::off &&
+                          huge_bytes != 0 &&
+                          *mapped_bytes >= huge_bytes;
+    if (use_huge && _large_page_mode == os::LargePageMode::hugetlb) {
+        const auto bytes = align_up(*mapped_bytes, huge_bytes);
+        const auto base = os::reserve_memory_huge(this->flag(), bytes, huge_bytes);
+        if (base != nullptr) {
+            if (os::commit_memory(this->flag(), base, bytes, os::CommitType::rw)) {
+                *mapped_bytes = bytes;
+                return base;
+            }
+            os::release_memory(this->flag(), base, bytes);
+        }
+        //预留的大页不足 退回普通页
+    }
+    void *base;
+    if (use_huge && _large_page_mode == os::LargePageMode::thp) {
+        //按照大页对齐 整个区间才可能由透明大页支持
+        *mapped_bytes = align_up(*mapped_bytes, huge_bytes);
+        base = os::reserve_memory_aligned(this->flag(), *mapped_bytes, huge_bytes);
+        if (base != nullptr) {
+            os::advise_huge_pages(base, *mapped_bytes, true);
+        }
+    } else {
+        base = os::reserve_memory(this->flag(), *mapped_bytes);
+    }
+    if (base != nullptr &&
+        !os::commit_memory(this->flag(), base, *mapped_bytes, os::CommitType::rw)) {
+        os::release_memory(this->flag(), base, *mapped_bytes);
+        base = nullptr;
+    }
+    return base;
+}
+
+void *Arena::alloc_large(size_t request, bool exit_oom) {
+    auto mapped_bytes = align_up(sizeof(LargeBlock) + request, (size_t) os::page_size());
+    const auto base = this->map_large(&mapped_bytes);
+    if (base == nullptr) {
+        if (exit_oom) {
+            vm_exit_out_of_memory(VMErrorType::OOM_MMAP_ERROR, mapped_bytes, "Arena direct map");
+        }
+        return nullptr;
+    }
+    const auto block = (LargeBlock *) base;
+    block->_next = this->_large_head;
+    block->_serial = this->_large_serial++;
+    block->_mapped_bytes = mapped_bytes;
+    this->_large_head = block;
+    this->_large_bytes += mapped_bytes;
+    return block->payload();
+}
+
+void Arena::release_large(LargeBlock *block, LargeBlock *prev) {
+    assert((prev == nullptr ? this->_large_head : prev->_next) == block, "prev必须是block的前一个");
+    if (prev == nullptr) {
+        this->_large_head = block->_next;
     } else {
+        prev->_next = block->_next;
+    }
+    const auto mapped_bytes = block->_mapped_bytes;
+    this->_large_bytes -= mapped_bytes;
+    //直接映射的区间在申请时整个提交
+    os::release_committed_memory(this->flag(), block, mapped_bytes);
+}
+
+void Arena::release_large_since(size_t serial) {
+    //链表中新的位于头部 序号从头到尾递减
+    while (this->_large_head != nullptr && this->_large_head->_serial >= serial) {
+        this->release_large(this->_large_head, nullptr);
+    }
+}
+
+Arena::LargeBlock *Arena::find_large(void *ptr, LargeBlock **prev) const {
+    *prev = nullptr;
+    for (auto cur = this->_large_head; cur != nullptr; cur = cur->_next) {
+        if (cur->payload() == ptr) {
+            return cur;
+        }
+        *prev = cur;
+    }
+    return nullptr;
+}
+
+bool Arena::grow_in_place(uintptr_t ptr,
+                          size_t old_bytes,
+                          size_t new_bytes,
+                          uintptr_t *top,
+                          uintptr_t end) {
+    //必须是这个区域的最后一次申请
+    if (ptr + old_bytes != *top || end - ptr < new_bytes) {
         return false;
     }
+    *top = ptr + new_bytes;
+    return true;
+}
+
+void *Arena::realloc(void *ptr, size_t old_bytes, size_t new_bytes, bool exit_oom) {
+    if (ptr == nullptr) {
+        return this->alloc(new_bytes, exit_oom);
+    }
+    old_bytes = align_up(old_bytes, BytesPerWord);
+    new_bytes = align_up(new_bytes, BytesPerWord);
+    const auto literal = (uintptr_t) ptr;
+    if (grow_in_place(literal, old_bytes, new_bytes,
+                      &this->_top_literal, this->_end_literal)) {
+        return ptr;
+    }
+    if (grow_in_place(literal, old_bytes, new_bytes,
+                      &this->_spare_top_literal, this->_spare_end_literal)) {
+        if (new_bytes > old_bytes) {
+            this->_recovered_bytes += new_bytes - old_bytes;
+        }
+        return ptr;
+    }
+    if (old_bytes >= DirectMapBytes) {
+        LargeBlock *prev;
+        const auto block = this->find_large(ptr, &prev);
+        if (block != nullptr && sizeof(LargeBlock) + new_bytes <= block->_mapped_bytes) {
+            //单独映射的内存 页对齐剩余的部分足够
+            return ptr;
+        }
+    }
+    if (new_bytes <= old_bytes) {
+        //缩小但不是最后一次申请 多余的部分无法回收
+        return ptr;
+    }
+    const auto new_ptr = this->alloc(new_bytes, exit_oom);
+    if (new_ptr == nullptr) {
+        return nullptr;
+    }
+    ::memcpy(new_ptr, ptr, old_bytes);
+    //单独映射的旧内存总是可以释放 其他的只有位于区域末尾时才能释放
+    this->free(ptr, old_bytes);
+    return new_ptr;
 }
 
 Arena::~Arena() {
-    this->_total_bytes = this->chop_list(this->_head);
-    assert(this->_total_bytes == 0, "must be");
+    this->release_large_since(0);
+    const auto free_bytes = this->chop_list(this->_head);
+    assert(this->_total_bytes == free_bytes, "must be");
     /**
      * 将所持有的数据信息全部清空
      */
@@ -134,6 +325,8 @@ Arena::~Arena() {
     this->_tail = nullptr;
     this->_top_literal = 0;
     this->_end_literal = 0;
+    this->_spare_top_literal = 0;
+    this->_spare_end_literal = 0;
 }
 
 Arena::Arena(MEMFLAG F) :
@@ -141,32 +334,39 @@ Arena::Arena(MEMFLAG F) :
 }
 
 void Arena::iter_chunk(Arena::ChunkClosure *closure) {
-    auto cur = this->_head;
-    if (cur == nullptr) {
-        return;
-    }
-    //对于第1块 需要特殊的处理
-    closure->do_chunk((void *) cur->bottom_literal(),
-                      (void *) this->_top_literal);
-    cur = cur->next();
-    //对于之后 内存块处理
-    while (cur != nullptr) {
-        closure->do_chunk((void *) cur->bottom_literal(),
-                          (void *) cur->end_literal());
+    //最后一块 即当前块 仅仅使用到_top_literal
+    for (auto cur = this->_head; cur != nullptr; cur = cur->next()) {
+        const auto top = cur == this->_tail ? this->_top_literal : cur->end_literal();
+        closure->do_chunk((void *) cur->bottom_literal(), (void *) top);
     }
 }
 
+os::LargePageMode Arena::_large_page_mode = os::LargePageMode::off;
+
+void Arena::initialize() {
+    guarantee(os::parse_large_page_mode(global::ArenaLargePages, &_large_page_mode),
+              "ArenaLargePages is error, must be selected from off, thp and hugetlb.");
+}
+
 void Arena::clean_pool() {
     ArenaChunkPool::clean();
 }
 
+void Arena::print_pool_statistics(CharOStream *out) {
+    ArenaChunkPool::print_statistics(out);
+}
+
 
 
 Arena::SavedData::SavedData(Arena *arena) :
         _tail(arena->_tail),
-        _total_bytes(arena->_total_bytes),
+        _top_literal(arena->_top_literal),
         _end_literal(arena->_end_literal),
-        _top_literal(arena->_top_literal) {
+        _spare_top_literal(arena->_spare_top_literal),
+        _spare_end_literal(arena->_spare_end_literal),
+        _total_bytes(arena->_total_bytes),
+        _large_serial(arena->_large_serial),
+        _large_bytes(arena->_large_bytes) {
     assert(arena != nullptr, "must be");
 }
 
@@ -174,10 +374,16 @@ void Arena::SavedData::rollback_to(Arena *arena) {
     assert(arena != nullptr, "must be");
     arena->_top_literal = this->_top_literal;
     arena->_end_literal = this->_end_literal;
+    //备用区域可能位于即将删除的内存块中 一并恢复
+    arena->_spare_top_literal = this->_spare_top_literal;
+    arena->_spare_end_literal = this->_spare_end_literal;
     arena->_tail = this->_tail;
     arena->_total_bytes = this->_total_bytes;
-    this->_tail->set_next(nullptr);
+    //标记之后单独映射的内存 直接归还 标记之前的可能已经在标记期间释放
+    arena->release_large_since(this->_large_serial);
+    assert(arena->_large_bytes <= this->_large_bytes, "must be");
     auto delete_node = this->_tail->next();
+    this->_tail->set_next(nullptr);
     arena->chop_list(delete_node);
 }
 
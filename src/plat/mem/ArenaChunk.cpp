@@ -5,17 +5,28 @@
 #include "ArenaChunk.hpp"
 #include "ArenaChunkPool.hpp"
 #include "plat/utils/align.hpp"
+#include "plat/thread/OSThread.hpp"
 void *ArenaChunk::operator new(size_t size, size_t len, bool exit_oom) {
     assert(size == sizeof(ArenaChunk), "weird request size");
-    // Try to reuse a freed chunk from the pool
-    const auto pool = ArenaChunkPool::get_pool(size);
-    if (pool != nullptr) {
-        const auto c = pool->alloc();
-        if (c != nullptr) {
-            assert(c->length() == len, "wrong length?");
-            return c;
+    // Try to reuse a freed chunk from the thread cache, or from the pool if there is no thread
+    ArenaChunk *c = nullptr;
+    const auto thread = OSThread::current();
+    if (thread != nullptr) {
+        c = thread->chunk_cache()->alloc(len);
+    } else {
+        const auto pool = ArenaChunkPool::get_pool(len);
+        if (pool != nullptr) {
+            c = pool->alloc();
         }
     }
+    if (c != nullptr) {
+        assert(c->length() == len, "wrong length?");
+        return c;
+    }
+    const auto pool = ArenaChunkPool::get_pool(len);
+    if (pool != nullptr) {
+        pool->record_miss();
+    }
     // Either the pool was empty, or this is a non-standard length. Allocate a new Chunk from C-heap.
     size_t bytes = size + len;
     void *p = NEW_CHEAP_ARRAY(uint8_t, bytes, MEMFLAG::Chunk);
@@ -29,6 +40,10 @@ void *ArenaChunk::operator new(size_t size, size_t len, bool exit_oom) {
 
 void ArenaChunk::operator delete(void *p) {
     auto segment = (ArenaChunk *) p;
+    const auto thread = OSThread::current();
+    if (thread != nullptr && thread->chunk_cache()->free(segment)) {
+        return;
+    }
     const auto pool = ArenaChunkPool::get_pool(segment->length());
     if(pool != nullptr){
         pool->free(segment);
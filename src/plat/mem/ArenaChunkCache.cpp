@@ -0,0 +1,91 @@
+//
+// Created by aurora on 2026/10/19.
+//
+
+#include "plat/mem/ArenaChunkCache.hpp"
+#include "ArenaChunk.hpp"
+#include "ArenaChunkPool.hpp"
+#include "plat/macro.hpp"
+
+static_assert(ArenaChunkCache::SlotCount == ArenaChunkPool::PoolCount,
+              "每种标准尺寸对应一个槽位");
+
+uint32_t ArenaChunkCache::capacity_of(int slot) {
+    static const size_t slot_bytes[SlotCount] = {
+            ArenaChunk::tiny_bytes,
+            ArenaChunk::small_bytes,
+            ArenaChunk::medium_bytes,
+            ArenaChunk::large_bytes
+    };
+    return (uint32_t) MAX2<size_t>(CacheBytesPerSlot / slot_bytes[slot], 2);
+}
+
+ArenaChunkCache::ArenaChunkCache() :
+        _heads(),
+        _counts() {
+}
+
+ArenaChunkCache::~ArenaChunkCache() {
+    this->drain_all();
+}
+
+void ArenaChunkCache::refill(int slot) {
+    assert(this->_counts[slot] == 0, "仅仅在槽位为空时获取");
+    size_t taken = 0;
+    this->_heads[slot] = ArenaChunkPool::pool_at(slot)->alloc_batch(
+            capacity_of(slot) / 2, &taken);
+    this->_counts[slot] = (uint32_t) taken;
+}
+
+void ArenaChunkCache::drain(int slot, uint32_t count) {
+    assert(count > 0 && count <= this->_counts[slot], "check");
+    auto first = this->_heads[slot];
+    auto last = first;
+    for (uint32_t i = 1; i < count; ++i) {
+        last = last->next();
+    }
+    this->_heads[slot] = last->next();
+    this->_counts[slot] -= count;
+    ArenaChunkPool::pool_at(slot)->free_batch(first, last, count);
+}
+
+ArenaChunk *ArenaChunkCache::alloc(size_t chunk_bytes) {
+    const auto slot = ArenaChunkPool::pool_index(chunk_bytes);
+    if (slot < 0) {
+        return nullptr;
+    }
+    if (this->_counts[slot] == 0) {
+        this->refill(slot);
+        if (this->_counts[slot] == 0) {
+            return nullptr;
+        }
+    }
+    const auto chunk = this->_heads[slot];
+    this->_heads[slot] = chunk->next();
+    --this->_counts[slot];
+    chunk->set_next(nullptr);
+    return chunk;
+}
+
+bool ArenaChunkCache::free(ArenaChunk *chunk) {
+    const auto slot = ArenaChunkPool::pool_index(chunk->length());
+    if (slot < 0) {
+        return false;
+    }
+    const auto capacity = capacity_of(slot);
+    if (this->_counts[slot] >= capacity) {
+        this->drain(slot, capacity / 2);
+    }
+    chunk->set_next(this->_heads[slot]);
+    this->_heads[slot] = chunk;
+    ++this->_counts[slot];
+    return true;
+}
+
+void ArenaChunkCache::drain_all() {
+    for (int slot = 0; slot < SlotCount; ++slot) {
+        if (this->_counts[slot] > 0) {
+            this->drain(slot, this->_counts[slot]);
+        }
+    }
+}
@@ -4,37 +4,103 @@
 
 #include "ArenaChunkPool.hpp"
 #include "ArenaChunk.hpp"
-#include "GlobalLocker.hpp"
+#include "plat/thread/SpinYield.hpp"
+#include "plat/stream/CharOStream.hpp"
 
-ArenaChunkPool *ArenaChunkPool::_tiny_pool = nullptr;
-ArenaChunkPool *ArenaChunkPool::_small_pool = nullptr;
-ArenaChunkPool *ArenaChunkPool::_medium_pool = nullptr;
-ArenaChunkPool *ArenaChunkPool::_large_pool = nullptr;
+ArenaChunkPool *ArenaChunkPool::_pools[ArenaChunkPool::PoolCount] = {};
 
+void ArenaChunkPool::lock() {
+    //临界区非常短 自旋等待即可
+    SpinYield spin;
+    while (OrderAccess::xchg(&this->_lock, 1) != 0) {
+        spin.wait();
+    }
+}
 
 ArenaChunk *ArenaChunkPool::alloc() {
-    //进行内存的申请 但是需要考虑线程安全问题
-    GlobalLocker gl;
+    this->lock();
     auto head = this->_list_head;
-    if (this->_list_head) {
-        this->_list_head = this->_list_head->next();
+    if (head) {
+        this->_list_head = head->next();
+        --this->_num_chunks;
+        ++this->_hits;
+        this->inc_in_use(1);
+    }
+    this->unlock();
+    if (head) {
         head->set_next(nullptr);
     }
     return head;
 }
 
 void ArenaChunkPool::free(ArenaChunk *chunk) {
-    //进行线程锁
-    GlobalLocker gl;
-    chunk->set_next(this->_list_head);
-    this->_list_head = chunk;
+    this->free_batch(chunk, chunk, 1);
+}
+
+ArenaChunk *ArenaChunkPool::alloc_batch(size_t count, size_t *taken) {
+    assert(count > 0 && taken != nullptr, "check");
+    size_t n = 0;
+    this->lock();
+    auto first = this->_list_head;
+    ArenaChunk *last = nullptr;
+    for (auto cur = first; cur != nullptr && n < count; cur = cur->next()) {
+        last = cur;
+        ++n;
+    }
+    if (last != nullptr) {
+        this->_list_head = last->next();
+        this->_num_chunks -= n;
+        this->_hits += n;
+        this->inc_in_use(n);
+    }
+    this->unlock();
+    if (last != nullptr) {
+        last->set_next(nullptr);
+    } else {
+        first = nullptr;
+    }
+    *taken = n;
+    return first;
+}
+
+void ArenaChunkPool::free_batch(ArenaChunk *first, ArenaChunk *last, size_t count) {
+    assert(first != nullptr && last != nullptr && count > 0, "check");
+    this->lock();
+    last->set_next(this->_list_head);
+    this->_list_head = first;
+    this->_num_chunks += count;
+    this->_in_use -= MIN2(count, this->_in_use);
+    this->unlock();
 }
 
+void ArenaChunkPool::record_miss() {
+    this->lock();
+    ++this->_misses;
+    this->inc_in_use(1);
+    this->unlock();
+}
 
-void ArenaChunkPool::purge() {
-    //所有线程的锁，保证线程的安全
-    GlobalLocker gl;
-    ArenaChunk *cur = this->_list_head;
+
+void ArenaChunkPool::purge(size_t chunk_to_keep) {
+    //先摘下多余的部分 释放内存时不再持有锁
+    this->lock();
+    ArenaChunk *cur = nullptr;
+    if (this->_num_chunks > chunk_to_keep) {
+        if (chunk_to_keep == 0) {
+            cur = this->_list_head;
+            this->_list_head = nullptr;
+        } else {
+            auto last_kept = this->_list_head;
+            for (size_t i = 1; i < chunk_to_keep; ++i) {
+                last_kept = last_kept->next();
+            }
+            cur = last_kept->next();
+            last_kept->set_next(nullptr);
+        }
+        this->_released += this->_num_chunks - chunk_to_keep;
+        this->_num_chunks = chunk_to_keep;
+    }
+    this->unlock();
     ArenaChunk *next;
     while (cur != nullptr) {
         next = cur->next();
@@ -44,37 +110,81 @@ void ArenaChunkPool::purge() {
 
 }
 
+void ArenaChunkPool::purge_adaptive() {
+    this->lock();
+    //保留目标 本周期的峰值 和 衰减后的上一次目标 取较大者
+    const auto target = MAX2(this->_peak_in_use,
+                             this->_retain_target >> RetainDecayShift);
+    this->_retain_target = target;
+    //峰值重新从当前被取走的数量开始统计
+    this->_peak_in_use = this->_in_use;
+    const auto keep = target > this->_in_use ? target - this->_in_use : 0;
+    this->unlock();
+    this->purge(keep);
+}
+
+void ArenaChunkPool::print_on(CharOStream *out) {
+    this->lock();
+    const auto chunk_bytes = this->_chunk_bytes;
+    const auto num_chunks = this->_num_chunks;
+    const auto in_use = this->_in_use;
+    const auto peak = this->_peak_in_use;
+    const auto target = this->_retain_target;
+    const auto hits = this->_hits;
+    const auto misses = this->_misses;
+    const auto released = this->_released;
+    this->unlock();
+    out->print("chunk " SIZE_FORMAT ": hit " SIZE_FORMAT ",miss " SIZE_FORMAT
+               ",in-use " SIZE_FORMAT "(peak " SIZE_FORMAT "),target " SIZE_FORMAT
+               ",released " SIZE_FORMAT ",retained " SIZE_FORMAT "(",
+               chunk_bytes, hits, misses, in_use, peak, target, released, num_chunks);
+    out->print_human_bytes(num_chunks * chunk_bytes);
+    out->print_cr(").");
+}
+
 void ArenaChunkPool::initialize() {
-    ArenaChunkPool::_tiny_pool = new ArenaChunkPool();
-    ArenaChunkPool::_small_pool = new ArenaChunkPool();
-    ArenaChunkPool::_medium_pool = new ArenaChunkPool();
-    ArenaChunkPool::_large_pool = new ArenaChunkPool();
+    const size_t chunk_bytes[PoolCount] = {
+            ArenaChunk::tiny_bytes,
+            ArenaChunk::small_bytes,
+            ArenaChunk::medium_bytes,
+            ArenaChunk::large_bytes
+    };
+    for (int i = 0; i < PoolCount; ++i) {
+        ArenaChunkPool::_pools[i] = new ArenaChunkPool(chunk_bytes[i]);
+    }
 }
 
 void ArenaChunkPool::clean() {
-    ArenaChunkPool::_tiny_pool->purge();
-    ArenaChunkPool::_small_pool->purge();
-    ArenaChunkPool::_medium_pool->purge();
-    ArenaChunkPool::_large_pool->purge();
+    for (auto pool: ArenaChunkPool::_pools) {
+        pool->purge_adaptive();
+    }
 }
 
-ArenaChunkPool *ArenaChunkPool::get_pool(size_t chunk_bytes) {
+void ArenaChunkPool::print_statistics(CharOStream *out) {
+    for (auto pool: ArenaChunkPool::_pools) {
+        pool->print_on(out);
+    }
+}
+
+int ArenaChunkPool::pool_index(size_t chunk_bytes) {
     switch (chunk_bytes) {
         case ArenaChunk::tiny_bytes:
-            assert(ArenaChunkPool::_tiny_pool != nullptr, "必须被初始化");
-            return ArenaChunkPool::_tiny_pool;
+            return 0;
         case ArenaChunk::small_bytes:
-            assert(ArenaChunkPool::_small_pool != nullptr, "必须被初始化");
-            return ArenaChunkPool::_small_pool;
+            return 1;
         case ArenaChunk::medium_bytes:
-            assert(ArenaChunkPool::_medium_pool != nullptr, "必须被初始化");
-            return ArenaChunkPool::_medium_pool;
+            return 2;
         case ArenaChunk::large_bytes:
-            assert(ArenaChunkPool::_large_pool != nullptr, "必须被初始化");
-            return ArenaChunkPool::_large_pool;
+            return 3;
         default:
-            return nullptr;
+            return -1;
     }
 }
 
-
+ArenaChunkPool *ArenaChunkPool::get_pool(size_t chunk_bytes) {
+    const auto index = ArenaChunkPool::pool_index(chunk_bytes);
+    if (index < 0) {
+        return nullptr;
+    }
+    return ArenaChunkPool::pool_at(index);
+}
@@ -0,0 +1,44 @@
+//
+// Created by aurora on 2026/10/19.
+//
+
+#include "plat/mem/ArenaMemoryResource.hpp"
+#include "plat/constants.hpp"
+#include "plat/utils/robust.hpp"
+#include "plat/utils/align.hpp"
+
+ArenaMemoryResource::ArenaMemoryResource(Arena *arena) :
+        _arena(arena) {
+    assert(arena != nullptr, "must be not null");
+}
+
+void *ArenaMemoryResource::do_allocate(size_t bytes, size_t alignment) {
+    assert(is_power_of_2(alignment), "alignment must be power of 2");
+    if (alignment <= BytesPerWord) {
+        //Arena本身按照字宽对齐
+        return this->_arena->alloc(bytes, true);
+    }
+    //更大的对齐 多申请一部分 再向上对齐
+    const auto ptr = (uintptr_t) this->_arena->alloc(bytes + alignment - BytesPerWord, true);
+    return (void *) align_up(ptr, alignment);
+}
+
+void ArenaMemoryResource::do_deallocate(void *p, size_t bytes, size_t alignment) {
+    //对齐后的首地址已经不是Arena返回的地址 无法释放
+    if (alignment <= BytesPerWord) {
+        this->_arena->free(p, bytes);
+    }
+}
+
+bool ArenaMemoryResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept {
+    if (this == &other) {
+        return true;
+    }
+    const auto that = dynamic_cast<const ArenaMemoryResource *>(&other);
+    return that != nullptr && that->_arena == this->_arena;
+}
+
+ResourceMemoryResource::ResourceMemoryResource() :
+        ArenaMemoryResource(OSThread::current()->resource_arena()),
+        _mark() {
+}
@@ -0,0 +1,182 @@
+//
+// Created by aurora on 2026/10/19.
+//
+
+#include <cstring>
+#include "SlabAllocator.hpp"
+#include "plat/os/mem.hpp"
+#include "inner_os.hpp"
+#include "plat/thread/OSThread.hpp"
+#include "plat/thread/SpinYield.hpp"
+#include "plat/stream/CharOStream.hpp"
+#include "global/flag.hpp"
+
+const uint32_t SlabAllocator::_class_bytes[ClassCount] = {
+        16, 32, 48, 64, 80, 96, 112, 128,
+        160, 192, 224, 256,
+        320, 384, 448, 512,
+        640, 768, 896, 1024
+};
+uint8_t SlabAllocator::_class_index[] = {};
+SlabAllocator::Depot SlabAllocator::_depots[] = {};
+uint8_t SlabAllocator::_span_class[] = {};
+char *SlabAllocator::_base = nullptr;
+char *SlabAllocator::_end = nullptr;
+volatile size_t SlabAllocator::_next_span = 0;
+volatile size_t SlabAllocator::_flag_bytes[] = {};
+
+void SlabAllocator::initialize() {
+    const auto backend = global::CHeapBackend;
+    if (::strcmp(backend, "glibc") == 0) {
+        return;
+    }
+    // 必须在两者选择1个
+    guarantee(::strcmp(backend, "slab") == 0,
+              "CHeap backend is error, must be selected from glibc and slab.");
+    int cls = 0;
+    for (size_t i = 0; i <= MaxBytes / 16; ++i) {
+        while (_class_bytes[cls] < i * 16) {
+            ++cls;
+        }
+        _class_index[i] = (uint8_t) cls;
+    }
+    //其中的对象由CHEAP_ALLOC按照申请者的类型计入本地内存 区间本身不再记录
+    const auto base = (char *) os::reserve_untracked_aligned(RegionBytes, SpanBytes);
+    if (base == nullptr) {
+        //保留失败 继续使用malloc
+        return;
+    }
+    SlabAllocator::_end = base + RegionBytes;
+    SlabAllocator::_base = base;
+}
+
+void SlabAllocator::lock(Depot *depot) {
+    SpinYield spin;
+    while (OrderAccess::xchg(&depot->_lock, 1) != 0) {
+        spin.wait();
+    }
+}
+
+bool SlabAllocator::new_span(int cls) {
+    const auto index = OrderAccess::fetch_and_add<size_t>(&SlabAllocator::_next_span, 1);
+    if (index >= SpanCount) {
+        return false;
+    }
+    const auto span = SlabAllocator::_base + index * SpanBytes;
+    if (!os::commit_untracked(span, SpanBytes)) {
+        return false;
+    }
+    SlabAllocator::_span_class[index] = (uint8_t) (cls + 1);
+    //切分为对象 串成链表
+    const auto bytes = _class_bytes[cls];
+    const auto count = (uint32_t) (SpanBytes / bytes);
+    auto last = span;
+    for (uint32_t i = 1; i < count; ++i) {
+        const auto next = last + bytes;
+        *(void **) last = next;
+        last = next;
+    }
+    const auto depot = SlabAllocator::_depots + cls;
+    SlabAllocator::lock(depot);
+    *(void **) last = depot->_head;
+    depot->_head = span;
+    depot->_count += count;
+    ++depot->_spans;
+    SlabAllocator::unlock(depot);
+    return true;
+}
+
+void *SlabAllocator::alloc_batch(int cls, uint32_t count, uint32_t *taken) {
+    const auto depot = SlabAllocator::_depots + cls;
+    SlabAllocator::lock(depot);
+    while (depot->_count == 0) {
+        SlabAllocator::unlock(depot);
+        const auto added = SlabAllocator::new_span(cls);
+        SlabAllocator::lock(depot);
+        if (!added) {
+            break;
+        }
+    }
+    count = (uint32_t) MIN2<size_t>(count, depot->_count);
+    const auto first = depot->_head;
+    auto last = first;
+    for (uint32_t i = 1; i < count; ++i) {
+        last = *(void **) last;
+    }
+    if (count > 0) {
+        depot->_head = *(void **) last;
+        depot->_count -= count;
+        *(void **) last = nullptr;
+    }
+    SlabAllocator::unlock(depot);
+    *taken = count;
+    return count > 0 ? first : nullptr;
+}
+
+void SlabAllocator::free_batch(int cls, void *first, void *last, uint32_t count) {
+    const auto depot = SlabAllocator::_depots + cls;
+    SlabAllocator::lock(depot);
+    *(void **) last = depot->_head;
+    depot->_head = first;
+    depot->_count += count;
+    SlabAllocator::unlock(depot);
+}
+
+void *SlabAllocator::allocate(MEMFLAG F, size_t bytes) {
+    const auto cls = SlabAllocator::class_of(bytes);
+    if (cls < 0) {
+        return nullptr;
+    }
+    const auto thread = OSThread::current();
+    if (thread != nullptr) {
+        return thread->slab_cache()->alloc(F, cls);
+    }
+    //不属于虚拟机的线程 直接使用中央仓库
+    uint32_t taken;
+    const auto p = SlabAllocator::alloc_batch(cls, 1, &taken);
+    if (p != nullptr) {
+        SlabAllocator::add_flag_bytes((int32_t) F, _class_bytes[cls]);
+    }
+    return p;
+}
+
+void SlabAllocator::free(MEMFLAG F, void *p) {
+    const auto cls = SlabAllocator::class_of_pointer(p);
+    const auto thread = OSThread::current();
+    if (thread != nullptr) {
+        thread->slab_cache()->free(F, p, cls);
+        return;
+    }
+    SlabAllocator::free_batch(cls, p, p, 1);
+    SlabAllocator::add_flag_bytes((int32_t) F, -(size_t) _class_bytes[cls]);
+}
+
+void SlabAllocator::print_statistics(CharOStream *out) {
+    if (!SlabAllocator::is_enabled()) {
+        out->print_cr("slab allocator: disabled");
+        return;
+    }
+    const auto used = MIN2<size_t>(OrderAccess::load(&SlabAllocator::_next_span), SpanCount);
+    out->print_cr("slab allocator: " SIZE_FORMAT " of " SIZE_FORMAT " spans committed (" SIZE_FORMAT "K)",
+                  used, SpanCount, used * SpanBytes / K);
+    for (int cls = 0; cls < ClassCount; ++cls) {
+        const auto depot = SlabAllocator::_depots + cls;
+        SlabAllocator::lock(depot);
+        const auto spans = depot->_spans;
+        const auto count = depot->_count;
+        SlabAllocator::unlock(depot);
+        if (spans == 0) {
+            continue;
+        }
+        out->print_cr("  class %4u: " SIZE_FORMAT " spans, " SIZE_FORMAT " free in depot",
+                      _class_bytes[cls], spans, count);
+    }
+    //线程缓存中尚未合并的部分不包含在内
+    for (int32_t i = 0; i < (int32_t) MEMFLAG::num_of_type; ++i) {
+        const auto bytes = OrderAccess::load(SlabAllocator::_flag_bytes + i);
+        if (bytes == 0) {
+            continue;
+        }
+        out->print_cr("  %s: %ld bytes", MEMFLAG_NAME((MEMFLAG) i), (long) bytes);
+    }
+}
@@ -0,0 +1,83 @@
+//
+// Created by aurora on 2026/10/19.
+//
+
+#include "plat/mem/SlabCache.hpp"
+#include "SlabAllocator.hpp"
+#include "plat/macro.hpp"
+
+uint32_t SlabCache::capacity_of(int cls) {
+    return (uint32_t) MAX2<size_t>(CacheBytesPerClass / SlabAllocator::class_bytes(cls), MinCapacity);
+}
+
+SlabCache::SlabCache() :
+        _heads(),
+        _counts(),
+        _flag_bytes() {
+}
+
+SlabCache::~SlabCache() {
+    this->drain_all();
+}
+
+void SlabCache::flush_accounting() {
+    for (int32_t i = 0; i < (int32_t) MEMFLAG::num_of_type; ++i) {
+        if (this->_flag_bytes[i] != 0) {
+            SlabAllocator::add_flag_bytes(i, this->_flag_bytes[i]);
+            this->_flag_bytes[i] = 0;
+        }
+    }
+}
+
+void SlabCache::refill(int cls) {
+    assert(this->_counts[cls] == 0, "仅仅在链表为空时获取");
+    this->_heads[cls] = SlabAllocator::alloc_batch(cls, capacity_of(cls) / 2, this->_counts + cls);
+    this->flush_accounting();
+}
+
+void SlabCache::drain(int cls, uint32_t count) {
+    assert(count > 0 && count <= this->_counts[cls], "check");
+    auto first = this->_heads[cls];
+    auto last = first;
+    for (uint32_t i = 1; i < count; ++i) {
+        last = *(void **) last;
+    }
+    this->_heads[cls] = *(void **) last;
+    this->_counts[cls] -= count;
+    SlabAllocator::free_batch(cls, first, last, count);
+    this->flush_accounting();
+}
+
+void *SlabCache::alloc(MEMFLAG F, int cls) {
+    if (this->_counts[cls] == 0) {
+        this->refill(cls);
+        if (this->_counts[cls] == 0) {
+            return nullptr;
+        }
+    }
+    const auto p = this->_heads[cls];
+    this->_heads[cls] = *(void **) p;
+    --this->_counts[cls];
+    this->_flag_bytes[(int32_t) F] += SlabAllocator::class_bytes(cls);
+    return p;
+}
+
+void SlabCache::free(MEMFLAG F, void *p, int cls) {
+    const auto capacity = capacity_of(cls);
+    if (this->_counts[cls] >= capacity) {
+        this->drain(cls, capacity / 2);
+    }
+    *(void **) p = this->_heads[cls];
+    this->_heads[cls] = p;
+    ++this->_counts[cls];
+    this->_flag_bytes[(int32_t) F] -= SlabAllocator::class_bytes(cls);
+}
+
+void SlabCache::drain_all() {
+    for (int cls = 0; cls < ClassCount; ++cls) {
+        if (this->_counts[cls] > 0) {
+            this->drain(cls, this->_counts[cls]);
+        }
+    }
+    this->flush_accounting();
+}
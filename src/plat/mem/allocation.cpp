@@ -3,17 +3,94 @@
 //
 
 #include "plat/mem/allocation.hpp"
-#include <malloc.h>
 #include <cstdlib>
 #include "plat/utils/robust.hpp"
 #include "MemoryTracer.hpp"
+#include "MallocSiteTable.hpp"
+#include "SlabAllocator.hpp"
 #include "plat/mem/Arena.hpp"
 #include "plat/thread/OSThread.hpp"
+#include "plat/utils/align.hpp"
 /**
  * -----------------------------
  * CHeap 内存申请和分配
  * -----------------------------
  */
+
+/**
+ * 开启内存追踪时 位于每次申请的内存之前
+ * 释放时据此得到申请的字节数 内存类型和调用位置 不需要再查询malloc_usable_size
+ * 关闭内存追踪时没有头部 申请和释放直接调用malloc和free
+ * _canary 位于紧邻用户内存的字节 用于检查头部是否被破坏
+ */
+struct MallocHeader {
+    size_t _bytes;
+    uint32_t _site;
+    /**
+     * 用户内存 相对于malloc返回地址的偏移
+     */
+    uint16_t _offset;
+    uint8_t _flag;
+    uint8_t _canary;
+};
+static_assert(sizeof(MallocHeader) == 16, "头部保持16字节 不破坏malloc的对齐");
+constexpr static uint8_t MallocHeaderCanary = 0xA5;
+
+/**
+ * 写入头部 并按照调用位置统计
+ * @param base malloc返回的地址
+ * @param offset 用户内存的偏移 >= sizeof(MallocHeader)
+ * @return 用户内存
+ */
+static inline void *install_header(MEMFLAG F,
+                                   void *base,
+                                   size_t offset,
+                                   size_t bytes,
+                                   const NativeCallStack &stack) {
+    const auto user = (char *) base + offset;
+    const auto header = (MallocHeader *) user - 1;
+    header->_bytes = bytes;
+    header->_site = MallocSiteTable::record_alloc(F, stack, bytes);
+    header->_offset = (uint16_t) offset;
+    header->_flag = (uint8_t) F;
+    header->_canary = MallocHeaderCanary;
+    return user;
+}
+/**
+ * 按照CHeapBackend选择的后端申请 分级分配器无法提供时退回到malloc
+ */
+static inline void *backend_alloc(MEMFLAG F, size_t bytes) {
+    if (SlabAllocator::is_enabled()) {
+        const auto p = SlabAllocator::allocate(F, bytes);
+        if (p != nullptr) {
+            return p;
+        }
+    }
+    return ::malloc(bytes);
+}
+
+/**
+ * 根据地址判断由哪一个后端申请 开启之前malloc的内存同样可以正确的释放
+ */
+static inline void backend_free(MEMFLAG F, void *base) {
+    if (SlabAllocator::contains(base)) {
+        SlabAllocator::free(F, base);
+    } else {
+        ::free(base);
+    }
+}
+
+/**
+ * 第一次申请时确定追踪的等级 保证同一块内存申请和释放时对头部的判断一致
+ */
+static inline bool malloc_header_enabled() {
+    if (MemoryTracer::nmt_level() == MemoryTracer::NMT_Level::unknown) {
+        MemoryTracer::level_initialize();
+    }
+    assert(MemoryTracer::nmt_level() != MemoryTracer::NMT_Level::unknown, "追踪的等级没有确定");
+    return MemoryTracer::malloc_header_enabled();
+}
+
 extern const char *MEMFLAG_NAME(MEMFLAG flag) {
     switch (flag) {
 #define MEMORY_FLAG_DECLARE_ENUM(type, human_readable) \
@@ -29,7 +106,8 @@ extern void *CHEAP_ALLOC(MEMFLAG F,
                          size_t bytes,
                          bool exit_oom) {
     // 1 申请内存 然后进行内存的记录
-    const auto p = ::malloc(bytes);
+    const auto with_header = malloc_header_enabled();
+    const auto p = backend_alloc(F, with_header ? bytes + sizeof(MallocHeader) : bytes);
     if (p == nullptr) {
         if (!exit_oom) {
             return p;
@@ -41,14 +119,19 @@ extern void *CHEAP_ALLOC(MEMFLAG F,
                               bytes);
     }
 
-    auto size = ::malloc_usable_size(p);
+    if (!with_header) {
+        return p;
+    }
+    //从调用CHEAP_ALLOC的位置开始
+    const NativeCallStack stack(0);
+    const auto user = install_header(F, p, sizeof(MallocHeader), bytes, stack);
     MemoryTracer::record( F,
                          MemoryTracer::OperationType::native_alloc,
-                         p,
-                         size,
-                         CALLER_STACK);
+                         user,
+                         bytes,
+                         stack);
 
-    return p;
+    return user;
 }
 
 extern void *CHEAP_ALLOC_ALIGN(
@@ -57,8 +140,12 @@ extern void *CHEAP_ALLOC_ALIGN(
         size_t align,
         bool exit_oom) {
     void *value = nullptr;
-    //要求内存对齐到指定长度
-    auto res = ::posix_memalign(&value, bytes, align);
+    const auto with_header = malloc_header_enabled();
+    //头部占用的空间同样对齐到align 保证用户内存的对齐
+    const auto offset = with_header ? align_up(sizeof(MallocHeader), align) : 0;
+    assert(offset <= UINT16_MAX, "对齐的粒度过大");
+    //要求内存对齐到指定长度 总是使用posix_memalign 释放时根据地址区分
+    auto res = ::posix_memalign(&value, align, bytes + offset);
     if (res != 0) {
         //说明失败了 如果是要求退出虚拟机那么就进行退出
         if (!exit_oom) {
@@ -73,22 +160,37 @@ extern void *CHEAP_ALLOC_ALIGN(
                               align);
     }
     //说明申请成功了
+    if (!with_header) {
+        return value;
+    }
+    const NativeCallStack stack(0);
+    const auto user = install_header(F, value, offset, bytes, stack);
     MemoryTracer::record( F,
                          MemoryTracer::OperationType::native_alloc,
-                         value,
+                         user,
                          bytes,
-                         CALLER_STACK);
-    return value;
+                         stack);
+    return user;
 }
 
 extern void CHEAP_FREE(MEMFLAG F, void *p) {
-    auto size = ::malloc_usable_size(p);
-    MemoryTracer::record( F,
+    if (p == nullptr || !malloc_header_enabled()) {
+        backend_free(F, p);
+        return;
+    }
+    const auto header = (MallocHeader *) p - 1;
+    guarantee(header->_canary == MallocHeaderCanary,
+              "malloc header of " PTR_FORMAT " is corrupted", (uintptr_t) p);
+    assert(header->_flag == (uint8_t) F, "free %s memory as %s",
+           MEMFLAG_NAME((MEMFLAG) header->_flag), MEMFLAG_NAME(F));
+    MallocSiteTable::record_free(header->_site, header->_bytes);
+    //按照申请时的类型和字节数释放 保证汇总的统计可以归零
+    MemoryTracer::record((MEMFLAG) header->_flag,
                          MemoryTracer::OperationType::native_free,
                          p,
-                         size,
+                         header->_bytes,
                          CALLER_STACK);
-    ::free(p);
+    backend_free((MEMFLAG) header->_flag, (char *) p - header->_offset);
 }
 
 /**
@@ -110,6 +212,15 @@ extern void ARENA_FREE(
     arena->free(ptr,bytes);
 }
 
+extern void *ARENA_REALLOC(
+        Arena *arena,
+        void *ptr,
+        size_t old_bytes,
+        size_t new_bytes,
+        bool exit_oom){
+    return arena->realloc(ptr,old_bytes,new_bytes,exit_oom);
+}
+
 /**
  * -----------------------------
  * 线程栈资源申请和分配
@@ -127,3 +238,12 @@ extern void RESOURCE_ARENA_FREE(void *ptr, size_t bytes){
     ARENA_FREE(arena,ptr,bytes);
 }
 
+extern void *RESOURCE_ARENA_REALLOC(
+        void *ptr,
+        size_t old_bytes,
+        size_t new_bytes,
+        bool exit_oom){
+    const auto arena =    OSThread::current()->resource_arena();
+    return ARENA_REALLOC(arena,ptr,old_bytes,new_bytes,exit_oom);
+}
+
@@ -8,12 +8,20 @@
 #include <linux/futex.h>
 #include <cerrno>
 #include <sys/resource.h>
+#include <sched.h>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <cmath>
 #include "plat/os/cpu.hpp"
 #include "plat/utils/robust.hpp"
 #include "plat/thread/OSThread.hpp"
 #include "plat/constants.hpp"
 #include "global/flag.hpp"
 #include "plat/utils/OrderAccess.hpp"
+#include "plat/stream/CharOStream.hpp"
+#include "plat/utils/align.hpp"
+#include "inner_os.hpp"
 
 namespace os {
     static int16_t LANG_TO_OS_PRIO[TotalPriority] = {
@@ -34,11 +42,448 @@ namespace os {
             -5,              // 10 MaxPriority
     };
 
+    uint32_t CpuSet::count() const {
+        uint32_t num = 0;
+        for (auto word: _bits) {
+            num += (uint32_t) __builtin_popcountll(word);
+        }
+        return num;
+    }
+
+    uint32_t CpuSet::next(uint32_t from) const {
+        while (from < MaxCpus) {
+            const auto word = _bits[from / WordBits] >> (from % WordBits);
+            if (word != 0) {
+                return from + (uint32_t) __builtin_ctzll(word);
+            }
+            from = align_down(from, WordBits) + WordBits;
+        }
+        return MaxCpus;
+    }
+
+    bool CpuSet::parse_list(const char *list) {
+        auto p = list;
+        while (*p != '\0' && *p != '\n') {
+            char *end;
+            //strtoul会跳过空白 并且接受符号 必须以数字开始
+            if (!::isdigit((unsigned char) *p)) {
+                return false;
+            }
+            const auto first = ::strtoul(p, &end, 10);
+            auto last = first;
+            p = end;
+            if (*p == '-') {
+                if (!::isdigit((unsigned char) p[1])) {
+                    return false;
+                }
+                last = ::strtoul(p + 1, &end, 10);
+                if (last < first) {
+                    return false;
+                }
+                p = end;
+            }
+            for (auto cpu = first; cpu <= last && cpu < MaxCpus; ++cpu) {
+                add((uint32_t) cpu);
+            }
+            if (*p == ',') {
+                ++p;
+            }
+        }
+        return true;
+    }
+
+    void CpuSet::print_on(CharOStream *out) const {
+        const char *sep = "";
+        for (auto first = next(0); first < MaxCpus;) {
+            auto last = first;
+            while (last + 1 < MaxCpus && contains(last + 1)) {
+                ++last;
+            }
+            if (last == first) {
+                out->print("%s%u", sep, first);
+            } else {
+                out->print("%s%u-%u", sep, first, last);
+            }
+            sep = ",";
+            first = next(last + 1);
+        }
+    }
+
     /**
-     * 返回 可用的cpu的数量
-     * @return
+     * 每个CPU在拓扑中的位置
+     * 核心和最后一级缓存用组内最小的CPU编号表示 同组的CPU编号相同
+     */
+    struct CpuInfo {
+        int16_t _node;
+        uint16_t _core;
+        uint16_t _llc;
+    };
+
+    static CpuTopology _topology;
+    static CpuSet _online_cpus;
+    static CpuSet _allowed_cpus;
+    static CpuInfo _cpu_info[CpuSet::MaxCpus];
+
+    /**
+     * 读取sysfs或者cgroup中的CPU列表
+     */
+    static bool read_cpu_list(const char *path, CpuSet *set) {
+        char buf[4096];
+        if (read_small_file(path, buf, sizeof(buf)) <= 0) {
+            return false;
+        }
+        set->clear();
+        return set->parse_list(buf) && !set->is_empty();
+    }
+
+    /**
+     * @return 类似"48K" "32M"的缓存大小 失败返回0
+     */
+    static size_t read_size_file(const char *path) {
+        char buf[64];
+        unsigned long value;
+        char unit = '\0';
+        if (read_small_file(path, buf, sizeof(buf)) <= 0 ||
+            ::sscanf(buf, "%lu%c", &value, &unit) < 1) {
+            return 0;
+        }
+        switch (unit) {
+            case 'K':
+                return value * K;
+            case 'M':
+                return value * M;
+            case 'G':
+                return value * G;
+            default:
+                return value;
+        }
+    }
+
+    /**
+     * 把同一组(共享核心或者缓存)的CPU标记为组内最小的在线CPU
+     * @param pattern 组成员列表的路径模板 参数为CPU编号
+     * @param field 需要写入的字段
+     * @return 组的数量 只统计包含允许的CPU的组
+     */
+    static uint32_t group_cpus(const char *pattern, uint16_t CpuInfo::*field) {
+        CpuSet visited;
+        uint32_t num_groups = 0;
+        char path[128];
+        for (auto cpu = _online_cpus.next(0); cpu < CpuSet::MaxCpus; cpu = _online_cpus.next(cpu + 1)) {
+            if (visited.contains(cpu)) {
+                continue;
+            }
+            CpuSet group;
+            ::snprintf(path, sizeof(path), pattern, cpu);
+            if (!read_cpu_list(path, &group)) {
+                group.clear();
+            }
+            group.intersect(_online_cpus);
+            //读取失败时自成一组
+            group.add(cpu);
+            const auto leader = (uint16_t) group.next(0);
+            bool allowed = false;
+            for (auto c = group.next(0); c < CpuSet::MaxCpus; c = group.next(c + 1)) {
+                _cpu_info[c].*field = leader;
+                visited.add(c);
+                allowed |= _allowed_cpus.contains(c);
+            }
+            num_groups += allowed ? 1 : 0;
+        }
+        return num_groups;
+    }
+
+    /**
+     * 解析第一个允许的CPU的缓存 假定所有的CPU相同
+     * @return 最后一级缓存在cache目录中的序号 没有缓存信息时返回-1
+     */
+    static int32_t parse_caches(uint32_t cpu) {
+        char path[128];
+        int32_t llc_index = -1;
+        uint64_t llc_level = 0;
+        for (int32_t index = 0;; ++index) {
+            ::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cache/index%d/level", cpu, index);
+            const auto level = read_u64_file(path);
+            if (level == 0) {
+                break;
+            }
+            char type[32];
+            ::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cache/index%d/type", cpu, index);
+            if (read_small_file(path, type, sizeof(type)) <= 0 || ::strncmp(type, "Instruction", 11) == 0) {
+                continue;
+            }
+            ::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cache/index%d/size", cpu, index);
+            const auto bytes = read_size_file(path);
+            if (level == 1) {
+                _topology._l1d_bytes = bytes;
+                ::snprintf(path, sizeof(path),
+                           "/sys/devices/system/cpu/cpu%u/cache/index%d/coherency_line_size", cpu, index);
+                _topology._cache_line_bytes = read_u64_file(path);
+            } else if (level == 2) {
+                _topology._l2_bytes = bytes;
+            }
+            if (level > llc_level) {
+                llc_level = level;
+                llc_index = index;
+                _topology._llc_bytes = bytes;
+            }
+        }
+        return llc_index;
+    }
+
+    /**
+     * @return 一个cgroup目录的CPU配额 不限制或者读取失败时返回0
      */
+    static double cgroup_dir_quota(const char *dir, bool v2) {
+        char path[600];
+        char buf[64];
+        if (v2) {
+            //"max 100000" 或者 "200000 100000"
+            unsigned long quota, period;
+            ::snprintf(path, sizeof(path), "%s/cpu.max", dir);
+            if (read_small_file(path, buf, sizeof(buf)) <= 0 ||
+                ::sscanf(buf, "%lu %lu", &quota, &period) != 2 || period == 0) {
+                return 0;
+            }
+            return (double) quota / (double) period;
+        }
+        //不限制时为-1
+        long quota;
+        ::snprintf(path, sizeof(path), "%s/cpu.cfs_quota_us", dir);
+        if (read_small_file(path, buf, sizeof(buf)) <= 0 ||
+            ::sscanf(buf, "%ld", &quota) != 1 || quota <= 0) {
+            return 0;
+        }
+        ::snprintf(path, sizeof(path), "%s/cpu.cfs_period_us", dir);
+        const auto period = read_u64_file(path);
+        return period == 0 ? 0 : (double) quota / (double) period;
+    }
+
+    /**
+     * 从自己所在的cgroup向上直到挂载点 取最小的配额 上层的限制同样生效
+     * @param cgroup_dir locate_cgroup定位的目录
+     * @param mount_len 挂载点的长度 不越过挂载点向上查找
+     * @return 不限制返回0
+     */
+    static double cgroup_quota(const char *cgroup_dir, size_t mount_len, bool v2) {
+        char dir[512];
+        ::snprintf(dir, sizeof(dir), "%s", cgroup_dir);
+        double quota = 0;
+        while (true) {
+            const auto value = cgroup_dir_quota(dir, v2);
+            if (value > 0 && (quota == 0 || value < quota)) {
+                quota = value;
+            }
+            const auto slash = ::strrchr(dir, '/');
+            if (slash == nullptr || (size_t) (slash - dir) < mount_len) {
+                break;
+            }
+            *slash = '\0';
+        }
+        return quota;
+    }
+
+    /**
+     * 解析cgroup的CPU配额和cpuset 配额写入_topology cpuset与允许的CPU取交集
+     */
+    static void parse_cgroup() {
+        char v2_dir[512];
+        char dir[512];
+        size_t v2_mount_len;
+        size_t mount_len;
+        const auto has_v2 = locate_cgroup(nullptr, v2_dir, sizeof(v2_dir), &v2_mount_len);
+        if (locate_cgroup("cpu", dir, sizeof(dir), &mount_len)) {
+            _topology._quota_cpus = cgroup_quota(dir, mount_len, false);
+        } else if (has_v2) {
+            _topology._quota_cpus = cgroup_quota(v2_dir, v2_mount_len, true);
+        }
+        char path[600];
+        CpuSet cpuset;
+        if (locate_cgroup("cpuset", dir, sizeof(dir), nullptr)) {
+            ::snprintf(path, sizeof(path), "%s/cpuset.cpus", dir);
+        } else if (has_v2) {
+            ::snprintf(path, sizeof(path), "%s/cpuset.cpus.effective", v2_dir);
+        } else {
+            return;
+        }
+        //sched_getaffinity通常已经体现了cpuset 这里只是防止亲和性读取失败
+        if (read_cpu_list(path, &cpuset)) {
+            cpuset.intersect(_online_cpus);
+            if (!cpuset.is_empty()) {
+                _allowed_cpus.intersect(cpuset);
+            }
+        }
+    }
+
+    void cpu_topology_initialize() {
+        auto &topology = _topology;
+        CpuSet possible;
+        if (!read_cpu_list("/sys/devices/system/cpu/possible", &possible)) {
+            possible.clear();
+            for (uint32_t cpu = 0; cpu < (uint32_t) ::sysconf(_SC_NPROCESSORS_CONF); ++cpu) {
+                possible.add(cpu);
+            }
+        }
+        if (!read_cpu_list("/sys/devices/system/cpu/online", &_online_cpus)) {
+            _online_cpus.clear();
+            for (uint32_t cpu = 0; cpu < (uint32_t) ::sysconf(_SC_NPROCESSORS_ONLN); ++cpu) {
+                _online_cpus.add(cpu);
+            }
+        }
+        topology._num_possible = MAX2(possible.count(), _online_cpus.count());
+        topology._num_online = _online_cpus.count();
+        for (uint32_t cpu = 0; cpu < CpuSet::MaxCpus; ++cpu) {
+            _cpu_info[cpu]._node = -1;
+            _cpu_info[cpu]._core = (uint16_t) cpu;
+            _cpu_info[cpu]._llc = (uint16_t) cpu;
+        }
+        //线程的亲和性 taskset以及cpuset都会体现在这里
+        _allowed_cpus = _online_cpus;
+        CpuSet mask;
+        if (get_thread_affinity(0, &mask) == OSReturn::OK) {
+            mask.intersect(_online_cpus);
+            if (!mask.is_empty()) {
+                _allowed_cpus = mask;
+            }
+        }
+        if (global::UseContainerSupport) {
+            parse_cgroup();
+        }
+        topology._num_allowed = _allowed_cpus.count();
+        auto effective = topology._num_allowed;
+        if (topology._quota_cpus > 0) {
+            effective = MIN2(effective, (uint32_t) ::ceil(topology._quota_cpus));
+        }
+        topology._effective_cpus = MAX2<uint32_t>(effective, 1);
+
+        //NUMA节点 没有节点信息时视为一个节点
+        CpuSet nodes;
+        topology._num_nodes = 0;
+        if (read_cpu_list("/sys/devices/system/node/online", &nodes)) {
+            char path[128];
+            for (auto node = nodes.next(0); node < CpuSet::MaxCpus; node = nodes.next(node + 1)) {
+                CpuSet cpus;
+                ::snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+                if (!read_cpu_list(path, &cpus)) {
+                    continue;
+                }
+                bool allowed = false;
+                for (auto cpu = cpus.next(0); cpu < CpuSet::MaxCpus; cpu = cpus.next(cpu + 1)) {
+                    _cpu_info[cpu]._node = (int16_t) node;
+                    allowed |= _allowed_cpus.contains(cpu);
+                }
+                topology._num_nodes += allowed ? 1 : 0;
+            }
+        }
+        topology._num_nodes = MAX2<uint32_t>(topology._num_nodes, 1);
+
+        //超线程以及插槽
+        topology._num_cores = group_cpus("/sys/devices/system/cpu/cpu%u/topology/thread_siblings_list",
+                                         &CpuInfo::_core);
+        CpuSet packages;
+        char path[128];
+        for (auto cpu = _allowed_cpus.next(0); cpu < CpuSet::MaxCpus; cpu = _allowed_cpus.next(cpu + 1)) {
+            ::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/physical_package_id", cpu);
+            packages.add((uint32_t) read_u64_file(path));
+        }
+        topology._num_packages = MAX2<uint32_t>(packages.count(), 1);
+
+        //缓存
+        const auto first = _allowed_cpus.next(0);
+        const auto llc_index = parse_caches(first);
+        if (llc_index >= 0) {
+            char pattern[128];
+            ::snprintf(pattern, sizeof(pattern),
+                       "/sys/devices/system/cpu/cpu%%u/cache/index%d/shared_cpu_list", llc_index);
+            group_cpus(pattern, &CpuInfo::_llc);
+        }
+        if (topology._cache_line_bytes == 0) {
+            const auto line = ::sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+            topology._cache_line_bytes = line > 0 ? (size_t) line : 64;
+        }
+        CpuSet llc;
+        cpu_llc_siblings(first, &llc);
+        topology._llc_cpus = llc.count();
+    }
+
+    const CpuTopology &cpu_topology() {
+        return _topology;
+    }
+
+    const CpuSet &allowed_cpus() {
+        return _allowed_cpus;
+    }
+
+    int32_t cpu_node(uint32_t cpu) {
+        return cpu < CpuSet::MaxCpus ? _cpu_info[cpu]._node : -1;
+    }
+
+    /**
+     * 收集field与cpu相同的在线CPU
+     */
+    static void same_group(uint32_t cpu, uint16_t CpuInfo::*field, CpuSet *set) {
+        set->clear();
+        if (cpu >= CpuSet::MaxCpus) {
+            return;
+        }
+        const auto leader = _cpu_info[cpu].*field;
+        for (auto c = _online_cpus.next(0); c < CpuSet::MaxCpus; c = _online_cpus.next(c + 1)) {
+            if (_cpu_info[c].*field == leader) {
+                set->add(c);
+            }
+        }
+        set->add(cpu);
+    }
+
+    void cpu_core_siblings(uint32_t cpu, CpuSet *siblings) {
+        same_group(cpu, &CpuInfo::_core, siblings);
+    }
+
+    void cpu_llc_siblings(uint32_t cpu, CpuSet *siblings) {
+        same_group(cpu, &CpuInfo::_llc, siblings);
+    }
+
+    void node_cpus(int32_t node, CpuSet *cpus) {
+        cpus->clear();
+        for (auto c = _online_cpus.next(0); c < CpuSet::MaxCpus; c = _online_cpus.next(c + 1)) {
+            if (_cpu_info[c]._node == node) {
+                cpus->add(c);
+            }
+        }
+    }
+
+    void print_cpu_topology(CharOStream *out) {
+        const auto &topology = _topology;
+        out->print("cpus: possible %u online %u allowed %u (", topology._num_possible,
+                   topology._num_online, topology._num_allowed);
+        _allowed_cpus.print_on(out);
+        out->print_cr(") effective %u quota %.2f", topology._effective_cpus, topology._quota_cpus);
+        out->print_cr("topology: %u nodes %u packages %u cores", topology._num_nodes,
+                      topology._num_packages, topology._num_cores);
+        out->print_cr("cache: line " SIZE_FORMAT "B L1d " SIZE_FORMAT "K L2 " SIZE_FORMAT "K LLC "
+                      SIZE_FORMAT "K shared by %u cpus",
+                      topology._cache_line_bytes, topology._l1d_bytes / K, topology._l2_bytes / K,
+                      topology._llc_bytes / K, topology._llc_cpus);
+        CpuSet nodes;
+        for (auto c = _online_cpus.next(0); c < CpuSet::MaxCpus; c = _online_cpus.next(c + 1)) {
+            if (_cpu_info[c]._node >= 0) {
+                nodes.add(_cpu_info[c]._node);
+            }
+        }
+        for (auto node = nodes.next(0); node < CpuSet::MaxCpus; node = nodes.next(node + 1)) {
+            CpuSet cpus;
+            node_cpus((int32_t) node, &cpus);
+            out->print("node %u: ", node);
+            cpus.print_on(out);
+            out->cr();
+        }
+    }
+
     uint32_t avail_cpu_num() {
+        if (_topology._effective_cpus != 0) {
+            return _topology._effective_cpus;
+        }
+        //拓扑初始化之前
         static auto num = (uint32_t) ::sysconf(_SC_NPROCESSORS_ONLN);
         return num;
     }
@@ -131,6 +576,81 @@ namespace os {
 #undef NATIVE_PRIO_DEFINE
     }
 
+    bool parse_sched_policy(const char *name, SchedPolicy *policy) {
+        if (::strcmp(name, "other") == 0) {
+            *policy = SchedPolicy::other;
+        } else if (::strcmp(name, "batch") == 0) {
+            *policy = SchedPolicy::batch;
+        } else if (::strcmp(name, "fifo") == 0) {
+            *policy = SchedPolicy::fifo;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    const char *sched_policy_name(SchedPolicy policy) {
+        switch (policy) {
+            case SchedPolicy::other:
+                return "other";
+            case SchedPolicy::batch:
+                return "batch";
+            case SchedPolicy::fifo:
+                return "fifo";
+        }
+        return "unknown";
+    }
+
+    OSReturn set_sched_policy(int32_t thread_id,
+                              SchedPolicy policy,
+                              int32_t rt_priority) {
+        struct ::sched_param param{};
+        int native_policy;
+        switch (policy) {
+            case SchedPolicy::batch:
+                native_policy = SCHED_BATCH;
+                break;
+            case SchedPolicy::fifo:
+                native_policy = SCHED_FIFO;
+                param.sched_priority = clamp<int32_t>(rt_priority,
+                                                      ::sched_get_priority_min(SCHED_FIFO),
+                                                      ::sched_get_priority_max(SCHED_FIFO));
+                break;
+            default:
+                native_policy = SCHED_OTHER;
+                break;
+        }
+        //普通策略下nice值保持不变 ThreadPriority仍然有效
+        return ::sched_setscheduler(thread_id, native_policy, &param) == 0 ? OSReturn::OK : OSReturn::ERR;
+    }
+
+    OSReturn set_thread_affinity(int32_t thread_id,
+                                 const CpuSet &cpus) {
+        assert(!cpus.is_empty(), "cpus must not be empty");
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        for (auto cpu = cpus.next(0); cpu < CpuSet::MaxCpus && cpu < CPU_SETSIZE; cpu = cpus.next(cpu + 1)) {
+            CPU_SET(cpu, &mask);
+        }
+        return ::sched_setaffinity(thread_id, sizeof(mask), &mask) == 0 ? OSReturn::OK : OSReturn::ERR;
+    }
+
+    OSReturn get_thread_affinity(int32_t thread_id,
+                                 CpuSet *cpus) {
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        if (::sched_getaffinity(thread_id, sizeof(mask), &mask) != 0) {
+            return OSReturn::ERR;
+        }
+        cpus->clear();
+        for (uint32_t cpu = 0; cpu < CpuSet::MaxCpus && cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &mask)) {
+                cpus->add(cpu);
+            }
+        }
+        return OSReturn::OK;
+    }
+
     bool create_thread(OSThread *thread, bool detach) {
         assert(thread != nullptr, "thread is null");
         assert(thread->_os_state == OSThread::STATE_NEW,"check");
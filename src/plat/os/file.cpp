@@ -130,4 +130,38 @@ namespace os {
     void close(int32_t fd) {
         ::close(fd);
     }
+
+    bool read_at(int32_t fd, void *buf, size_t bytes, size_t offset) {
+        auto p = (char *) buf;
+        while (bytes > 0) {
+            const auto n = ::pread64(fd, p, bytes, (off64_t) offset);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            p += n;
+            bytes -= n;
+            offset += n;
+        }
+        return true;
+    }
+
+    bool write_at(int32_t fd, const void *data, size_t bytes, size_t offset) {
+        auto p = (const char *) data;
+        while (bytes > 0) {
+            const auto n = ::pwrite64(fd, p, bytes, (off64_t) offset);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            p += n;
+            bytes -= n;
+            offset += n;
+        }
+        return true;
+    }
 }
\ No newline at end of file
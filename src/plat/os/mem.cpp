@@ -3,13 +3,20 @@
 //
 #include "plat/os/mem.hpp"
 #include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <cstdio>
+#include <cstring>
 #include <sys/mman.h>
 #include "plat/utils/robust.hpp"
 #include <malloc.h>
 #include "MemoryTracer.hpp"
+#include "inner_os.hpp"
 #include "plat/utils/NativeCallStack.hpp"
 #include "plat/stream/CharOStream.hpp"
 #include "plat/utils/align.hpp"
+#include "global/flag.hpp"
+#include <cerrno>
 namespace os {
     /**
      * 获取页框的大小
@@ -92,7 +99,6 @@ namespace os {
         assert(fd >= -1, "fd(%d) must be >= -1", fd);
         auto ptr = memory_mmap(nullptr, bytes, fd, false);
         if (ptr != nullptr) {
-            NativeCallStack caller(NativeCallStack::MAX_DEPTH);
             MemoryTracer::record(F,
                                  MemoryTracer::OperationType::reserve,
                                  ptr,
@@ -103,6 +109,28 @@ namespace os {
     }
 
 
+    /**
+     * 从多保留了align字节的区间中切出对齐的部分 两端多余的部分交给release释放
+     * [    |                     |     ]
+     * ^    ^ aligned_base        ^ aligned_base + size
+     * extra_base                       ^extra_base + extra_size
+     */
+    template<typename Release>
+    static void *trim_to_aligned(void *extra_base, size_t extra_size,
+                                 size_t bytes, size_t align, Release release) {
+        const auto aligned_base = (char *) align_up<size_t>((size_t) extra_base, align);
+        assert(is_aligned((size_t) aligned_base, align), "check");
+        auto begin_offset = aligned_base - (char *) extra_base;
+        auto end_offset = ((char *) extra_base + extra_size) - (aligned_base + bytes);
+        if (begin_offset > 0) {
+            release(extra_base, begin_offset);
+        }
+        if (end_offset > 0) {
+            release((char *) extra_base + begin_offset + bytes, end_offset);
+        }
+        return aligned_base;
+    }
+
     void *reserve_memory_aligned(MEMFLAG F, size_t bytes, size_t align, int32_t fd) {
         /**
          * 计算总共需要映射的大小
@@ -122,24 +150,25 @@ namespace os {
             //failed
             return nullptr;
         }
+        return trim_to_aligned(extra_base, extra_size, bytes, align, [F](void *addr, size_t len) {
+            release_memory(F, addr, len);
+        });
+    }
 
-        /**
-         * 对于多余的内存块应该进行切割下去 即使
-         * [    |                     |     ]
-         * ^    ^ aligned_base        ^ aligned_base + size
-         * extra_base                       ^extra_base + extra_size
-         */
-        const auto aligned_base = (char *) align_up<size_t>((size_t) extra_base, align);
-        assert(is_aligned((size_t) aligned_base, align), "check");
-        auto begin_offset = aligned_base - (char *) extra_base;
-        auto end_offset = ((char *) extra_base + extra_size) - (aligned_base + bytes);
-        if (begin_offset > 0) {
-            release_memory(F, extra_base, begin_offset);
+    void *reserve_untracked_aligned(size_t bytes, size_t align) {
+        assert_is_aligned(align, page_size());
+        assert_is_aligned(bytes, align);
+        const auto extra_size = bytes + align;
+        if (extra_size < bytes) {
+            return nullptr;
         }
-        if (end_offset > 0) {
-            release_memory(F, (char *) extra_base + begin_offset + bytes, end_offset);
+        const auto extra_base = memory_mmap(nullptr, extra_size, -1, false);
+        if (extra_base == nullptr) {
+            return nullptr;
         }
-        return aligned_base;
+        return trim_to_aligned(extra_base, extra_size, bytes, align, [](void *addr, size_t len) {
+            memory_unmap(addr, len);
+        });
     }
 
 
@@ -157,6 +186,25 @@ namespace os {
         return success;
     }
 
+    bool release_committed_memory(MEMFLAG F, void *addr, size_t bytes) {
+        assert_is_aligned((size_t) addr, page_size());
+        assert_is_aligned(bytes, page_size());
+        auto success = memory_unmap(addr, bytes);
+        if (success) {
+            MemoryTracer::record(F,
+                                 MemoryTracer::OperationType::uncommit,
+                                 addr,
+                                 bytes,
+                                 CALLER_STACK);
+            MemoryTracer::record(F,
+                                 MemoryTracer::OperationType::release,
+                                 addr,
+                                 bytes,
+                                 CALLER_STACK);
+        }
+        return success;
+    }
+
     void *reserve_memory_at(MEMFLAG F, void *addr, size_t bytes, int32_t fd) {
         assert(addr != nullptr, "addr is not allow null");
         assert_is_aligned(bytes, page_size());
@@ -190,27 +238,180 @@ namespace os {
         return real_addr;
     }
 
-    bool commit_memory(MEMFLAG F, void *addr, size_t bytes, CommitType type) {
-        assert(addr != nullptr, "addr is not allow null");
-        assert_is_aligned(bytes, page_size());
+    bool parse_large_page_mode(const char *name, LargePageMode *mode) {
+        if (::strcmp(name, "off") == 0) {
+            *mode = LargePageMode::off;
+        } else if (::strcmp(name, "thp") == 0) {
+            *mode = LargePageMode::thp;
+        } else if (::strcmp(name, "hugetlb") == 0) {
+            *mode = LargePageMode::hugetlb;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    const char *large_page_mode_name(LargePageMode mode) {
+        switch (mode) {
+            case LargePageMode::off:
+                return "off";
+            case LargePageMode::thp:
+                return "thp";
+            case LargePageMode::hugetlb:
+                return "hugetlb";
+        }
+        return "unknown";
+    }
+
+    int32_t huge_page_sizes(size_t *sizes, int32_t max_sizes) {
+        //每种大小对应一个目录 hugepages-2048kB
+        const auto dir = ::opendir("/sys/kernel/mm/hugepages");
+        if (dir == nullptr) {
+            return 0;
+        }
+        int32_t num = 0;
+        struct dirent *entry;
+        while ((entry = ::readdir(dir)) != nullptr) {
+            unsigned long kb;
+            if (::sscanf(entry->d_name, "hugepages-%lukB", &kb) != 1) {
+                continue;
+            }
+            //插入排序 从小到大
+            auto pos = MIN2(num, max_sizes);
+            while (pos > 0 && sizes[pos - 1] > kb * K) {
+                if (pos < max_sizes) {
+                    sizes[pos] = sizes[pos - 1];
+                }
+                --pos;
+            }
+            if (pos < max_sizes) {
+                sizes[pos] = kb * K;
+            }
+            ++num;
+        }
+        ::closedir(dir);
+        return num;
+    }
+
+    size_t default_huge_page_size() {
+        static const auto bytes = []() -> size_t {
+            const auto file = ::fopen("/proc/meminfo", "r");
+            if (file == nullptr) {
+                return 0;
+            }
+            char line[256];
+            unsigned long kb = 0;
+            while (::fgets(line, sizeof(line), file) != nullptr) {
+                if (::sscanf(line, "Hugepagesize: %lu kB", &kb) == 1) {
+                    break;
+                }
+            }
+            ::fclose(file);
+            return kb * K;
+        }();
+        return bytes;
+    }
+
+    THPMode thp_mode() {
+        const auto file = ::fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+        if (file == nullptr) {
+            return THPMode::unsupported;
+        }
+        //当前的模式用方括号标出 always [madvise] never
+        char line[128] = {};
+        const auto read = ::fgets(line, sizeof(line), file) != nullptr;
+        ::fclose(file);
+        if (!read) {
+            return THPMode::unsupported;
+        }
+        if (::strstr(line, "[always]") != nullptr) {
+            return THPMode::always;
+        }
+        if (::strstr(line, "[madvise]") != nullptr) {
+            return THPMode::madvise;
+        }
+        return THPMode::never;
+    }
+
+    void *reserve_memory_huge(MEMFLAG F, size_t bytes, size_t page_bytes) {
+        assert(is_power_of_2(page_bytes), "大页的大小必须是2的幂");
+        assert_is_aligned(bytes, page_bytes);
+        /**
+         * 大页的大小编码在标志中 内核按照该大小对齐地址
+         * 不指定MAP_NORESERVE 预留的大页不足时在此处失败 而不是在访问时产生SIGBUS
+         */
+        const auto flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+                           (__builtin_ctzl(page_bytes) << MAP_HUGE_SHIFT);
+        const auto addr = ::mmap(nullptr, bytes, PROT_NONE, flags, -1, 0);
+        if (addr == MAP_FAILED) {
+            return nullptr;
+        }
+        MemoryTracer::record(F,
+                             MemoryTracer::OperationType::reserve,
+                             addr,
+                             bytes,
+                             CALLER_STACK);
+        return addr;
+    }
+
+    bool advise_huge_pages(void *addr, size_t bytes, bool enable) {
         assert_is_aligned((size_t) addr, page_size());
-        int32_t prot_type;
+        assert_is_aligned(bytes, page_size());
+        return ::madvise(addr, bytes, enable ? MADV_HUGEPAGE : MADV_NOHUGEPAGE) == 0;
+    }
+
+    bool page_info(void *addr, size_t bytes, PageInfo *info) {
+        const auto file = ::fopen("/proc/self/smaps", "r");
+        if (file == nullptr) {
+            return false;
+        }
+        const auto lo = (uintptr_t) addr;
+        const auto hi = lo + bytes;
+        *info = {0, 0, 0};
+        bool found = false;
+        bool in_range = false;
+        char line[512];
+        while (::fgets(line, sizeof(line), file) != nullptr) {
+            unsigned long start, end, kb;
+            //映射的首行 start-end perms ...
+            if (::sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+                in_range = start < hi && end > lo;
+                found |= in_range;
+                continue;
+            }
+            if (!in_range) {
+                continue;
+            }
+            if (::sscanf(line, "KernelPageSize: %lu kB", &kb) == 1) {
+                info->_page_bytes = MAX2<size_t>(info->_page_bytes, kb * K);
+            } else if (::sscanf(line, "Rss: %lu kB", &kb) == 1) {
+                info->_rss_bytes += kb * K;
+            } else if (::sscanf(line, "AnonHugePages: %lu kB", &kb) == 1) {
+                info->_thp_bytes += kb * K;
+            }
+        }
+        ::fclose(file);
+        return found;
+    }
+
+    static int32_t prot_of(CommitType type) {
         switch (type) {
-            case CommitType::none:
-                prot_type = PROT_NONE;
-                break;
             case CommitType::r:
-                prot_type = PROT_READ;
-                break;
+                return PROT_READ;
             case CommitType::rw:
-                prot_type = PROT_READ | PROT_WRITE;
-                break;
+                return PROT_READ | PROT_WRITE;
             case CommitType::rwx:
-                prot_type = PROT_READ | PROT_WRITE | PROT_EXEC;
-                break;
+                return PROT_READ | PROT_WRITE | PROT_EXEC;
+            default:
+                return PROT_NONE;
         }
+    }
 
-        auto success = ::mprotect(addr, bytes, prot_type) == 0;
+    bool commit_memory(MEMFLAG F, void *addr, size_t bytes, CommitType type) {
+        assert(addr != nullptr, "addr is not allow null");
+        assert_is_aligned(bytes, page_size());
+        assert_is_aligned((size_t) addr, page_size());
+        auto success = ::mprotect(addr, bytes, prot_of(type)) == 0;
         if (success) {
             MemoryTracer::record(F,
                                  MemoryTracer::OperationType::commit,
@@ -221,13 +422,408 @@ namespace os {
         return success;
     }
 
-    bool uncommit_memory(MEMFLAG F, void *addr, size_t bytes) {
+    bool commit_untracked(void *addr, size_t bytes) {
         assert(addr != nullptr, "addr is not allow null");
         assert_is_aligned(bytes, page_size());
         assert_is_aligned((size_t) addr, page_size());
-        auto success = ::mprotect(addr, bytes, PROT_NONE) == 0;
-        if (success) {
-            success = ::madvise(addr, bytes, MADV_DONTNEED) == 0;
+        return ::mprotect(addr, bytes, prot_of(CommitType::rw)) == 0;
+    }
+
+    const char *pressure_source_name(PressureSource source) {
+        switch (source) {
+            case PressureSource::none:
+                return "none";
+            case PressureSource::cgroup_psi:
+                return "cgroup_psi";
+            case PressureSource::psi:
+                return "psi";
+            case PressureSource::cgroup:
+                return "cgroup";
+            case PressureSource::avail:
+                return "avail";
+        }
+        return "unknown";
+    }
+
+    ssize_t read_small_file(const char *path, char *buf, size_t bytes) {
+        const auto fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return -1;
+        }
+        const auto n = ::read(fd, buf, bytes - 1);
+        ::close(fd);
+        if (n >= 0) {
+            buf[n] = '\0';
+        }
+        return n;
+    }
+
+    uint64_t read_u64_file(const char *path) {
+        char buf[64];
+        uint64_t value = 0;
+        if (read_small_file(path, buf, sizeof(buf)) <= 0 ||
+            ::sscanf(buf, "%lu", &value) != 1) {
+            return 0;
+        }
+        return value;
+    }
+
+    /**
+     * @return controller-list中是否包含controller 例如"cpu,cpuacct"包含"cpu"
+     */
+    static bool has_controller(const char *list, size_t len, const char *controller) {
+        const auto controller_len = ::strlen(controller);
+        auto p = list;
+        const auto end = list + len;
+        while (p < end) {
+            auto comma = (const char *) ::memchr(p, ',', end - p);
+            if (comma == nullptr) {
+                comma = end;
+            }
+            if ((size_t) (comma - p) == controller_len && ::strncmp(p, controller, controller_len) == 0) {
+                return true;
+            }
+            p = comma + 1;
+        }
+        return false;
+    }
+
+    /**
+     * 从/proc/self/cgroup中读取自己在某个层级中的cgroup路径
+     * @param controller v1的控制器 nullptr表示v2的统一层级
+     */
+    static bool read_cgroup_path(const char *controller, char *path, size_t bytes) {
+        const auto file = ::fopen("/proc/self/cgroup", "r");
+        if (file == nullptr) {
+            return false;
+        }
+        char line[512];
+        bool found = false;
+        while (!found && ::fgets(line, sizeof(line), file) != nullptr) {
+            line[::strcspn(line, "\n")] = '\0';
+            //hierarchy-ID:controller-list:cgroup-path
+            const auto first = ::strchr(line, ':');
+            const auto second = first == nullptr ? nullptr : ::strchr(first + 1, ':');
+            if (second == nullptr) {
+                continue;
+            }
+            const auto is_v2 = ::strncmp(line, "0::", 3) == 0;
+            if (controller == nullptr ? is_v2 :
+                !is_v2 && has_controller(first + 1, (size_t) (second - first - 1), controller)) {
+                ::snprintf(path, bytes, "%s", second + 1);
+                found = true;
+            }
+        }
+        ::fclose(file);
+        return found;
+    }
+
+    /**
+     * 从/proc/self/mountinfo中查找层级的挂载
+     * @param root 挂载的根 即挂载点对应的cgroup路径 至少256字节
+     * @param mount 挂载点 至少256字节
+     */
+    static bool read_cgroup_mount(const char *controller, char *root, char *mount) {
+        const auto file = ::fopen("/proc/self/mountinfo", "r");
+        if (file == nullptr) {
+            return false;
+        }
+        char line[1024];
+        char fs_type[32];
+        char options[512];
+        //mount-ID parent-ID major:minor root mount-point options [optional...] - fs-type source super-options
+        bool found = false;
+        while (!found && ::fgets(line, sizeof(line), file) != nullptr) {
+            const auto separator = ::strstr(line, " - ");
+            if (separator == nullptr ||
+                ::sscanf(separator + 3, "%31s %*s %511s", fs_type, options) != 2) {
+                continue;
+            }
+            if (controller == nullptr ? ::strcmp(fs_type, "cgroup2") != 0 :
+                ::strcmp(fs_type, "cgroup") != 0 || !has_controller(options, ::strlen(options), controller)) {
+                continue;
+            }
+            found = ::sscanf(line, "%*d %*d %*s %255s %255s", root, mount) == 2;
+        }
+        ::fclose(file);
+        return found;
+    }
+
+    bool locate_cgroup(const char *controller, char *dir, size_t bytes, size_t *mount_len) {
+        char path[256];
+        char root[256];
+        char mount[256];
+        if (!read_cgroup_path(controller, path, sizeof(path)) ||
+            !read_cgroup_mount(controller, root, mount)) {
+            return false;
+        }
+        /**
+         * 容器中v1的挂载根通常是/docker/<id> 与cgroup路径相同 此时挂载点就是自己的cgroup
+         * 挂载根是cgroup路径的祖先时 只拼接相对于挂载根的部分
+         * 挂载根不是cgroup路径的祖先时 例如cgroup命名空间 只能使用挂载点
+         */
+        const char *relative = path;
+        const auto root_len = ::strlen(root);
+        if (::strcmp(root, "/") != 0) {
+            const auto under_root = ::strncmp(path, root, root_len) == 0 &&
+                                    (path[root_len] == '\0' || path[root_len] == '/');
+            relative = under_root ? path + root_len : "";
+        }
+        //cgroup路径为"/"时 去掉结尾的'/'
+        if (::strcmp(relative, "/") == 0) {
+            relative = "";
+        }
+        ::snprintf(dir, bytes, "%s%s", mount, relative);
+        if (mount_len != nullptr) {
+            *mount_len = ::strlen(mount);
+        }
+        return true;
+    }
+
+    /**
+     * 内存压力的采样状态 只由memory_pressure使用
+     */
+    static struct {
+        PressureSource _source;
+        bool _selected;
+        //cgroup的目录 由locate_cgroup按照挂载点定位
+        char _cgroup_dir[512];
+        bool _cgroup_v2;
+        uint64_t _cgroup_limit;
+        uint64_t _last_limit_events;
+    } _pressure_state;
+
+    /**
+     * @return 自己所在的cgroup是否有内存限制 有限制时记录目录和限制
+     */
+    static bool select_cgroup() {
+        auto &state = _pressure_state;
+        const auto physical = (uint64_t) total_pages() * (uint64_t) page_size();
+        char path[600];
+        if (locate_cgroup("memory", state._cgroup_dir, sizeof(state._cgroup_dir), nullptr)) {
+            ::snprintf(path, sizeof(path), "%s/memory.limit_in_bytes", state._cgroup_dir);
+            state._cgroup_limit = read_u64_file(path);
+            //没有限制时是一个接近2^63的值
+            if (state._cgroup_limit > 0 && state._cgroup_limit < physical) {
+                state._cgroup_v2 = false;
+                return true;
+            }
+        }
+        if (locate_cgroup(nullptr, state._cgroup_dir, sizeof(state._cgroup_dir), nullptr)) {
+            ::snprintf(path, sizeof(path), "%s/memory.max", state._cgroup_dir);
+            state._cgroup_limit = read_u64_file(path);
+            if (state._cgroup_limit > 0 && state._cgroup_limit < physical) {
+                state._cgroup_v2 = true;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @param path /proc/pressure/memory 或者cgroup v2的memory.pressure 二者格式相同
+     */
+    static bool sample_psi(const char *path, MemoryPressure *pressure) {
+        char buf[256];
+        double some = 0;
+        if (read_small_file(path, buf, sizeof(buf)) <= 0 ||
+            ::sscanf(buf, "some avg10=%lf", &some) != 1) {
+            return false;
+        }
+        pressure->_percent = some;
+        return true;
+    }
+
+    /**
+     * 触及cgroup v2的memory.max或者OOM的次数 只关心增量
+     */
+    static void sample_limit_events(MemoryPressure *pressure) {
+        auto &state = _pressure_state;
+        char path[600];
+        char buf[512];
+        ::snprintf(path, sizeof(path), "%s/memory.events", state._cgroup_dir);
+        if (read_small_file(path, buf, sizeof(buf)) > 0) {
+            static const char *const keys[] = {"\nmax ", "\noom "};
+            uint64_t events = 0;
+            for (const auto key: keys) {
+                const auto p = ::strstr(buf, key);
+                uint64_t count;
+                if (p != nullptr && ::sscanf(p + ::strlen(key), "%lu", &count) == 1) {
+                    events += count;
+                }
+            }
+            pressure->_limit_events = events - MIN2(events, state._last_limit_events);
+            state._last_limit_events = events;
+        }
+    }
+
+    static bool sample_cgroup_psi(MemoryPressure *pressure) {
+        char path[600];
+        ::snprintf(path, sizeof(path), "%s/memory.pressure", _pressure_state._cgroup_dir);
+        if (!sample_psi(path, pressure)) {
+            return false;
+        }
+        sample_limit_events(pressure);
+        return true;
+    }
+
+    static bool sample_cgroup(MemoryPressure *pressure) {
+        auto &state = _pressure_state;
+        char path[600];
+        ::snprintf(path, sizeof(path), state._cgroup_v2 ? "%s/memory.current" : "%s/memory.usage_in_bytes",
+                   state._cgroup_dir);
+        const auto usage = read_u64_file(path);
+        if (usage == 0) {
+            return false;
+        }
+        pressure->_percent = MIN2(100.0, (double) usage * 100.0 / (double) state._cgroup_limit);
+        if (state._cgroup_v2) {
+            sample_limit_events(pressure);
+        }
+        return true;
+    }
+
+    static bool sample_avail(MemoryPressure *pressure) {
+        const auto total = (double) total_pages() * page_size();
+        if (total <= 0) {
+            return false;
+        }
+        //MemFree不包括可以回收的页缓存 优先使用MemAvailable
+        double avail = (double) avail_pages() * page_size();
+        char buf[512];
+        if (read_small_file("/proc/meminfo", buf, sizeof(buf)) > 0) {
+            const auto p = ::strstr(buf, "MemAvailable:");
+            unsigned long kb;
+            if (p != nullptr && ::sscanf(p, "MemAvailable: %lu kB", &kb) == 1) {
+                avail = (double) kb * K;
+            }
+        }
+        pressure->_percent = clamp(100.0 - avail * 100.0 / total, 0.0, 100.0);
+        return true;
+    }
+
+    bool memory_pressure(MemoryPressure *pressure) {
+        auto &state = _pressure_state;
+        pressure->_percent = 0;
+        pressure->_limit_events = 0;
+        if (!state._selected) {
+            state._selected = true;
+            //有内存限制时 整个系统的PSI无法反映cgroup是否接近限制
+            if (select_cgroup()) {
+                //第一次采样只记录memory.events的基准
+                if (state._cgroup_v2 && sample_cgroup_psi(pressure)) {
+                    state._source = PressureSource::cgroup_psi;
+                } else {
+                    state._source = PressureSource::cgroup;
+                    sample_cgroup(pressure);
+                }
+                pressure->_limit_events = 0;
+            } else if (sample_psi("/proc/pressure/memory", pressure)) {
+                state._source = PressureSource::psi;
+            } else {
+                state._source = PressureSource::avail;
+            }
+        }
+        pressure->_source = state._source;
+        switch (state._source) {
+            case PressureSource::cgroup_psi:
+                return sample_cgroup_psi(pressure);
+            case PressureSource::cgroup:
+                return sample_cgroup(pressure);
+            case PressureSource::psi:
+                return sample_psi("/proc/pressure/memory", pressure);
+            case PressureSource::avail:
+                return sample_avail(pressure);
+            default:
+                return false;
+        }
+    }
+
+    bool map_memory(MEMFLAG F, void *addr, size_t bytes, int32_t fd, size_t offset, CommitType type) {
+        assert(addr != nullptr, "addr is not allow null");
+        assert_is_aligned(bytes, page_size());
+        assert_is_aligned((size_t) addr, page_size());
+        assert_is_aligned(offset, page_size());
+        //MAP_FIXED替换保留时的匿名映射 地址不会改变
+        const auto p = ::mmap(addr, bytes, prot_of(type), MAP_PRIVATE | MAP_FIXED, fd, (off_t) offset);
+        if (p == MAP_FAILED) {
+            return false;
+        }
+        assert(p == addr, "MAP_FIXED must map at addr");
+        MemoryTracer::record(F,
+                             MemoryTracer::OperationType::commit,
+                             addr,
+                             bytes,
+                             CALLER_STACK);
+        return true;
+    }
+
+    static UncommitType _default_uncommit_type = UncommitType::protect;
+
+    void memory_initialize() {
+        guarantee(parse_uncommit_type(global::UncommitStrategy, &_default_uncommit_type),
+                  "UncommitStrategy is error, must be selected from protect, dontneed and free.");
+    }
+
+    bool parse_uncommit_type(const char *name, UncommitType *type) {
+        if (::strcmp(name, "protect") == 0) {
+            *type = UncommitType::protect;
+        } else if (::strcmp(name, "dontneed") == 0) {
+            *type = UncommitType::dontneed;
+        } else if (::strcmp(name, "free") == 0) {
+            *type = UncommitType::free;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    const char *uncommit_type_name(UncommitType type) {
+        switch (type) {
+            case UncommitType::global:
+                return "global";
+            case UncommitType::protect:
+                return "protect";
+            case UncommitType::dontneed:
+                return "dontneed";
+            case UncommitType::free:
+                return "free";
+        }
+        return "unknown";
+    }
+
+    UncommitType default_uncommit_type() {
+        return _default_uncommit_type;
+    }
+
+    bool uncommit_memory(MEMFLAG F, void *addr, size_t bytes, UncommitType type) {
+        assert(addr != nullptr, "addr is not allow null");
+        assert_is_aligned(bytes, page_size());
+        assert_is_aligned((size_t) addr, page_size());
+        if (type == UncommitType::global) {
+            type = _default_uncommit_type;
+        }
+        bool success;
+        switch (type) {
+            case UncommitType::free:
+#ifdef MADV_FREE
+                success = ::madvise(addr, bytes, MADV_FREE) == 0;
+                //内核(4.5之前)不支持MADV_FREE 退回MADV_DONTNEED
+                if (success || errno != EINVAL) {
+                    break;
+                }
+#endif
+                success = ::madvise(addr, bytes, MADV_DONTNEED) == 0;
+                break;
+            case UncommitType::dontneed:
+                success = ::madvise(addr, bytes, MADV_DONTNEED) == 0;
+                break;
+            default:
+                success = ::mprotect(addr, bytes, PROT_NONE) == 0;
+                if (success) {
+                    success = ::madvise(addr, bytes, MADV_DONTNEED) == 0;
+                }
+                break;
         }
         if (success) {
             MemoryTracer::record(F,
@@ -239,6 +835,81 @@ namespace os {
         return success;
     }
 
+    UncommitBatch::UncommitBatch(MEMFLAG F, UncommitType type) :
+            _flag(F),
+            _type(type),
+            _num_ranges(0),
+            _num_added(0),
+            _num_calls(0) {
+    }
+
+    UncommitBatch::~UncommitBatch() {
+        assert(this->_num_ranges == 0, "UncommitBatch destroyed before flush");
+    }
+
+    bool UncommitBatch::add(void *addr, size_t bytes) {
+        assert(addr != nullptr, "addr is not allow null");
+        assert_is_aligned(bytes, page_size());
+        assert_is_aligned((size_t) addr, page_size());
+        const auto base = (uintptr_t) addr;
+        const auto end = base + bytes;
+        ++this->_num_added;
+        //第一个_end >= base的区间 之前的区间都不与新区间相接
+        int32_t i = 0;
+        while (i < this->_num_ranges && this->_ranges[i]._end < base) {
+            ++i;
+        }
+        const auto merge_left = i < this->_num_ranges && this->_ranges[i]._end == base;
+        const auto right = merge_left ? i + 1 : i;
+        const auto merge_right = right < this->_num_ranges && this->_ranges[right]._base == end;
+        assert(right == this->_num_ranges || this->_ranges[right]._base >= end, "撤销的区间不可以重叠");
+        if (merge_left && merge_right) {
+            //填补了两个区间之间的空隙 三者合并
+            this->_ranges[i]._end = this->_ranges[right]._end;
+            ::memmove(this->_ranges + right, this->_ranges + right + 1,
+                      (this->_num_ranges - right - 1) * sizeof(Range));
+            --this->_num_ranges;
+            return true;
+        }
+        if (merge_left) {
+            this->_ranges[i]._end = end;
+            return true;
+        }
+        if (merge_right) {
+            this->_ranges[right]._base = base;
+            return true;
+        }
+        if (this->_num_ranges == Capacity) {
+            //容量不足 先撤销已有的区间
+            if (!this->flush()) {
+                return false;
+            }
+            i = 0;
+        }
+        ::memmove(this->_ranges + i + 1, this->_ranges + i,
+                  (this->_num_ranges - i) * sizeof(Range));
+        this->_ranges[i]._base = base;
+        this->_ranges[i]._end = end;
+        ++this->_num_ranges;
+        return true;
+    }
+
+    bool UncommitBatch::flush() {
+        const auto num = this->_num_ranges;
+        this->_num_ranges = 0;
+        for (int32_t i = 0; i < num; ++i) {
+            const auto &range = this->_ranges[i];
+            ++this->_num_calls;
+            if (!uncommit_memory(this->_flag,
+                                 (void *) range._base,
+                                 range._end - range._base,
+                                 this->_type)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
 
     void pretouch_memory(void *start, size_t bytes) {
         auto end = (char *) start + bytes;
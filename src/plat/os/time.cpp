@@ -5,9 +5,18 @@
 #include <unistd.h>
 #include <sys/times.h>
 #include <cstdio>
+#include <cstring>
 #include <ctime>
 #include "plat/constants.hpp"
 #include "plat/utils/robust.hpp"
+#include "plat/utils/OrderAccess.hpp"
+#include "global/flag.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#include <cpuid.h>
+#define SUPPORT_TSC_CLOCK
+#endif
 namespace os {
     /**
      * 用于表示时区的
@@ -19,6 +28,197 @@ namespace os {
      */
     ticks_t VMStartStamp = 0;
 
+    ticks_t VMStartMonotonicStamp = 0;
+
+    static ClockSource _clock_source = ClockSource::monotonic;
+
+    constexpr auto NsPerSec = TicksPerS / TicksPerNS;
+    constexpr auto NsPerMs = NsPerSec / 1000;
+
+    static inline ticks_t read_monotonic() {
+        struct ::timespec spec{};
+        ::clock_gettime(CLOCK_MONOTONIC, &spec);
+        return (ticks_t) spec.tv_sec * NsPerSec + spec.tv_nsec;
+    }
+
+#ifdef SUPPORT_TSC_CLOCK
+    /**
+     * TSC时钟的换算参数 ns = base_ns + (tsc - base_tsc) * mult >> MultShift
+     * 使用顺序锁(seqlock)发布 读者不需要加锁 版本号为奇数时表示正在修改
+     */
+    struct TSCClock {
+        volatile uint64_t _seq;
+        volatile uint64_t _base_tsc;
+        volatile uint64_t _base_ns;
+        volatile uint64_t _mult;
+        /**
+         * 校准开始时的锚点 频率根据锚点到现在的基线计算 基线越长越精确
+         */
+        uint64_t _anchor_tsc;
+        uint64_t _anchor_ns;
+    };
+
+    __extension__ typedef unsigned __int128 uint128_t;
+    __extension__ typedef __int128 int128_t;
+
+    static TSCClock _tsc_clock{};
+    static volatile int _resync_lock = 0;
+    constexpr int32_t MultShift = 32;
+    /**
+     * 启动时估计频率的时长 之后由clock_resync修正
+     */
+    constexpr ticks_t CalibrateNs = 2 * NsPerMs;
+    /**
+     * TSC时钟落后CLOCK_MONOTONIC超过该值时直接向前跳跃 例如虚拟机被暂停之后
+     */
+    constexpr ticks_t MaxSlewNs = NsPerMs;
+
+    static inline uint64_t read_tsc() {
+        return __rdtsc();
+    }
+
+    /**
+     * 恒定速率(invariant)的TSC不受频率调整和节能状态的影响
+     * 内核认为TSC不可靠(例如各个CPU之间不同步)时会切换到其他的时钟源
+     */
+    static bool tsc_is_invariant() {
+        uint32_t eax, ebx, ecx, edx;
+        if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007) {
+            return false;
+        }
+        __cpuid(0x80000007, eax, ebx, ecx, edx);
+        if ((edx & (1u << 8)) == 0) {
+            return false;
+        }
+        const auto file = ::fopen("/sys/devices/system/clocksource/clocksource0/current_clocksource", "r");
+        if (file == nullptr) {
+            return true;
+        }
+        char buf[32] = {0};
+        const auto read = ::fgets(buf, sizeof(buf), file) != nullptr;
+        ::fclose(file);
+        return !read || ::strncmp(buf, "tsc", 3) == 0;
+    }
+
+    /**
+     * 同时读取TSC和CLOCK_MONOTONIC 取前后两次TSC间隔最短的一次 TSC取中点
+     */
+    static void sample_tsc(uint64_t *tsc, ticks_t *ns) {
+        auto best = (uint64_t) -1;
+        for (int32_t i = 0; i < 8; ++i) {
+            const auto before = read_tsc();
+            const auto now = read_monotonic();
+            const auto after = read_tsc();
+            if (after - before < best) {
+                best = after - before;
+                *tsc = before + best / 2;
+                *ns = now;
+            }
+        }
+    }
+
+    static inline uint64_t mult_of(ticks_t ns, uint64_t ticks) {
+        return (uint64_t) (((uint128_t) ns << MultShift) / ticks);
+    }
+
+    static inline ticks_t tsc_to_ns(uint64_t tsc, uint64_t base_tsc, ticks_t base_ns, uint64_t mult) {
+        //其他CPU上读取的TSC可能略早于base_tsc
+        const auto delta = (int64_t) (tsc - base_tsc);
+        return base_ns + (ticks_t) (((int128_t) delta * (int128_t) mult) >> MultShift);
+    }
+
+    static void publish_tsc_clock(uint64_t base_tsc, ticks_t base_ns, uint64_t mult) {
+        auto &clock = _tsc_clock;
+        OrderAccess::store(&clock._seq, clock._seq + 1);
+        OrderAccess::fence();
+        clock._base_tsc = base_tsc;
+        clock._base_ns = base_ns;
+        clock._mult = mult;
+        OrderAccess::fence();
+        OrderAccess::store(&clock._seq, clock._seq + 1);
+    }
+
+    /**
+     * 自旋一小段时间估计初始的频率
+     */
+    static bool tsc_clock_initialize() {
+        uint64_t tsc0, tsc1;
+        ticks_t ns0, ns1;
+        sample_tsc(&tsc0, &ns0);
+        do {
+            sample_tsc(&tsc1, &ns1);
+        } while (ns1 - ns0 < CalibrateNs);
+        if (tsc1 <= tsc0) {
+            return false;
+        }
+        _tsc_clock._anchor_tsc = tsc0;
+        _tsc_clock._anchor_ns = ns0;
+        publish_tsc_clock(tsc1, ns1, mult_of(ns1 - ns0, tsc1 - tsc0));
+        return true;
+    }
+#endif
+
+    const char *clock_source_name(ClockSource source) {
+        switch (source) {
+            case ClockSource::monotonic:
+                return "monotonic";
+            case ClockSource::tsc:
+                return "tsc";
+        }
+        return "unknown";
+    }
+
+    ClockSource clock_source() {
+        return _clock_source;
+    }
+
+    ticks_t monotonic_stamp() {
+#ifdef SUPPORT_TSC_CLOCK
+        if (_clock_source == ClockSource::tsc) {
+            const auto &clock = _tsc_clock;
+            uint64_t seq, base_tsc, mult, tsc;
+            ticks_t base_ns;
+            do {
+                seq = OrderAccess::load(&clock._seq);
+                OrderAccess::compile_barrier();
+                base_tsc = clock._base_tsc;
+                base_ns = clock._base_ns;
+                mult = clock._mult;
+                tsc = read_tsc();
+                OrderAccess::compile_barrier();
+            } while ((seq & 1) != 0 || seq != OrderAccess::load(&clock._seq));
+            return tsc_to_ns(tsc, base_tsc, base_ns, mult);
+        }
+#endif
+        return read_monotonic();
+    }
+
+    void clock_resync() {
+#ifdef SUPPORT_TSC_CLOCK
+        if (_clock_source != ClockSource::tsc || OrderAccess::xchg(&_resync_lock, 1) != 0) {
+            return;
+        }
+        auto &clock = _tsc_clock;
+        uint64_t tsc;
+        ticks_t ns;
+        sample_tsc(&tsc, &ns);
+        const auto derived = tsc_to_ns(tsc, clock._base_tsc, clock._base_ns, clock._mult);
+        const auto mult = mult_of(ns - clock._anchor_ns, tsc - clock._anchor_tsc);
+        const auto error = (int64_t) (ns - derived);
+        if (error > (int64_t) MaxSlewNs) {
+            //向前跳跃不会破坏单调性
+            publish_tsc_clock(tsc, ns, mult);
+        } else {
+            //从当前的读数继续 调整速率使误差在下一个间隔内消除 最多调整一半
+            const auto period = (int64_t) MAX2<uint32_t>(global::ClockSyncInterval, 1) * (int64_t) NsPerMs;
+            const auto correction = clamp<int64_t>(error, -period / 2, period / 2);
+            publish_tsc_clock(tsc, derived,
+                              (uint64_t) ((int128_t) mult * (period + correction) / period));
+        }
+        OrderAccess::xchg(&_resync_lock, 0);
+#endif
+    }
+
     /**
      * 用于格式化时区信息
      *
@@ -43,6 +243,12 @@ namespace os {
                    (int) zone_mins);
         //记录虚拟机启动时间
         VMStartStamp = vm_start_stamp;
+#ifdef SUPPORT_TSC_CLOCK
+        if (global::UseTSCClock && tsc_is_invariant() && tsc_clock_initialize()) {
+            _clock_source = ClockSource::tsc;
+        }
+#endif
+        VMStartMonotonicStamp = monotonic_stamp();
     }
 
     bool proc_cpu_time(double &process_real_time,
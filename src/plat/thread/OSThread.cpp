@@ -11,16 +11,22 @@
 thread_local OSThread *OSThread::_current = nullptr;
 OSThread* OSThread::_main_thread = nullptr;
 OSThread::OSThread() :
-        _plib_id(0),
-        _kernel_id(0),
-        _priority(0),
         _os_state(STATE_NEW),
-        _resource_arena(nullptr) {
+        _priority(0),
+        _sched_policy(os::SchedPolicy::other),
+        _kernel_id(0),
+        _plib_id(0),
+        _resource_arena(nullptr),
+        _chunk_cache(),
+        _slab_cache() {
 }
 
 
 OSThread::~OSThread() {
+    //资源区域的内存块会进入执行析构的线程的缓存
     delete this->_resource_arena;
+    this->_chunk_cache.drain_all();
+    this->_slab_cache.drain_all();
 }
 
 
@@ -78,7 +84,27 @@ void OSThread::print_on(CharOStream *out) const {
                    this->get_priority(),
                    os_prio);
     }
+    out->print(" policy=%s", os::sched_policy_name(this->_sched_policy));
+    os::CpuSet cpus;
+    if (os::get_thread_affinity(this->_kernel_id, &cpus) == OSReturn::OK &&
+        cpus.count() != os::allowed_cpus().count()) {
+        out->print(" cpus=");
+        cpus.print_on(out);
+    }
+}
 
+OSReturn OSThread::set_affinity(const os::CpuSet &cpus) {
+    assert(this->_kernel_id != 0, "thread is not started");
+    return os::set_thread_affinity(this->_kernel_id, cpus);
+}
+
+OSReturn OSThread::set_sched_policy(os::SchedPolicy policy, int32_t rt_priority) {
+    assert(this->_kernel_id != 0, "thread is not started");
+    const auto status = os::set_sched_policy(this->_kernel_id, policy, rt_priority);
+    if (status == OSReturn::OK) {
+        this->_sched_policy = policy;
+    }
+    return status;
 }
 
 void *OSThread::native_call(void *params) {
@@ -101,6 +127,11 @@ void *OSThread::native_call(void *params) {
     OrderAccess::compile_barrier();
     osThread->post_run();
     OrderAccess::compile_barrier();
+    //线程即将退出 缓存的内存块交还给全局内存池 小对象交还给中央仓库
+    osThread->_chunk_cache.drain_all();
+    osThread->_slab_cache.drain_all();
+    //线程即将退出 先进入阻塞态 ZOMBIE的前置状态必须是BLOCKED
+    osThread->tans_state(OSThread::STATE_BLOCKED);
     osThread->tans_state(OSThread::STATE_ZOMBIE);
     return nullptr;
 }
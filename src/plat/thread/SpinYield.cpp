@@ -62,11 +62,11 @@ void SpinYield::report(CharOStream *out) const {
 
 ticks_t SpinYield::sleep(uint32_t ns) {
     assert(ns < TicksPerS, "The spin sleep time is too long, up to 1s");
-    const auto start_ticks = os::current_stamp();
+    const auto start_ticks = os::monotonic_stamp();
     struct timespec spec{
             0,
             ns
     };
     ::nanosleep(&spec, nullptr);
-    return (os::current_stamp() - start_ticks);
+    return (os::monotonic_stamp() - start_ticks);
 }
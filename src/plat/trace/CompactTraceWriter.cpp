@@ -0,0 +1,135 @@
+//
+// Created by aurora on 2026/10/19.
+//
+
+#include <cstdlib>
+#include <cstring>
+#include "CompactTraceWriter.hpp"
+#include "plat/stream/OStream.hpp"
+#include "plat/utils/robust.hpp"
+
+CompactTraceWriter::StackEntry *CompactTraceWriter::_stacks = nullptr;
+uint32_t CompactTraceWriter::_num_slots = 0;
+uint32_t CompactTraceWriter::_num_stacks = 0;
+uint8_t CompactTraceWriter::_buffer[BufferBytes] = {};
+size_t CompactTraceWriter::_pos = 0;
+
+static uint64_t hash_of(const uintptr_t *stack) {
+    uint64_t hash = 0;
+    for (int32_t i = 0; i < NativeCallStack::MAX_DEPTH; ++i) {
+        //splitmix64 的混合函数
+        auto x = hash ^ ((uint64_t) stack[i] + 0x9E3779B97F4A7C15ULL);
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        hash = x ^ (x >> 31);
+    }
+    return hash;
+}
+
+void CompactTraceWriter::rehash(uint32_t num_slots) {
+    //直接使用malloc 不可以被追踪
+    const auto stacks = (StackEntry *) ::calloc(num_slots, sizeof(StackEntry));
+    guarantee(stacks != nullptr, "native memory tracer stack dictionary allocate failed");
+    for (uint32_t i = 0; i < _num_slots; ++i) {
+        const auto &entry = _stacks[i];
+        if (entry._id == 0) {
+            continue;
+        }
+        auto slot = (uint32_t) hash_of(entry._stack) & (num_slots - 1);
+        while (stacks[slot]._id != 0) {
+            slot = (slot + 1) & (num_slots - 1);
+        }
+        stacks[slot] = entry;
+    }
+    ::free(_stacks);
+    _stacks = stacks;
+    _num_slots = num_slots;
+}
+
+uint32_t CompactTraceWriter::intern(OStream *stream, const uintptr_t *stack) {
+    if (stack[0] == 0) {
+        return 0;
+    }
+    //负载因子不超过1/2
+    if ((_num_stacks + 1) * 2 > _num_slots) {
+        rehash(MAX2<uint32_t>(_num_slots * 2, 1024));
+    }
+    auto slot = (uint32_t) hash_of(stack) & (_num_slots - 1);
+    for (; _stacks[slot]._id != 0; slot = (slot + 1) & (_num_slots - 1)) {
+        if (::memcmp(_stacks[slot]._stack, stack, sizeof(_stacks[slot]._stack)) == 0) {
+            return _stacks[slot]._id;
+        }
+    }
+    auto &entry = _stacks[slot];
+    entry._id = ++_num_stacks;
+    ::memcpy(entry._stack, stack, sizeof(entry._stack));
+    //新的堆栈 在引用之前写出
+    int32_t depth = 0;
+    while (depth < NativeCallStack::MAX_DEPTH && stack[depth] != 0) {
+        ++depth;
+    }
+    reserve(stream, MaxEntryBytes);
+    auto p = _buffer + _pos;
+    *p++ = TraceFormat::StackTag;
+    p = TraceFormat::put_varint(p, depth);
+    uintptr_t prev = 0;
+    for (int32_t i = 0; i < depth; ++i) {
+        p = TraceFormat::put_varint(p, TraceFormat::zigzag((int64_t) (stack[i] - prev)));
+        prev = stack[i];
+    }
+    _pos = p - _buffer;
+    return entry._id;
+}
+
+void CompactTraceWriter::write_header(OStream *stream) {
+    reserve(stream, TraceFormat::HeaderBytes);
+    TraceFormat::fill_header(_buffer + _pos, TraceFormat::CompactVersion, NativeCallStack::MAX_DEPTH);
+    _pos += TraceFormat::HeaderBytes;
+}
+
+void CompactTraceWriter::write(OStream *stream, const Unit *units, size_t num) {
+    size_t begin = 0;
+    while (begin < num) {
+        const auto thread_id = units[begin]._thread_id;
+        auto end = begin + 1;
+        while (end < num && units[end]._thread_id == thread_id) {
+            ++end;
+        }
+        //Block中只有堆栈编号 堆栈本身必须先写出
+        for (auto i = begin; i < end; ++i) {
+            intern(stream, units[i]._caller);
+        }
+        reserve(stream, 1 + 2 * TraceFormat::MaxVarintBytes);
+        auto p = _buffer + _pos;
+        *p++ = TraceFormat::BlockTag;
+        p = TraceFormat::put_varint(p, thread_id);
+        p = TraceFormat::put_varint(p, end - begin);
+        _pos = p - _buffer;
+        uintptr_t prev_addr = 0;
+        uint64_t prev_order = 0;
+        for (auto i = begin; i < end; ++i) {
+            const auto &unit = units[i];
+            //已经在字典中 只是查找
+            const auto id = intern(stream, unit._caller);
+            reserve(stream, 2 + 4 * TraceFormat::MaxVarintBytes);
+            p = _buffer + _pos;
+            *p++ = unit._memory_tag;
+            *p++ = unit._operation_type;
+            p = TraceFormat::put_varint(p, id);
+            p = TraceFormat::put_varint(p, TraceFormat::zigzag((int64_t) (unit._addr - prev_addr)));
+            p = TraceFormat::put_varint(p, TraceFormat::zigzag((int64_t) (unit._order_id - prev_order)));
+            p = TraceFormat::put_varint(p, unit._bytes);
+            _pos = p - _buffer;
+            prev_addr = unit._addr;
+            prev_order = unit._order_id;
+        }
+        begin = end;
+    }
+}
+
+void CompactTraceWriter::flush(OStream *stream) {
+    if (_pos > 0) {
+        stream->write_bytes(_buffer, _pos);
+        _pos = 0;
+    }
+}
@@ -0,0 +1,77 @@
+//
+// Created by aurora on 2026/10/19.
+//
+
+#ifndef PLAT_TRACE_COMPACT_TRACE_WRITER_HPP
+#define PLAT_TRACE_COMPACT_TRACE_WRITER_HPP
+
+#include "stdtype.hpp"
+#include "DetailLogMemory.hpp"
+#include "TraceFormat.hpp"
+
+class OStream;
+
+/**
+ * 以compact格式(见TraceFormat)写出详细的内存记录
+ *
+ * 调用堆栈的字典是开放寻址的哈希表 只增不减 直接使用realloc扩容 避免追踪自身
+ * 编码的结果先写入固定大小的缓冲区 满了之后再写入文件
+ *
+ * 只由持有DetailLogMemory::_drain_lock的线程调用 不需要额外的同步
+ */
+class CompactTraceWriter : public AllStatic {
+private:
+    using Unit = DetailLogMemory::Unit;
+
+    struct StackEntry {
+        /**
+         * 堆栈的编号 0表示空闲槽位
+         */
+        uint32_t _id;
+        uintptr_t _stack[NativeCallStack::MAX_DEPTH];
+    };
+
+    constexpr inline static size_t BufferBytes = 64 * 1024;
+    /**
+     * 一个条目最多占用的字节数 写入之前保证缓冲区剩余的空间足够
+     */
+    constexpr inline static size_t MaxEntryBytes = 1 + TraceFormat::MaxVarintBytes * (NativeCallStack::MAX_DEPTH + 1);
+
+    static StackEntry *_stacks;
+    static uint32_t _num_slots;
+    static uint32_t _num_stacks;
+    static uint8_t _buffer[BufferBytes];
+    static size_t _pos;
+
+    /**
+     * 缓冲区剩余的空间不足bytes时 写出缓冲区
+     */
+    static inline void reserve(OStream *stream, size_t bytes) {
+        if (_pos + bytes > BufferBytes) {
+            flush(stream);
+        }
+    };
+
+    static void rehash(uint32_t num_slots);
+
+    /**
+     * 查找堆栈的编号 第一次出现时分配编号并写出Stack条目
+     * @return 空的堆栈返回0
+     */
+    static uint32_t intern(OStream *stream, const uintptr_t *stack);
+
+public:
+    static void write_header(OStream *stream);
+
+    /**
+     * 编码一段连续的记录 同一个线程连续的记录组成一个Block
+     */
+    static void write(OStream *stream, const Unit *units, size_t num);
+
+    /**
+     * 将缓冲区中已经编码的数据写入文件
+     */
+    static void flush(OStream *stream);
+};
+
+#endif //PLAT_TRACE_COMPACT_TRACE_WRITER_HPP
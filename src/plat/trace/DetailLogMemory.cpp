@@ -2,22 +2,164 @@
 // Created by aurora on 2024/6/24.
 //
 
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
 #include "DetailLogMemory.hpp"
+#include "CompactTraceWriter.hpp"
+#include "TraceFormat.hpp"
 #include "plat/os/cpu.hpp"
 #include "plat/stream/FileCharOStream.hpp"
 #include "plat/utils/ByteOrder.hpp"
 #include "plat/utils/robust.hpp"
+#include "plat/utils/OrderAccess.hpp"
+#include "plat/thread/SpinYield.hpp"
 #include "global/flag.hpp"
 
-std::atomic<uint16_t> DetailLogMemory::_next_order_id = 0;
-OStream* DetailLogMemory::_stream = nullptr;
+std::atomic<uint64_t> DetailLogMemory::_next_order_id = 0;
+OStream *volatile DetailLogMemory::_stream = nullptr;
+bool DetailLogMemory::_compact = true;
+DetailLogMemory::Buffer *volatile DetailLogMemory::_buffers = nullptr;
+volatile int DetailLogMemory::_drain_lock = 0;
+volatile bool DetailLogMemory::_closed = false;
+size_t DetailLogMemory::_reported_dropped = 0;
+thread_local DetailLogMemory::BufferHolder DetailLogMemory::_holder = {nullptr};
+thread_local bool DetailLogMemory::_in_drain = false;
+
 void DetailLogMemory::global_initialize() {
+    if (::strcmp(global::NMTTraceFormat, "raw") == 0) {
+        DetailLogMemory::_compact = false;
+    } else {
+        guarantee(::strcmp(global::NMTTraceFormat, "compact") == 0,
+                  "NMTTraceFormat is error, must be selected from raw and compact.");
+    }
     static FileCharOStream stream(global::NMTFilePath);
     if (stream.is_open()) {
         DetailLogMemory::_stream = &stream;
     }
     guarantee(stream.is_open(), "native memory tracer file initialize failed");
+    if (DetailLogMemory::_compact) {
+        CompactTraceWriter::write_header(&stream);
+    } else {
+        uint8_t header[TraceFormat::HeaderBytes];
+        TraceFormat::fill_header(header, TraceFormat::RawVersion, NativeCallStack::MAX_DEPTH);
+        stream.write_bytes(header, sizeof(header));
+    }
+    DetailLogMemory::save_maps();
+    //在追踪文件的析构之前执行(atexit按照注册的逆序执行)
+    ::atexit(DetailLogMemory::close);
+}
+
+void DetailLogMemory::save_maps() {
+    char path[PATH_MAX];
+    ::snprintf(path, sizeof(path), "%s%s", global::NMTFilePath, DetailLogMemory::MapsSuffix);
+    const auto fd = ::open("/proc/self/maps", O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    FileCharOStream maps(path);
+    if (maps.is_open()) {
+        char buf[4096];
+        ssize_t len;
+        while ((len = ::read(fd, buf, sizeof(buf))) > 0) {
+            maps.write_bytes(buf, len);
+        }
+        maps.flush();
+    } else {
+        FileCharOStream::error_stream()->print_cr(
+                "warning: native memory tracer can not write module maps to %s.", path);
+    }
+    ::close(fd);
+}
 
+bool DetailLogMemory::Buffer::offer(const Unit &unit) {
+    const auto tail = this->_tail;
+    if (tail - OrderAccess::load(&this->_head) >= Capacity) {
+        return false;
+    }
+    this->_units[tail & (Capacity - 1)] = unit;
+    //记录写完之后 才可以被消费者看到
+    OrderAccess::fence();
+    OrderAccess::store(&this->_tail, tail + 1);
+    return true;
+}
+
+size_t DetailLogMemory::Buffer::drain_to(OStream *stream) {
+    const auto head = this->_head;
+    const auto tail = OrderAccess::load(&this->_tail);
+    OrderAccess::fence();
+    //环形缓冲区 最多分为两段连续的记录
+    const auto first = head & (Capacity - 1);
+    const auto first_num = MIN2(tail - head, Capacity - first);
+    DetailLogMemory::write_units(stream, this->_units + first, first_num);
+    DetailLogMemory::write_units(stream, this->_units, tail - head - first_num);
+    //写出之后 生产者才可以覆盖
+    OrderAccess::fence();
+    OrderAccess::store(&this->_head, tail);
+    return tail - head;
+}
+
+DetailLogMemory::BufferHolder::~BufferHolder() {
+    if (this->_buffer != nullptr) {
+        //剩余的记录由下一次写出处理
+        OrderAccess::xchg(&this->_buffer->_owned, 0);
+        this->_buffer = nullptr;
+    }
+}
+
+DetailLogMemory::Buffer *DetailLogMemory::current_buffer() {
+    auto buffer = DetailLogMemory::_holder._buffer;
+    if (buffer != nullptr) {
+        return buffer;
+    }
+    //复用已经归还的缓冲区
+    for (buffer = OrderAccess::load(&DetailLogMemory::_buffers);
+         buffer != nullptr;
+         buffer = buffer->_next) {
+        if (OrderAccess::load(&buffer->_owned) == 0 &&
+            OrderAccess::cas(&buffer->_owned, 0, 1) == 0) {
+            DetailLogMemory::_holder._buffer = buffer;
+            return buffer;
+        }
+    }
+    //直接使用malloc 不可以被追踪
+    buffer = (Buffer *) ::malloc(sizeof(Buffer));
+    guarantee(buffer != nullptr, "native memory tracer buffer allocate failed");
+    buffer->_owned = 1;
+    buffer->_head = 0;
+    buffer->_tail = 0;
+    buffer->_dropped = 0;
+    Buffer *head;
+    do {
+        head = OrderAccess::load(&DetailLogMemory::_buffers);
+        buffer->_next = head;
+    } while (OrderAccess::cas(&DetailLogMemory::_buffers, head, buffer) != head);
+    DetailLogMemory::_holder._buffer = buffer;
+    return buffer;
+}
+
+void DetailLogMemory::write_units(OStream *stream, const Unit *units, size_t num) {
+    if (DetailLogMemory::_compact) {
+        CompactTraceWriter::write(stream, units, num);
+        return;
+    }
+    for (size_t i = 0; i < num; ++i) {
+        const auto &unit = units[i];
+        //填充字节也会写出 需要清零
+        Unit raw{};
+        raw._memory_tag = unit._memory_tag;
+        raw._operation_type = unit._operation_type;
+        raw._order_id = ByteOrder::network(unit._order_id);
+        raw._thread_id = ByteOrder::network(unit._thread_id);
+        raw._addr = ByteOrder::network(unit._addr);
+        raw._bytes = ByteOrder::network(unit._bytes);
+        for (int32_t k = 0; k < NativeCallStack::MAX_DEPTH; ++k) {
+            raw._caller[k] = ByteOrder::network(unit._caller[k]);
+        }
+        stream->write_bytes(&raw, sizeof(Unit));
+    }
 }
 
 void DetailLogMemory::detail_log(MEMFLAG F,
@@ -29,23 +171,128 @@ void DetailLogMemory::detail_log(MEMFLAG F,
     detail._memory_tag = (int32_t)F;
     detail._operation_type = (uint8_t) type;
     const auto order_id = DetailLogMemory::_next_order_id.fetch_add(1);
-    detail._order_id = ByteOrder::network(order_id);
-    detail._thread_id = ByteOrder::network(os::current_thread_id());
-    detail._addr = ByteOrder::network((uintptr_t)addr);
-    detail._bytes = ByteOrder::network(bytes);
+    //缓冲区中为主机序 写出时按照格式转换
+    detail._order_id = order_id;
+    detail._thread_id = os::current_thread_id();
+    detail._addr = (uintptr_t)addr;
+    detail._bytes = bytes;
     if(!call_stack.is_empty()){
         void** bottom =  (void **)call_stack.stack();
         for (int32_t i = 0; i < NativeCallStack::MAX_DEPTH; ++i) {
-           detail._caller[i] = ByteOrder::network((uintptr_t)bottom[i]);
+           detail._caller[i] = (uintptr_t)bottom[i];
+        }
+    } else {
+        ::memset(detail._caller, 0, sizeof(detail._caller));
+    }
+    const auto buffer = DetailLogMemory::current_buffer();
+    //追踪文件已经关闭 没有机会再写出
+    //打开之前的记录保留在缓冲区中 打开之后写出
+    if (OrderAccess::load(&DetailLogMemory::_closed)) {
+        OrderAccess::fetch_and_add<size_t>(&buffer->_dropped, 1);
+        return;
+    }
+    if (buffer->offer(detail)) {
+        return;
+    }
+    //缓冲区已满 由当前线程写出 正在写出的线程再次记录时只能丢弃
+    if (!DetailLogMemory::_in_drain) {
+        DetailLogMemory::lock_and_drain();
+        if (buffer->offer(detail)) {
+            return;
         }
     }
+    OrderAccess::fetch_and_add<size_t>(&buffer->_dropped, 1);
+}
+
+void DetailLogMemory::lock_and_drain() {
+    SpinYield spin;
+    while (OrderAccess::xchg(&DetailLogMemory::_drain_lock, 1) != 0) {
+        spin.wait();
+    }
+    DetailLogMemory::drain_locked();
+    OrderAccess::xchg(&DetailLogMemory::_drain_lock, 0);
+}
+
+void DetailLogMemory::drain_locked() {
     const auto stream = DetailLogMemory::_stream;
+    if (stream == nullptr) {
+        return;
+    }
+    DetailLogMemory::_in_drain = true;
     stream->lock();
-    stream->write_bytes(&detail, sizeof(Unit));
+    for (auto buffer = OrderAccess::load(&DetailLogMemory::_buffers);
+         buffer != nullptr;
+         buffer = buffer->_next) {
+        buffer->drain_to(stream);
+    }
+    if (DetailLogMemory::_compact) {
+        CompactTraceWriter::flush(stream);
+    }
     stream->unlock();
+    DetailLogMemory::report_dropped();
+    DetailLogMemory::_in_drain = false;
+}
+
+void DetailLogMemory::report_dropped() {
+    const auto dropped = DetailLogMemory::dropped();
+    if (dropped != DetailLogMemory::_reported_dropped) {
+        FileCharOStream::error_stream()->print_cr(
+                "warning: native memory tracer dropped " SIZE_FORMAT " records in total.",
+                dropped);
+        DetailLogMemory::_reported_dropped = dropped;
+    }
+}
+
+void DetailLogMemory::drain() {
+    if (OrderAccess::xchg(&DetailLogMemory::_drain_lock, 1) != 0) {
+        return;
+    }
+    DetailLogMemory::drain_locked();
+    OrderAccess::xchg(&DetailLogMemory::_drain_lock, 0);
+}
+
+size_t DetailLogMemory::dropped() {
+    size_t total = 0;
+    for (auto buffer = OrderAccess::load(&DetailLogMemory::_buffers);
+         buffer != nullptr;
+         buffer = buffer->_next) {
+        total += OrderAccess::load(&buffer->_dropped);
+    }
+    return total;
+}
+
+void DetailLogMemory::close() {
+    SpinYield spin;
+    while (OrderAccess::xchg(&DetailLogMemory::_drain_lock, 1) != 0) {
+        spin.wait();
+    }
+    DetailLogMemory::drain_locked();
+    const auto stream = DetailLogMemory::_stream;
+    //之后的记录直接丢弃
+    OrderAccess::store(&DetailLogMemory::_closed, true);
+    OrderAccess::store(&DetailLogMemory::_stream, (OStream *) nullptr);
+    OrderAccess::fence();
+    //最后一次写出之后 其他线程仍然可能放入记录 无法再写出 计入丢弃
+    for (auto buffer = OrderAccess::load(&DetailLogMemory::_buffers);
+         buffer != nullptr;
+         buffer = buffer->_next) {
+        const auto tail = OrderAccess::load(&buffer->_tail);
+        const auto undrained = tail - buffer->_head;
+        if (undrained != 0) {
+            OrderAccess::store(&buffer->_head, tail);
+            OrderAccess::fetch_and_add<size_t>(&buffer->_dropped, undrained);
+        }
+    }
+    if (stream != nullptr) {
+        stream->flush();
+    }
+    DetailLogMemory::report_dropped();
+    OrderAccess::xchg(&DetailLogMemory::_drain_lock, 0);
 }
 
 void DetailLogMemory::flush() {
+    //结束时必须写出全部的记录 等待正在进行的写出
+    DetailLogMemory::lock_and_drain();
     auto stream = DetailLogMemory::_stream;
     if(stream != nullptr){
         stream->flush();
@@ -12,19 +12,160 @@
 #include "plat/mem/allocation.hpp"
 class OStream;
 
+/**
+ * 详细的内存追踪
+ *
+ * 每个线程拥有自己的环形缓冲区 记录时不加锁 也不进行IO
+ * 缓冲区由周期性任务(或者缓冲区已满的线程)统一写入到追踪文件中
+ * 不同线程的记录按照缓冲区写出 文件中的先后顺序并不严格 通过_order_id恢复
+ * _order_id是64位的全局序号 不会回绕
+ *
+ * 缓冲区已满时 当前线程等待并写出全部缓冲区
+ * 写出过程中再次产生的记录(例如写出本身申请内存)无法等待 被丢弃并计数
+ * 进程退出时(atexit)最后写出一次并关闭 之后的记录同样被丢弃并计数
+ */
 class DetailLogMemory {
-private:
+public:
+    /**
+     * 一条记录 线程缓冲区中为主机序
+     * raw格式的追踪文件中直接写出该结构 多字节字段转换为网络字节序
+     * 离线解析工具(tools/nmt_decode)同样使用该结构
+     */
     struct Unit {
         uint8_t _memory_tag;
         uint8_t _operation_type;
-        uint16_t _order_id;
         uint32_t _thread_id;
+        uint64_t _order_id;
         uintptr_t _addr;
         size_t _bytes;
         uintptr_t _caller[NativeCallStack::MAX_DEPTH];
     };
-    static OStream *_stream;
-    static std::atomic<uint16_t> _next_order_id;
+
+    /**
+     * 模块映射文件的后缀 保存在追踪文件旁边
+     * 内容是初始化时的/proc/self/maps 离线解析时用于将地址还原为模块和符号
+     */
+    constexpr inline static const char *MapsSuffix = ".maps";
+private:
+
+    /**
+     * 单生产者 单消费者的环形缓冲区
+     * 生产者是持有它的线程 消费者是持有_drain_lock的线程
+     * 缓冲区直接使用malloc申请 避免追踪自身
+     * 线程退出后归还 可以被新的线程复用 但是永远不会释放
+     */
+    class Buffer {
+    public:
+        constexpr inline static size_t Capacity = 1024;
+        /**
+         * 全局链表中的下一个 只增不减
+         */
+        Buffer *_next;
+        /**
+         * 1 表示被线程持有
+         */
+        volatile int _owned;
+        /**
+         * 消费者读取的位置
+         */
+        volatile size_t _head;
+        /**
+         * 生产者写入的位置
+         */
+        volatile size_t _tail;
+        /**
+         * 丢弃的记录数量 由生产者增加 关闭时消费者计入没有写出的记录
+         */
+        volatile size_t _dropped;
+        Unit _units[Capacity];
+
+        /**
+         * 放入一条记录 仅仅由生产者调用
+         * @return false 表示缓冲区已满
+         */
+        bool offer(const Unit &unit);
+
+        /**
+         * 将缓冲区中的记录写出 需要持有_drain_lock
+         * @return 写出的记录数量
+         */
+        size_t drain_to(OStream *stream);
+    };
+
+    /**
+     * 线程退出时归还缓冲区
+     */
+    struct BufferHolder {
+        Buffer *_buffer;
+
+        ~BufferHolder();
+    };
+
+    /**
+     * 追踪文件 关闭之后为nullptr
+     */
+    static OStream *volatile _stream;
+    /**
+     * 追踪文件是否使用compact格式(见TraceFormat)
+     */
+    static bool _compact;
+    static std::atomic<uint64_t> _next_order_id;
+    static Buffer *volatile _buffers;
+    /**
+     * 同一时刻只允许一个消费者
+     */
+    static volatile int _drain_lock;
+    /**
+     * 进程退出时关闭追踪文件之后为true
+     */
+    static volatile bool _closed;
+    /**
+     * 上一次报告时丢弃的记录总数
+     */
+    static size_t _reported_dropped;
+    thread_local static BufferHolder _holder;
+    /**
+     * 当前线程是否正在写出
+     */
+    thread_local static bool _in_drain;
+
+    /**
+     * 获取当前线程的缓冲区 优先复用已经归还的
+     */
+    static Buffer *current_buffer();
+
+    /**
+     * 将所有的缓冲区写出 需要持有_drain_lock
+     */
+    static void drain_locked();
+
+    /**
+     * 等待获取_drain_lock 然后写出所有的缓冲区
+     */
+    static void lock_and_drain();
+
+    /**
+     * 丢弃的记录总数变化时 输出警告 需要持有_drain_lock
+     */
+    static void report_dropped();
+
+    /**
+     * 进程退出时调用 最后一次写出所有的缓冲区并关闭追踪文件
+     * 没有写出的记录计入丢弃
+     */
+    static void close();
+
+    /**
+     * 按照追踪文件的格式写出一段连续的记录 需要持有_drain_lock
+     */
+    static void write_units(OStream *stream, const Unit *units, size_t num);
+
+    /**
+     * 将当前进程的模块映射保存到追踪文件旁边
+     * 之后通过dlopen加载的模块不会被记录
+     */
+    static void save_maps();
+
 public:
     static inline auto stream() {
         return _stream;
@@ -48,6 +189,17 @@ public:
                            size_t bytes,
                            const NativeCallStack &call_stack);
 
+    /**
+     * 将所有线程缓冲区中的记录写入追踪文件
+     * 已经有其他线程在写出的 直接返回
+     */
+    static void drain();
+
+    /**
+     * @return 所有缓冲区丢弃的记录总数
+     */
+    static size_t dropped();
+
     static void flush();
 };
 
@@ -0,0 +1,194 @@
+//
+// Created by aurora on 2026/10/19.
+//
+
+#include "MallocSiteTable.hpp"
+#include "plat/utils/OrderAccess.hpp"
+#include "plat/utils/robust.hpp"
+#include "plat/thread/SpinYield.hpp"
+#include "plat/stream/CharOStream.hpp"
+
+MallocSiteTable::Site MallocSiteTable::_sites[TableSize] = {};
+volatile size_t MallocSiteTable::_overflow = 0;
+size_t MallocSiteTable::_baseline_bytes[TableSize] = {};
+
+uint64_t MallocSiteTable::hash_of(const NativeCallStack &stack) {
+    uint64_t hash = 0;
+    const auto frames = stack.stack();
+    for (int32_t i = 0; i < NativeCallStack::MAX_DEPTH; ++i) {
+        //splitmix64 的混合函数
+        auto x = hash ^ ((uint64_t) frames[i] + 0x9E3779B97F4A7C15ULL);
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        hash = x ^ (x >> 31);
+    }
+    //0 表示空闲槽位
+    return hash == 0 ? 1 : hash;
+}
+
+bool MallocSiteTable::same_stack(const Site *site, const NativeCallStack &stack) {
+    const auto frames = stack.stack();
+    for (int32_t i = 0; i < NativeCallStack::MAX_DEPTH; ++i) {
+        if (site->_stack[i] != frames[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t MallocSiteTable::record_alloc(MEMFLAG F, const NativeCallStack &stack, size_t bytes) {
+    //没有捕获调用堆栈(summary级别)时 所有的申请都会落到同一个槽位 不按照位置统计
+    if (stack.is_empty()) {
+        return NoSite;
+    }
+    const auto hash = hash_of(stack);
+    auto index = (uint32_t) hash & (TableSize - 1);
+    for (uint32_t probe = 0; probe < TableSize; ++probe, index = (index + 1) & (TableSize - 1)) {
+        const auto site = _sites + index;
+        auto current = OrderAccess::load(&site->_hash);
+        if (current == 0) {
+            current = OrderAccess::cas<uint64_t>(&site->_hash, 0, hash);
+            if (current == 0) {
+                //占用成功 写入堆栈后发布
+                site->_flag = F;
+                const auto frames = stack.stack();
+                for (int32_t i = 0; i < NativeCallStack::MAX_DEPTH; ++i) {
+                    site->_stack[i] = frames[i];
+                }
+                OrderAccess::fence();
+                OrderAccess::store(&site->_ready, 1);
+                current = hash;
+            }
+        }
+        if (current != hash) {
+            continue;
+        }
+        //哈希相同 等待堆栈写入完成后比较
+        SpinYield spin;
+        while (OrderAccess::load(&site->_ready) == 0) {
+            spin.wait();
+        }
+        if (!same_stack(site, stack)) {
+            continue;
+        }
+        const auto live = OrderAccess::fetch_and_add(&site->_live_bytes, bytes) + bytes;
+        OrderAccess::fetch_and_add<size_t>(&site->_live_count, 1);
+        auto peak = OrderAccess::load(&site->_peak_bytes);
+        while (live > peak) {
+            const auto old = OrderAccess::cas(&site->_peak_bytes, peak, live);
+            if (old == peak) {
+                break;
+            }
+            peak = old;
+        }
+        return index + 1;
+    }
+    OrderAccess::fetch_and_add<size_t>(&_overflow, 1);
+    return NoSite;
+}
+
+void MallocSiteTable::record_free(uint32_t site, size_t bytes) {
+    if (site == NoSite) {
+        return;
+    }
+    assert(site <= TableSize, "illegal site");
+    const auto entry = _sites + (site - 1);
+    OrderAccess::fetch_and_sub(&entry->_live_bytes, bytes);
+    OrderAccess::fetch_and_sub<size_t>(&entry->_live_count, 1);
+}
+
+void MallocSiteTable::print_top_sites(CharOStream *out, int top_n) {
+    constexpr int MaxTop = 32;
+    top_n = MIN2(top_n, MaxTop);
+    uint32_t top[MaxTop];
+    int num = 0;
+    uint32_t used = 0;
+    //按照存活字节数 插入排序保留前top_n个
+    for (uint32_t i = 0; i < TableSize; ++i) {
+        if (OrderAccess::load(&_sites[i]._ready) == 0) {
+            continue;
+        }
+        ++used;
+        const auto live = OrderAccess::load(&_sites[i]._live_bytes);
+        int pos = num < top_n ? num++ : top_n;
+        while (pos > 0 && OrderAccess::load(&_sites[top[pos - 1]]._live_bytes) < live) {
+            if (pos < top_n) {
+                top[pos] = top[pos - 1];
+            }
+            --pos;
+        }
+        if (pos < top_n) {
+            top[pos] = i;
+        }
+    }
+    out->print_cr("malloc sites: %u used of %u, " SIZE_FORMAT " allocations not attributed.",
+                  used, TableSize, OrderAccess::load(&_overflow));
+    for (int k = 0; k < num; ++k) {
+        const auto site = _sites + top[k];
+        out->print("  [%d] %s live " SIZE_FORMAT " bytes in " SIZE_FORMAT " allocations, peak " SIZE_FORMAT " bytes, at",
+                   k, MEMFLAG_NAME(site->_flag),
+                   OrderAccess::load(&site->_live_bytes),
+                   OrderAccess::load(&site->_live_count),
+                   OrderAccess::load(&site->_peak_bytes));
+        for (auto frame: site->_stack) {
+            if (frame == nullptr) {
+                break;
+            }
+            out->print(" " PTR_FORMAT, (uintptr_t) frame);
+        }
+        out->print_cr("");
+    }
+}
+
+void MallocSiteTable::baseline() {
+    for (uint32_t i = 0; i < TableSize; ++i) {
+        _baseline_bytes[i] = OrderAccess::load(&_sites[i]._live_bytes);
+    }
+}
+
+void MallocSiteTable::print_site_diff(CharOStream *out, int top_n, size_t threshold) {
+    constexpr int MaxTop = 32;
+    top_n = MIN2(top_n, MaxTop);
+    uint32_t top[MaxTop];
+    int64_t growth[MaxTop];
+    int num = 0;
+    //按照增长的字节数 插入排序保留前top_n个
+    for (uint32_t i = 0; i < TableSize; ++i) {
+        if (OrderAccess::load(&_sites[i]._ready) == 0) {
+            continue;
+        }
+        const auto delta = (int64_t) (OrderAccess::load(&_sites[i]._live_bytes) - _baseline_bytes[i]);
+        if (delta < (int64_t) threshold) {
+            continue;
+        }
+        int pos = num < top_n ? num++ : top_n;
+        while (pos > 0 && growth[pos - 1] < delta) {
+            if (pos < top_n) {
+                top[pos] = top[pos - 1];
+                growth[pos] = growth[pos - 1];
+            }
+            --pos;
+        }
+        if (pos < top_n) {
+            top[pos] = i;
+            growth[pos] = delta;
+        }
+    }
+    if (num > 0) {
+        out->print_cr("malloc sites grown since baseline:");
+    }
+    for (int k = 0; k < num; ++k) {
+        const auto site = _sites + top[k];
+        out->print("  [%d] %s +%ld bytes, live " SIZE_FORMAT " bytes in " SIZE_FORMAT " allocations, at",
+                   k, MEMFLAG_NAME(site->_flag), (long) growth[k],
+                   OrderAccess::load(&site->_live_bytes),
+                   OrderAccess::load(&site->_live_count));
+        for (auto frame: site->_stack) {
+            if (frame == nullptr) {
+                break;
+            }
+            out->print(" " PTR_FORMAT, (uintptr_t) frame);
+        }
+        out->print_cr("");
+    }
+}
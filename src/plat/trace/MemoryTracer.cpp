@@ -1,14 +1,21 @@
 //
 // Created by aurora on 2024/6/25.
 //
+#include <cstdlib>
 #include <cstring>
 #include "MemoryTracer.hpp"
 #include "SummaryMemory.hpp"
 #include "DetailLogMemory.hpp"
+#include "MallocSiteTable.hpp"
+#include "VirtualMemoryMap.hpp"
 #include "global/flag.hpp"
 #include "plat/utils/robust.hpp"
+#include "plat/stream/CharOStream.hpp"
+#include "plat/stream/FileCharOStream.hpp"
 
 MemoryTracer::NMT_Level MemoryTracer::_nmt_level = NMT_Level::unknown;
+MemoryTracer::Snapshot MemoryTracer::_baseline = {};
+bool MemoryTracer::_has_baseline = false;
 
 void MemoryTracer::record(MEMFLAG F,
                           MemoryTracer::OperationType type,
@@ -23,23 +30,160 @@ void MemoryTracer::record(MEMFLAG F,
             DetailLogMemory::detail_log(F, type, addr, bytes, call_stack);
         case NMT_Level::summary:
             SummaryMemory::summary(F, type, bytes);
-            return;
+            break;
+    }
+    switch (type) {
+        case OperationType::reserve:
+            VirtualMemoryMap::add_reserved(F, addr, bytes, call_stack);
+            break;
+        case OperationType::commit:
+            VirtualMemoryMap::add_committed(F, addr, bytes, call_stack);
+            break;
+        case OperationType::uncommit:
+            VirtualMemoryMap::remove_committed(addr, bytes);
+            break;
+        case OperationType::release:
+            VirtualMemoryMap::remove_reserved(addr, bytes);
+            break;
+        default:
+            break;
     }
 }
 
-void MemoryTracer::initialize() {
+MemoryTracer::NMT_Level MemoryTracer::parse_level() {
     auto level = global::NMTLevel;
     if (::strcmp(level, "off") == 0) {
-        MemoryTracer::_nmt_level = NMT_Level::off;
+        return NMT_Level::off;
     } else if (::strcmp(level, "summary") == 0) {
-        MemoryTracer::_nmt_level = NMT_Level::summary;
+        return NMT_Level::summary;
     } else if (::strcmp(level, "detail") == 0) {
-        MemoryTracer::_nmt_level = NMT_Level::detail;
+        return NMT_Level::detail;
+    }
+    // 必须在三者选择1个
+    guarantee(false, "Native Memory Trace Level is error, must be selected from off, summary and detail.");
+    return NMT_Level::unknown;
+}
+
+void MemoryTracer::level_initialize() {
+    if (MemoryTracer::_nmt_level == NMT_Level::unknown) {
+        MemoryTracer::_nmt_level = MemoryTracer::parse_level();
+    }
+}
+
+void MemoryTracer::initialize() {
+    MemoryTracer::level_initialize();
+    //之前申请的本地内存已经按照该等级决定是否带有头部
+    guarantee(MemoryTracer::parse_level() == MemoryTracer::_nmt_level,
+              "NMTLevel must be set before the first native memory allocation.");
+    if (MemoryTracer::_nmt_level == NMT_Level::detail) {
         DetailLogMemory::global_initialize();
-    } else {
-        // 必须在三者选择1个
-        guarantee(false, "Native Memory Trace Level is error, must be selected from off, summary and detail.");
     }
+    //捕获调用堆栈的开销较大 只有详细记录(以及按照调用位置统计)需要
+    NativeCallStack::set_capture_enabled(MemoryTracer::_nmt_level == NMT_Level::detail);
+    if (global::PrintNMTStatistics && MemoryTracer::_nmt_level != NMT_Level::off) {
+        ::atexit(MemoryTracer::print_report_at_exit);
+    }
+}
+
+void MemoryTracer::drain() {
+    if (MemoryTracer::_nmt_level == NMT_Level::detail) {
+        DetailLogMemory::drain();
+    }
+}
+
+void MemoryTracer::print_virtual_memory(CharOStream *out) {
+    VirtualMemoryMap::print_on(out);
+}
+
+void MemoryTracer::print_malloc_sites(CharOStream *out, int top_n) {
+    MallocSiteTable::print_top_sites(out, top_n);
+}
+
+bool MemoryTracer::snapshot(MemoryTracer::Snapshot *out) {
+    if (MemoryTracer::_nmt_level != NMT_Level::summary &&
+        MemoryTracer::_nmt_level != NMT_Level::detail) {
+        return false;
+    }
+    SummaryMemory::snapshot(out);
+    return true;
+}
+
+bool MemoryTracer::baseline() {
+    if (!MemoryTracer::snapshot(&MemoryTracer::_baseline)) {
+        return false;
+    }
+    MallocSiteTable::baseline();
+    MemoryTracer::_has_baseline = true;
+    return true;
+}
+
+/**
+ * 是否达到阈值 变化可能为负
+ */
+static inline bool exceeds(int64_t delta, size_t threshold) {
+    return (delta < 0 ? -delta : delta) >= (int64_t) threshold;
+}
+
+int MemoryTracer::print_diff(CharOStream *out, size_t threshold) {
+    Snapshot current;
+    if (!MemoryTracer::_has_baseline || !MemoryTracer::snapshot(&current)) {
+        return -1;
+    }
+    int reported = 0;
+    for (int32_t i = 0; i < (int32_t) MEMFLAG::num_of_type; ++i) {
+        const auto &now = current._usage[i];
+        const auto &base = MemoryTracer::_baseline._usage[i];
+        //无符号数相减后转换为有符号数 得到带符号的变化
+        const auto reserved = (int64_t) (now._virtual_reserved - base._virtual_reserved);
+        const auto committed = (int64_t) (now._virtual_committed - base._virtual_committed);
+        const auto native = (int64_t) (now._native_alloc - base._native_alloc);
+        const auto arena = (int64_t) (now._arena_alloc - base._arena_alloc);
+        if (!exceeds(reserved, threshold) && !exceeds(committed, threshold) &&
+            !exceeds(native, threshold) && !exceeds(arena, threshold)) {
+            continue;
+        }
+        if (reported++ == 0) {
+            out->print_cr("native memory diff against baseline (threshold " SIZE_FORMAT " bytes):", threshold);
+        }
+        out->print_cr("  %s: reserved %+ld committed %+ld malloc %+ld (%+ld allocations) arena %+ld (%+ld chunks)",
+                      MEMFLAG_NAME((MEMFLAG) i),
+                      (long) reserved, (long) committed,
+                      (long) native, (long) (int64_t) (now._native_count - base._native_count),
+                      (long) arena, (long) (int64_t) (now._arena_count - base._arena_count));
+    }
+    MallocSiteTable::print_site_diff(out, 10, threshold);
+    return reported;
+}
+
+void MemoryTracer::print_report(CharOStream *out) {
+    Snapshot current;
+    if (!MemoryTracer::snapshot(&current)) {
+        return;
+    }
+    out->print_cr("native memory tracking (%s):", global::NMTLevel);
+    for (int32_t i = 0; i < (int32_t) MEMFLAG::num_of_type; ++i) {
+        const auto &usage = current._usage[i];
+        if (usage._virtual_reserved == 0 && usage._native_alloc == 0 && usage._arena_alloc == 0) {
+            continue;
+        }
+        out->print_cr("  %s: reserved " SIZE_FORMAT " committed " SIZE_FORMAT
+                      " malloc " SIZE_FORMAT " (" SIZE_FORMAT " allocations) arena " SIZE_FORMAT
+                      " (" SIZE_FORMAT " chunks)",
+                      MEMFLAG_NAME((MEMFLAG) i),
+                      usage._virtual_reserved, usage._virtual_committed,
+                      usage._native_alloc, usage._native_count,
+                      usage._arena_alloc, usage._arena_count);
+    }
+    MemoryTracer::print_virtual_memory(out);
+    if (MemoryTracer::_nmt_level == NMT_Level::detail) {
+        MemoryTracer::print_malloc_sites(out, 10);
+    }
+}
+
+void MemoryTracer::print_report_at_exit() {
+    const auto out = FileCharOStream::default_stream();
+    MemoryTracer::print_report(out);
+    out->flush();
 }
 
 void MemoryTracer::flush() {
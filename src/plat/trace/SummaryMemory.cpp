@@ -8,14 +8,26 @@
 #include "plat/stream/OStream.hpp"
 #include "plat/mem/allocation.hpp"
 
-SummaryMemory::Unit SummaryMemory::_unit[];
+SummaryMemory::Stripe SummaryMemory::_stripes[];
+volatile uint32_t SummaryMemory::_next_stripe = 0;
+thread_local uint32_t SummaryMemory::_stripe_index = 0;
 
 
+inline SummaryMemory::Stripe *SummaryMemory::current_stripe() {
+    auto index = SummaryMemory::_stripe_index;
+    if (index == 0) {
+        //轮流分配 使得线程尽量均匀的分布
+        index = (OrderAccess::fetch_and_add<uint32_t>(&SummaryMemory::_next_stripe, 1) & (Stripes - 1)) + 1;
+        SummaryMemory::_stripe_index = index;
+    }
+    return SummaryMemory::_stripes + (index - 1);
+}
 
 void SummaryMemory::summary(MEMFLAG F,
                             MemoryTracer::OperationType type,
                             size_t bytes) {
-    const auto unit = SummaryMemory::_unit + (int32_t)F;
+    //多个线程可能共享一个条带 依然需要原子操作 但是竞争很少
+    const auto unit = SummaryMemory::current_stripe()->_unit + (int32_t) F;
     switch (type) {
         case MemoryTracer::OperationType::reserve:
             OrderAccess::fetch_and_add(&unit->_virtual_reserved, bytes);
@@ -46,8 +58,8 @@ void SummaryMemory::summary(MEMFLAG F,
             break;
 
         case MemoryTracer::OperationType::arena_free:
-            OrderAccess::fetch_and_add(&unit->_arena_alloc, bytes);
-            OrderAccess::fetch_and_add<size_t>(&unit->_arena_count, 1);
+            OrderAccess::fetch_and_sub(&unit->_arena_alloc, bytes);
+            OrderAccess::fetch_and_sub<size_t>(&unit->_arena_count, 1);
             break;
         case MemoryTracer::OperationType::max:
             should_not_reach_here();
@@ -55,19 +67,37 @@ void SummaryMemory::summary(MEMFLAG F,
     }
 }
 
+void SummaryMemory::snapshot(MemoryTracer::Snapshot *out) {
+    for (int32_t i = 0; i < SummaryMemory::max_tag; ++i) {
+        auto &usage = out->_usage[i];
+        //无符号数的回绕保证了各个条带的和是正确的
+        usage = MemoryTracer::Usage{0, 0, 0, 0, 0, 0};
+        for (const auto &stripe: SummaryMemory::_stripes) {
+            const auto unit = stripe._unit + i;
+            usage._virtual_reserved += OrderAccess::load(&unit->_virtual_reserved);
+            usage._virtual_committed += OrderAccess::load(&unit->_virtual_committed);
+            usage._native_alloc += OrderAccess::load(&unit->_native_alloc);
+            usage._native_count += OrderAccess::load(&unit->_native_count);
+            usage._arena_alloc += OrderAccess::load(&unit->_arena_alloc);
+            usage._arena_count += OrderAccess::load(&unit->_arena_count);
+        }
+    }
+}
+
 void SummaryMemory::output(OStream *stream) {
     if (stream == nullptr) {
         return;
     }
+    MemoryTracer::Snapshot snapshot;
+    SummaryMemory::snapshot(&snapshot);
     stream->lock();
-    for (uint8_t i = 0; i < SummaryMemory::max_tag; ++i) {
-        const auto unit = SummaryMemory::_unit + i;
-        stream->write_uint64(unit->_virtual_reserved);
-        stream->write_uint64(unit->_virtual_committed);
-        stream->write_uint64(unit->_arena_alloc);
-        stream->write_uint64(unit->_arena_count);
-        stream->write_uint64(unit->_native_alloc);
-        stream->write_uint64(unit->_native_count);
+    for (const auto &usage: snapshot._usage) {
+        stream->write_uint64(usage._virtual_reserved);
+        stream->write_uint64(usage._virtual_committed);
+        stream->write_uint64(usage._arena_alloc);
+        stream->write_uint64(usage._arena_count);
+        stream->write_uint64(usage._native_alloc);
+        stream->write_uint64(usage._native_count);
     }
     stream->unlock();
 }
@@ -8,7 +8,16 @@
 #include "stdtype.hpp"
 #include "MemoryTracer.hpp"
 #include "plat/mem/allocation.hpp"
+#include "plat/constants.hpp"
 class OStream;
+
+/**
+ * 汇总的内存追踪
+ *
+ * 计数器按照线程分散到多个条带中 每个线程第一次记录时轮流分配一个条带
+ * 不同线程更新不同的缓存行 避免同一个内存类型的计数器被激烈竞争
+ * 释放和申请可能位于不同的条带 单个条带的计数可能"为负" 求和后才有意义
+ */
 class SummaryMemory {
 private:
     struct Unit {
@@ -21,7 +30,23 @@ private:
         explicit Unit()noexcept;
     };
     constexpr static inline auto max_tag = (int32_t)(MEMFLAG::num_of_type);
-    static Unit _unit[max_tag];
+    /**
+     * 条带的数量 必须是2的幂次
+     */
+    constexpr static inline uint32_t Stripes = 16;
+
+    struct alignas(CacheLineBytes) Stripe {
+        Unit _unit[max_tag];
+    };
+    static Stripe _stripes[Stripes];
+    static volatile uint32_t _next_stripe;
+    /**
+     * 当前线程使用的条带序号 + 1 , 0表示尚未分配
+     */
+    thread_local static uint32_t _stripe_index;
+
+    static inline Stripe *current_stripe();
+
 public:
 
 
@@ -29,6 +54,12 @@ public:
                         MemoryTracer::OperationType type,
                         size_t bytes);
 
+    /**
+     * 将所有条带求和 不会阻塞正在记录的线程
+     * 不同条带之间不是同一时刻读取的 结果是近似的快照
+     */
+    static void snapshot(MemoryTracer::Snapshot *out);
+
     static void output(OStream* stream);
 };
 
@@ -0,0 +1,99 @@
+//
+// Created by aurora on 2026/10/19.
+//
+
+#ifndef PLAT_TRACE_TRACE_FORMAT_HPP
+#define PLAT_TRACE_TRACE_FORMAT_HPP
+
+#include "stdtype.hpp"
+#include "plat/mem/AllStatic.hpp"
+
+/**
+ * 详细内存追踪文件的格式 写出和离线解析共用
+ *
+ * 文件头  "GNMT" 版本(1字节) 调用堆栈的最大深度(1字节)
+ *
+ * raw(版本2) 文件头之后直接是连续的DetailLogMemory::Unit 多字节字段为网络字节序
+ *
+ * 旧的raw(版本1) 没有文件头 记录的序号只有16位 排列在线程id之前
+ *   内存类型(1字节) 操作类型(1字节) 序号(2字节) 线程id(4字节) 地址 字节数 调用堆栈
+ *   第一个字节是内存类型 不会与文件头冲突 据此区分
+ *
+ * compact(版本3) 文件头之后是一系列条目 每个条目以一个字节的标签开始
+ *   Stack  调用堆栈的字典 第n个Stack条目的编号为n(从1开始 0表示空的堆栈)
+ *          深度(varint) 每一帧相对于上一帧的差值(zigzag varint)
+ *   Block  同一个线程连续的记录
+ *          线程id(varint) 记录数量(varint) 之后依次是每一条记录
+ *          内存类型(1字节) 操作类型(1字节) 堆栈编号(varint)
+ *          地址 序号 相对于块内上一条记录的差值(zigzag varint) 字节数(varint)
+ * 堆栈总是在第一次被引用之前写出
+ */
+class TraceFormat : public AllStatic {
+public:
+    constexpr inline static char Magic[4] = {'G', 'N', 'M', 'T'};
+    constexpr inline static size_t HeaderBytes = sizeof(Magic) + 2;
+    constexpr inline static uint8_t LegacyRawVersion = 1;
+    constexpr inline static uint8_t RawVersion = 2;
+    constexpr inline static uint8_t CompactVersion = 3;
+
+    enum Tag : uint8_t {
+        StackTag = 1,
+        BlockTag = 2
+    };
+
+    /**
+     * 填充文件头
+     * @param out 至少HeaderBytes个字节
+     */
+    static inline void fill_header(uint8_t *out, uint8_t version, uint8_t max_depth) {
+        for (size_t i = 0; i < sizeof(Magic); ++i) {
+            out[i] = (uint8_t) Magic[i];
+        }
+        out[sizeof(Magic)] = version;
+        out[sizeof(Magic) + 1] = max_depth;
+    };
+
+    /**
+     * 一个varint最多占用的字节数
+     */
+    constexpr inline static size_t MaxVarintBytes = 10;
+
+    static inline uint64_t zigzag(int64_t value) {
+        return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+    };
+
+    static inline int64_t unzigzag(uint64_t value) {
+        return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+    };
+
+    /**
+     * 每个字节保存7位 最高位表示后面还有字节
+     * @return 写入之后的位置
+     */
+    static inline uint8_t *put_varint(uint8_t *p, uint64_t value) {
+        while (value >= 0x80) {
+            *p++ = (uint8_t) (value | 0x80);
+            value >>= 7;
+        }
+        *p++ = (uint8_t) value;
+        return p;
+    };
+
+    /**
+     * @return 读取之后的位置 数据不完整或者过长时返回nullptr
+     */
+    static inline const uint8_t *get_varint(const uint8_t *p, const uint8_t *end, uint64_t *value) {
+        uint64_t result = 0;
+        for (uint32_t shift = 0; shift < 64 && p < end; shift += 7) {
+            const auto byte = *p++;
+            result |= (uint64_t) (byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                *value = result;
+                return p;
+            }
+        }
+        return nullptr;
+    };
+};
+
+#endif //PLAT_TRACE_TRACE_FORMAT_HPP
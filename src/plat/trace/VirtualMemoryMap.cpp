@@ -0,0 +1,321 @@
+//
+// Created by aurora on 2026/10/19.
+//
+
+#include <cstdlib>
+#include <cstring>
+#include "VirtualMemoryMap.hpp"
+#include "plat/utils/OrderAccess.hpp"
+#include "plat/utils/robust.hpp"
+#include "plat/thread/SpinYield.hpp"
+#include "plat/stream/CharOStream.hpp"
+
+VirtualMemoryMap::Region *VirtualMemoryMap::_regions = nullptr;
+uint32_t VirtualMemoryMap::_num_regions = 0;
+uint32_t VirtualMemoryMap::_cap_regions = 0;
+size_t VirtualMemoryMap::_untracked_commits = 0;
+volatile int VirtualMemoryMap::_lock = 0;
+
+void VirtualMemoryMap::lock() {
+    SpinYield spin;
+    while (OrderAccess::xchg(&VirtualMemoryMap::_lock, 1) != 0) {
+        spin.wait();
+    }
+}
+
+void VirtualMemoryMap::unlock() {
+    OrderAccess::xchg(&VirtualMemoryMap::_lock, 0);
+}
+
+template<typename T>
+void VirtualMemoryMap::ensure_capacity(T *&items, uint32_t &cap, uint32_t need) {
+    if (need <= cap) {
+        return;
+    }
+    const auto new_cap = MAX2<uint32_t>(cap * 2, MAX2<uint32_t>(need, 8));
+    //直接使用realloc 不可以经过CHEAP_ALLOC
+    const auto new_items = (T *) ::realloc(items, new_cap * sizeof(T));
+    if (new_items == nullptr) {
+        vm_exit_out_of_memory(VMErrorType::OOM_MALLOC_ERROR,
+                              new_cap * sizeof(T),
+                              "虚拟内存区域表扩展失败");
+    }
+    items = new_items;
+    cap = new_cap;
+}
+
+template<typename T>
+uint32_t VirtualMemoryMap::lower_bound(const T *items, uint32_t num, uintptr_t addr) {
+    uint32_t low = 0;
+    uint32_t high = num;
+    while (low < high) {
+        const auto mid = (low + high) >> 1;
+        if (items[mid]._end > addr) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return low;
+}
+
+bool VirtualMemoryMap::can_merge(const Range &left, const Range &right) {
+    return left._end == right._base &&
+           left._flag == right._flag &&
+           ::memcmp(left._stack, right._stack, sizeof(left._stack)) == 0;
+}
+
+void VirtualMemoryMap::init_range(Range *range, MEMFLAG F, void *addr, size_t bytes, const NativeCallStack &stack) {
+    range->_base = (uintptr_t) addr;
+    range->_end = (uintptr_t) addr + bytes;
+    range->_flag = F;
+    ::memcpy(range->_stack, stack.stack(), sizeof(range->_stack));
+}
+
+void VirtualMemoryMap::remove_ranges(Region *region, uintptr_t lo, uintptr_t hi) {
+    auto &ranges = region->_committed;
+    auto &num = region->_num_committed;
+    auto i = lower_bound(ranges, num, lo);
+    while (i < num && ranges[i]._base < hi) {
+        auto &range = ranges[i];
+        if (range._base < lo && range._end > hi) {
+            //位于中间 分裂为两个
+            ensure_capacity(ranges, region->_cap_committed, num + 1);
+            ::memmove(ranges + i + 2, ranges + i + 1, (num - i - 1) * sizeof(Range));
+            ranges[i + 1] = ranges[i];
+            ranges[i + 1]._base = hi;
+            ranges[i]._end = lo;
+            ++num;
+            return;
+        }
+        if (range._base < lo) {
+            range._end = lo;
+            ++i;
+            continue;
+        }
+        if (range._end > hi) {
+            range._base = hi;
+            return;
+        }
+        //完全覆盖 删除
+        ::memmove(ranges + i, ranges + i + 1, (num - i - 1) * sizeof(Range));
+        --num;
+    }
+}
+
+void VirtualMemoryMap::insert_range(Region *region, const Range &range) {
+    auto &ranges = region->_committed;
+    auto &num = region->_num_committed;
+    auto i = lower_bound(ranges, num, range._base);
+    assert(i == num || ranges[i]._base >= range._end, "子区间不可以重叠");
+    if (i > 0 && can_merge(ranges[i - 1], range)) {
+        ranges[i - 1]._end = range._end;
+        //与后一个也相接 三者合并
+        if (i < num && can_merge(ranges[i - 1], ranges[i])) {
+            ranges[i - 1]._end = ranges[i]._end;
+            ::memmove(ranges + i, ranges + i + 1, (num - i - 1) * sizeof(Range));
+            --num;
+        }
+        return;
+    }
+    if (i < num && can_merge(range, ranges[i])) {
+        ranges[i]._base = range._base;
+        return;
+    }
+    ensure_capacity(ranges, region->_cap_committed, num + 1);
+    ::memmove(ranges + i + 1, ranges + i, (num - i) * sizeof(Range));
+    ranges[i] = range;
+    ++num;
+}
+
+VirtualMemoryMap::Region *VirtualMemoryMap::region_containing(uintptr_t addr) {
+    const auto i = lower_bound(_regions, _num_regions, addr);
+    if (i < _num_regions && _regions[i]._base <= addr) {
+        return _regions + i;
+    }
+    return nullptr;
+}
+
+void VirtualMemoryMap::remove_regions(uintptr_t lo, uintptr_t hi) {
+    auto i = lower_bound(_regions, _num_regions, lo);
+    while (i < _num_regions && _regions[i]._base < hi) {
+        auto region = _regions + i;
+        remove_ranges(region, lo, hi);
+        if (region->_base < lo && region->_end > hi) {
+            //位于中间 分裂为两个 高地址部分的子区间移动到新的区间
+            ensure_capacity(_regions, _cap_regions, _num_regions + 1);
+            region = _regions + i;
+            ::memmove(_regions + i + 2, _regions + i + 1, (_num_regions - i - 1) * sizeof(Region));
+            ++_num_regions;
+            auto right = _regions + i + 1;
+            *right = *region;
+            right->_base = hi;
+            const auto split = lower_bound(region->_committed, region->_num_committed, hi);
+            right->_num_committed = region->_num_committed - split;
+            right->_cap_committed = 0;
+            right->_committed = nullptr;
+            if (right->_num_committed > 0) {
+                ensure_capacity(right->_committed, right->_cap_committed, right->_num_committed);
+                ::memcpy(right->_committed, region->_committed + split,
+                         right->_num_committed * sizeof(Range));
+            }
+            region->_num_committed = split;
+            region->_end = lo;
+            return;
+        }
+        if (region->_base < lo) {
+            region->_end = lo;
+            ++i;
+            continue;
+        }
+        if (region->_end > hi) {
+            region->_base = hi;
+            return;
+        }
+        //完全覆盖 删除
+        ::free(region->_committed);
+        ::memmove(_regions + i, _regions + i + 1, (_num_regions - i - 1) * sizeof(Region));
+        --_num_regions;
+    }
+}
+
+void VirtualMemoryMap::add_reserved(MEMFLAG F, void *addr, size_t bytes, const NativeCallStack &stack) {
+    Range range;
+    init_range(&range, F, addr, bytes, stack);
+    lock();
+    //强制映射(MAP_FIXED)会覆盖原有的映射
+    remove_regions(range._base, range._end);
+    auto i = lower_bound(_regions, _num_regions, range._base);
+    if (i > 0 && can_merge(_regions[i - 1], range)) {
+        auto left = _regions + i - 1;
+        left->_end = range._end;
+        if (i < _num_regions && can_merge(*left, _regions[i])) {
+            //与后一个也相接 合并子区间
+            auto right = _regions + i;
+            for (uint32_t k = 0; k < right->_num_committed; ++k) {
+                insert_range(left, right->_committed[k]);
+            }
+            left->_end = right->_end;
+            ::free(right->_committed);
+            ::memmove(_regions + i, _regions + i + 1, (_num_regions - i - 1) * sizeof(Region));
+            --_num_regions;
+        }
+        unlock();
+        return;
+    }
+    if (i < _num_regions && can_merge(range, _regions[i])) {
+        _regions[i]._base = range._base;
+        unlock();
+        return;
+    }
+    ensure_capacity(_regions, _cap_regions, _num_regions + 1);
+    ::memmove(_regions + i + 1, _regions + i, (_num_regions - i) * sizeof(Region));
+    auto region = _regions + i;
+    *(Range *) region = range;
+    region->_committed = nullptr;
+    region->_num_committed = 0;
+    region->_cap_committed = 0;
+    ++_num_regions;
+    unlock();
+}
+
+void VirtualMemoryMap::remove_reserved(void *addr, size_t bytes) {
+    lock();
+    remove_regions((uintptr_t) addr, (uintptr_t) addr + bytes);
+    unlock();
+}
+
+void VirtualMemoryMap::add_committed(MEMFLAG F, void *addr, size_t bytes, const NativeCallStack &stack) {
+    Range range;
+    init_range(&range, F, addr, bytes, stack);
+    lock();
+    const auto region = region_containing(range._base);
+    if (region == nullptr || region->_end < range._end) {
+        //不是通过os::reserve_memory保留的内存
+        ++_untracked_commits;
+        unlock();
+        return;
+    }
+    //重复提交时以最后一次为准
+    remove_ranges(region, range._base, range._end);
+    insert_range(region, range);
+    unlock();
+}
+
+void VirtualMemoryMap::remove_committed(void *addr, size_t bytes) {
+    const auto lo = (uintptr_t) addr;
+    const auto hi = lo + bytes;
+    lock();
+    auto i = lower_bound(_regions, _num_regions, lo);
+    for (; i < _num_regions && _regions[i]._base < hi; ++i) {
+        remove_ranges(_regions + i, lo, hi);
+    }
+    unlock();
+}
+
+bool VirtualMemoryMap::lookup(const void *addr, Info *info) {
+    const auto p = (uintptr_t) addr;
+    lock();
+    const auto region = region_containing(p);
+    if (region == nullptr) {
+        unlock();
+        return false;
+    }
+    info->_reserved_base = region->_base;
+    info->_reserved_bytes = region->_end - region->_base;
+    info->_reserved_flag = region->_flag;
+    ::memcpy(info->_reserved_stack, region->_stack, sizeof(info->_reserved_stack));
+    const auto i = lower_bound(region->_committed, region->_num_committed, p);
+    info->_committed = i < region->_num_committed && region->_committed[i]._base <= p;
+    if (info->_committed) {
+        const auto &range = region->_committed[i];
+        info->_committed_base = range._base;
+        info->_committed_bytes = range._end - range._base;
+        info->_committed_flag = range._flag;
+        ::memcpy(info->_committed_stack, range._stack, sizeof(info->_committed_stack));
+    }
+    unlock();
+    return true;
+}
+
+void VirtualMemoryMap::totals(size_t *reserved, size_t *committed) {
+    size_t r = 0;
+    size_t c = 0;
+    lock();
+    for (uint32_t i = 0; i < _num_regions; ++i) {
+        const auto &region = _regions[i];
+        r += region._end - region._base;
+        for (uint32_t k = 0; k < region._num_committed; ++k) {
+            c += region._committed[k]._end - region._committed[k]._base;
+        }
+    }
+    unlock();
+    *reserved = r;
+    *committed = c;
+}
+
+static void print_stack(CharOStream *out, void *const *stack) {
+    for (int32_t i = 0; i < NativeCallStack::MAX_DEPTH && stack[i] != nullptr; ++i) {
+        out->print(" " PTR_FORMAT, (uintptr_t) stack[i]);
+    }
+    out->print_cr("");
+}
+
+void VirtualMemoryMap::print_on(CharOStream *out) {
+    lock();
+    out->print_cr("virtual memory map: %u reserved regions, " SIZE_FORMAT " untracked commits.",
+                  _num_regions, _untracked_commits);
+    for (uint32_t i = 0; i < _num_regions; ++i) {
+        const auto &region = _regions[i];
+        out->print("[" PTR_FORMAT " - " PTR_FORMAT ") reserved " SIZE_FORMAT "K for %s from",
+                   region._base, region._end, (region._end - region._base) / K, MEMFLAG_NAME(region._flag));
+        print_stack(out, region._stack);
+        for (uint32_t k = 0; k < region._num_committed; ++k) {
+            const auto &range = region._committed[k];
+            out->print("    [" PTR_FORMAT " - " PTR_FORMAT ") committed " SIZE_FORMAT "K for %s from",
+                       range._base, range._end, (range._end - range._base) / K, MEMFLAG_NAME(range._flag));
+            print_stack(out, range._stack);
+        }
+    }
+    unlock();
+}
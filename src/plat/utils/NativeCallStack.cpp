@@ -4,9 +4,40 @@
 
 #include "plat/utils/NativeCallStack.hpp"
 #include <cstring>
+#include <execinfo.h>
+#include <pthread.h>
 
 
 NativeCallStack NativeCallStack::_empty_stack;
+bool NativeCallStack::_capture_enabled = false;
+
+/**
+ * 当前线程栈的范围 [low,high) 第一次使用时获取
+ * high为0表示无法获取
+ */
+struct ThreadStackRange {
+    bool _initialized;
+    uintptr_t _low;
+    uintptr_t _high;
+};
+static thread_local ThreadStackRange stack_range = {false, 0, 0};
+
+static inline const ThreadStackRange &current_stack_range() {
+    if (!stack_range._initialized) {
+        stack_range._initialized = true;
+        pthread_attr_t attr;
+        if (::pthread_getattr_np(::pthread_self(), &attr) == 0) {
+            void *addr = nullptr;
+            size_t bytes = 0;
+            if (::pthread_attr_getstack(&attr, &addr, &bytes) == 0) {
+                stack_range._low = (uintptr_t) addr;
+                stack_range._high = (uintptr_t) addr + bytes;
+            }
+            ::pthread_attr_destroy(&attr);
+        }
+    }
+    return stack_range;
+}
 
 NativeCallStack::NativeCallStack() noexcept {
     ::memset(this->_stack, 0, sizeof(this->_stack));
@@ -39,8 +70,8 @@ int NativeCallStack::frames() {
 
 
 void *NativeCallStack::top() const {
-    int i = NativeCallStack::MAX_DEPTH;
-    for (; i > 0; --i) {
+    int i = NativeCallStack::MAX_DEPTH - 1;
+    for (; i >= 0; --i) {
         auto value = this->_stack[i];
         if (value != nullptr) {
             return value;
@@ -57,20 +88,78 @@ void NativeCallStack::record_current_caller() {
     }
 }
 
-NativeCallStack::NativeCallStack(uint16_t depth) {
-    depth = MIN2<uint16_t>(depth, MAX_DEPTH);
-#define stack_case(depth) case depth:  _stack[depth] = return_thread_pc<depth>();
-    switch (depth) {
-        stack_case(4);
-        stack_case(3);
-        stack_case(2);
-        stack_case(1);
-        stack_case(0);
-        break;
-        default:
+__attribute__((noinline))
+int NativeCallStack::walk_frame_pointers(void **pcs, int max_depth, int skip) {
+#ifdef PLAT_FRAME_POINTER
+    const auto &range = current_stack_range();
+    if (range._high == 0) {
+        return -1;
+    }
+    //栈帧的布局 [fp] 调用者的fp  [fp + 1] 返回地址
+    auto fp = (void **) __builtin_frame_address(0);
+    int count = 0;
+    while (count < max_depth) {
+        const auto literal = (uintptr_t) fp;
+        if (literal < range._low ||
+            literal + 2 * sizeof(void *) > range._high ||
+            (literal & (sizeof(void *) - 1)) != 0) {
+            break;
+        }
+        const auto pc = fp[1];
+        if (pc == nullptr) {
             break;
+        }
+        if (skip > 0) {
+            --skip;
+        } else {
+            pcs[count++] = pc;
+        }
+        const auto next = (void **) fp[0];
+        //栈向低地址增长 调用者的栈帧必然位于更高的地址
+        if (next <= fp) {
+            break;
+        }
+        fp = next;
+    }
+    return count;
+#else
+    return -1;
+#endif
+}
+
+__attribute__((noinline))
+int NativeCallStack::walk_backtrace(void **pcs, int max_depth, int skip) {
+    constexpr int MaxFrames = 32;
+    void *frames[MaxFrames];
+    //第0帧是当前函数
+    const auto total = ::backtrace(frames, MIN2(max_depth + skip + 1, MaxFrames));
+    int count = 0;
+    for (int i = skip + 1; i < total && count < max_depth; ++i) {
+        pcs[count++] = frames[i];
+    }
+    return count;
+}
+
+NativeCallStack::NativeCallStack(uint16_t skip) {
+    int count = 0;
+    if (NativeCallStack::_capture_enabled) {
+        //跳过当前的构造函数 以及创建对象的函数
+        count = walk_frame_pointers(this->_stack, MAX_DEPTH, skip + 2);
+        if (count < 0) {
+            count = walk_backtrace(this->_stack, MAX_DEPTH, skip + 2);
+        }
+        /**
+         * 都没有得到栈帧时(例如展开库不可用) 退回到原本的方式 只记录创建者中的返回地址
+         * 深度为0的返回地址不依赖栈帧指针 总是可用
+         */
+        if (count <= 0) {
+            this->_stack[0] = return_thread_pc<0>();
+            count = 1;
+        }
+    }
+    for (int32_t i = count; i < MAX_DEPTH; ++i) {
+        this->_stack[i] = nullptr;
     }
-#undef stack_case
 }
 
 
@@ -0,0 +1,88 @@
+//
+// Created by aurora on 2026/10/19.
+//
+/**
+ * SegmentHeaderPool 多个线程并发地申请和归还头部
+ * 同一个头部不能同时交给两个线程(ABA会导致这种情况) 结束时栈中的头部互不相同
+ */
+#include <cstdio>
+#include <pthread.h>
+#include <sched.h>
+#include <set>
+#include "plat/PlatInitialize.hpp"
+#include "plat/os/time.hpp"
+#include "plat/utils/robust.hpp"
+#include "kernel/thread/LangThread.hpp"
+#include "global/flag.hpp"
+#include "SegmentHeaderPool.hpp"
+
+using metaspace::Segment;
+using metaspace::SegmentHeaderPool;
+
+static constexpr int NumThreads = 4;
+static constexpr int Rounds = 20000;
+static constexpr int Batch = 8;
+
+static volatile int g_start = 0;
+
+static void *worker_main(void *arg) {
+    const auto id = (uintptr_t) arg;
+    const auto pool = SegmentHeaderPool::pool();
+    Segment *held[Batch];
+    while (OrderAccess::load(&g_start) == 0) {
+        ::sched_yield();
+    }
+    for (int round = 0; round < Rounds; ++round) {
+        for (int i = 0; i < Batch; ++i) {
+            const auto segment = pool->allocate_segment_header();
+            guarantee(segment->is_free() && segment->base() == nullptr, "header is not clean");
+            //用base记录持有者 其他线程拿到同一个头部时会覆盖
+            const auto tag = (void *) ((id << 32) | ((uintptr_t) round << 4) | (uintptr_t) i | 0x8);
+            segment->initialize(nullptr, tag, segment->level());
+            held[i] = segment;
+        }
+        if ((round & 63) == 0) {
+            ::sched_yield();
+        }
+        for (int i = 0; i < Batch; ++i) {
+            const auto tag = (void *) ((id << 32) | ((uintptr_t) round << 4) | (uintptr_t) i | 0x8);
+            guarantee(held[i]->base() == tag, "header handed out twice");
+            pool->deallocate_segment_header(held[i]);
+        }
+    }
+    return nullptr;
+}
+
+int main() {
+    global::NMTLevel = "summary";
+    PlatInitialize::initialize(os::current_stamp(), new LangThread());
+    if (SegmentHeaderPool::pool() == nullptr) {
+        SegmentHeaderPool::initialize();
+    }
+    const auto pool = SegmentHeaderPool::pool();
+    pthread_t threads[NumThreads];
+    for (int i = 0; i < NumThreads; ++i) {
+        guarantee(::pthread_create(threads + i, nullptr, worker_main, (void *) (uintptr_t) (i + 1)) == 0,
+                  "create thread failed");
+    }
+    OrderAccess::store(&g_start, 1);
+    for (auto thread: threads) {
+        ::pthread_join(thread, nullptr);
+    }
+    guarantee(pool->live_headers() == 0, "live headers %d", pool->live_headers());
+    //全部归还之后 从Slab切分出的头部都在栈中
+    const auto free_headers = pool->free_headers();
+    guarantee(free_headers >= Batch, "free headers %d", free_headers);
+    //依次弹出 栈中不能出现重复的头部 否则链表已经成环或者丢失
+    std::set<Segment *> seen;
+    for (int i = 0; i < free_headers; ++i) {
+        const auto segment = pool->allocate_segment_header();
+        guarantee(seen.insert(segment).second, "header %p appears twice in the stack", segment);
+    }
+    guarantee(pool->free_headers() == 0, "free headers left %d", pool->free_headers());
+    for (auto segment: seen) {
+        pool->deallocate_segment_header(segment);
+    }
+    ::printf("test_segment_header_pool: ok (%d free headers,%d slabs)\n", free_headers, pool->slab_nums());
+    return 0;
+}
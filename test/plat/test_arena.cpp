@@ -0,0 +1,177 @@
+//
+// Created by aurora on 2026/10/19.
+//
+/**
+ * Arena 的备用区域(之前内存块剩余的尾部) 原地调整 单独映射 以及按照序号回滚单独映射的内存
+ * 单独映射的内存释放之后 内存追踪中保留和提交的大小都回到原来的值
+ */
+#include <cstdio>
+#include <cstring>
+#include "plat/PlatInitialize.hpp"
+#include "plat/mem/Arena.hpp"
+#include "plat/os/mem.hpp"
+#include "plat/os/time.hpp"
+#include "plat/utils/robust.hpp"
+#include "kernel/thread/LangThread.hpp"
+#include "global/flag.hpp"
+#include "ArenaChunk.hpp"
+#include "MemoryTracer.hpp"
+
+static MemoryTracer::Usage arena_usage() {
+    MemoryTracer::Snapshot snapshot;
+    guarantee(MemoryTracer::snapshot(&snapshot), "NMT is off");
+    return snapshot._usage[(int32_t) MEMFLAG::Arena];
+}
+
+class CountChunkClosure : public Arena::ChunkClosure {
+public:
+    int _count = 0;
+
+    void do_chunk(void *base, void *top) override {
+        ++this->_count;
+    }
+};
+
+static int count_chunks(Arena *arena) {
+    CountChunkClosure closure;
+    arena->iter_chunk(&closure);
+    return closure._count;
+}
+
+/**
+ * 当前块放不下时 旧块的尾部成为备用区域 较小的申请以及在其中的原地调整都优先使用它
+ */
+static void test_spare_tail() {
+    Arena arena(MEMFLAG::Arena);
+    const auto first = (char *) arena.alloc(704, true);
+    //当前块只剩下small_bytes - 704 申请新的大块 旧块的尾部成为备用区域
+    const auto other = (char *) arena.alloc(400, true);
+    guarantee(other != first + 704, "the first chunk should be full");
+    guarantee(arena.recovered_bytes() == 0, "nothing recovered yet");
+
+    const auto spare = (char *) arena.alloc(100, true);
+    guarantee(spare == first + 704, "small request should come from the spare tail");
+    guarantee(arena.recovered_bytes() == 104, "recovered %zu", arena.recovered_bytes());
+    ::memset(spare, 0x5a, 104);
+
+    //备用区域中最后一次申请 原地调整
+    guarantee(arena.realloc(spare, 104, 200, true) == spare, "grow in the spare tail");
+    guarantee(arena.recovered_bytes() == 200, "recovered %zu", arena.recovered_bytes());
+
+    //备用区域放不下 拷贝到当前块 旧的位于备用区域末尾 可以归还
+    const auto moved = (char *) arena.realloc(spare, 200, ArenaChunk::small_bytes, true);
+    guarantee(moved != spare, "spare tail is too small");
+    for (int i = 0; i < 104; ++i) {
+        guarantee(moved[i] == 0x5a, "content lost at %d", i);
+    }
+    guarantee(arena.alloc(104, true) == spare, "old block should be returned to the spare tail");
+}
+
+/**
+ * 当前块中最后一次申请 扩大和缩小都不移动
+ */
+static void test_grow_in_place() {
+    Arena arena(MEMFLAG::Arena, ArenaChunk::medium_bytes);
+    const auto first = (char *) arena.alloc(64, true);
+    const auto last = (char *) arena.alloc(64, true);
+    guarantee(arena.realloc(last, 64, 4096, true) == last, "grow the last allocation in place");
+    guarantee(arena.realloc(last, 4096, 128, true) == last, "shrink the last allocation in place");
+    //缩小之后的结束位置就是当前的top
+    guarantee(arena.free(last, 128), "top should follow the shrunk size");
+    //不是最后一次申请 缩小时保持不变 扩大时拷贝
+    guarantee(arena.alloc(64, true) == last, "freed block should be reused");
+    guarantee(arena.realloc(first, 64, 32, true) == first, "shrink keeps the address");
+    const auto copy = arena.realloc(first, 32, 256, true);
+    guarantee(copy != first, "middle allocation can not grow in place");
+    guarantee(count_chunks(&arena) == 1, "no new chunk needed");
+}
+
+/**
+ * 不小于DirectMapBytes的申请单独映射 页对齐的余量内原地扩大 释放之后归还给操作系统
+ */
+static void test_direct_map() {
+    const auto page = (size_t) os::page_size();
+    const auto before = arena_usage();
+    {
+        Arena arena(MEMFLAG::Arena);
+        const auto chunks = count_chunks(&arena);
+        const auto bytes = Arena::DirectMapBytes;
+        const auto big = (char *) arena.alloc(bytes, true);
+        guarantee(big != nullptr, "direct map failed");
+        guarantee(count_chunks(&arena) == chunks, "direct map should not add a chunk");
+        const auto mapped = arena.large_bytes();
+        guarantee(mapped >= bytes && mapped % page == 0, "mapped %zu", mapped);
+        ::memset(big, 0x3c, bytes);
+
+        //映射页对齐之后剩余的部分足够
+        const auto slack = mapped - bytes - (size_t) ((uintptr_t) big % page);
+        guarantee(arena.realloc(big, bytes, bytes + slack, true) == big, "grow within the mapping");
+        guarantee(arena.large_bytes() == mapped, "no new mapping");
+
+        //超出映射 重新映射并释放旧的
+        const auto grown = (char *) arena.realloc(big, bytes + slack, 4 * bytes, true);
+        guarantee(grown != big, "mapping is too small");
+        guarantee(arena.large_bytes() >= 4 * bytes && arena.large_bytes() < mapped + 4 * bytes,
+                  "old mapping should be released,large %zu", arena.large_bytes());
+        for (size_t i = 0; i < bytes; ++i) {
+            guarantee(grown[i] == 0x3c, "content lost at %zu", i);
+        }
+        //单独映射的内存总是可以释放 不要求是最后一次申请
+        arena.alloc(64, true);
+        guarantee(arena.free(grown, 4 * bytes), "direct map should always be freed");
+        guarantee(arena.large_bytes() == 0, "large %zu", arena.large_bytes());
+        arena.alloc(2 * bytes, true);
+    }
+    //析构时释放剩余的单独映射
+    const auto after = arena_usage();
+    guarantee(after._virtual_reserved == before._virtual_reserved &&
+              after._virtual_committed == before._virtual_committed,
+              "NMT unbalanced: reserved %zu -> %zu,committed %zu -> %zu",
+              before._virtual_reserved, after._virtual_reserved,
+              before._virtual_committed, after._virtual_committed);
+}
+
+/**
+ * 回滚恢复当前区域和备用区域 删除标记之后的内存块 并释放标记之后映射的内存
+ * 标记之前映射的保留 即使在标记期间释放了其中的一部分
+ */
+static void test_rollback() {
+    const auto bytes = Arena::DirectMapBytes;
+    Arena arena(MEMFLAG::Arena);
+    const auto kept = (char *) arena.alloc(bytes, true);
+    const auto freed_in_mark = (char *) arena.alloc(bytes, true);
+    const auto large_before_free = arena.large_bytes();
+    const auto chunks = count_chunks(&arena);
+    Arena::SavedData saved(&arena);
+    const auto top = arena.alloc(64, true);
+    guarantee(arena.free(top, 64), "free the probe");
+
+    guarantee(arena.free(freed_in_mark, bytes), "free a mapping from before the mark");
+    const auto large_at_mark = arena.large_bytes();
+    guarantee(large_at_mark < large_before_free, "mapping should be released");
+    for (int i = 0; i < 4; ++i) {
+        arena.alloc(bytes, true);
+        arena.alloc(ArenaChunk::small_bytes, true);
+    }
+    guarantee(count_chunks(&arena) > chunks, "new chunks after the mark");
+    guarantee(arena.large_bytes() > large_at_mark, "new mappings after the mark");
+
+    saved.rollback_to(&arena);
+    guarantee(count_chunks(&arena) == chunks, "chunks after the mark should be deleted");
+    guarantee(arena.large_bytes() == large_at_mark, "large %zu,expect %zu", arena.large_bytes(), large_at_mark);
+    guarantee(arena.alloc(64, true) == top, "top should be restored");
+    ::memset(kept, 0x11, bytes);
+    guarantee(arena.free(kept, bytes), "mapping from before the mark should be kept");
+    guarantee(arena.large_bytes() == 0, "large %zu", arena.large_bytes());
+}
+
+int main() {
+    global::NMTLevel = "summary";
+    PlatInitialize::initialize(os::current_stamp(), new LangThread());
+    test_spare_tail();
+    test_grow_in_place();
+    test_direct_map();
+    test_rollback();
+    ::printf("test_arena: ok\n");
+    return 0;
+}
@@ -0,0 +1,93 @@
+//
+// Created by aurora on 2026/10/19.
+//
+/**
+ * ArenaChunkPool 按照需求保留内存块
+ * 保留目标 target = max(峰值, 上次目标 >> RetainDecayShift) 池中保留 target - 仍被取走的数量
+ * 需求消失之后 保留的数量在几次清理中逐渐衰减到0
+ */
+#include <cstdio>
+#include <new>
+#include "plat/PlatInitialize.hpp"
+#include "plat/os/time.hpp"
+#include "plat/utils/robust.hpp"
+#include "kernel/thread/LangThread.hpp"
+#include "global/flag.hpp"
+#include "ArenaChunk.hpp"
+#include "ArenaChunkPool.hpp"
+
+static constexpr size_t Burst = 16;
+static constexpr int MaxPurges = 64;
+
+/**
+ * 与ArenaChunk::operator new相同 但是绕过线程缓存 直接使用内存池
+ */
+static ArenaChunk *take(ArenaChunkPool *pool) {
+    auto chunk = pool->alloc();
+    if (chunk == nullptr) {
+        pool->record_miss();
+        const auto len = (size_t) ArenaChunk::large_bytes;
+        const auto mem = NEW_CHEAP_ARRAY(uint8_t, sizeof(ArenaChunk) + len, MEMFLAG::Chunk);
+        chunk = ::new(mem) ArenaChunk(sizeof(ArenaChunk) + len);
+    }
+    return chunk;
+}
+
+int main() {
+    global::NMTLevel = "summary";
+    PlatInitialize::initialize(os::current_stamp(), new LangThread());
+    const auto pool = ArenaChunkPool::get_pool(ArenaChunk::large_bytes);
+    const auto base_in_use = pool->in_use();
+
+    //没有新的需求 之前的保留目标衰减到当前被取走的数量 池被清空
+    for (int i = 0; i < MaxPurges && pool->retain_target() != base_in_use; ++i) {
+        ArenaChunkPool::clean();
+    }
+    guarantee(pool->retain_target() == base_in_use, "target %zu,in-use %zu",
+              pool->retain_target(), base_in_use);
+    guarantee(pool->num_chunks() == 0, "pool should be empty,retained %zu", pool->num_chunks());
+
+    //一次突发的需求 全部归还之后 本周期的峰值使得全部保留
+    ArenaChunk *chunks[Burst];
+    for (auto &chunk: chunks) {
+        chunk = take(pool);
+    }
+    guarantee(pool->in_use() == base_in_use + Burst, "in-use %zu", pool->in_use());
+    for (auto chunk: chunks) {
+        pool->free(chunk);
+    }
+    guarantee(pool->in_use() == base_in_use, "in-use %zu", pool->in_use());
+    ArenaChunkPool::clean();
+    auto target = base_in_use + Burst;
+    guarantee(pool->retain_target() == target, "target %zu", pool->retain_target());
+    guarantee(pool->num_chunks() == Burst, "retained %zu", pool->num_chunks());
+
+    //之后每次清理 没有新的峰值时保留目标减半 保留的数量随之减少
+    auto retained = pool->num_chunks();
+    auto peak = base_in_use;
+    int purges = 0;
+    while (retained > 0) {
+        guarantee(++purges <= MaxPurges, "retained chunks never decay");
+        ArenaChunkPool::clean();
+        target = MAX2(peak, target >> ArenaChunkPool::RetainDecayShift);
+        guarantee(pool->retain_target() == target, "target %zu,expect %zu", pool->retain_target(), target);
+        guarantee(pool->num_chunks() == target - base_in_use, "retained %zu,expect %zu",
+                  pool->num_chunks(), target - base_in_use);
+        guarantee(peak > base_in_use || pool->num_chunks() < retained, "retained chunks should decrease");
+        retained = pool->num_chunks();
+        peak = base_in_use;
+        if (purges == 1) {
+            //衰减中保留的内存块仍然可以命中 全部取走再归还 下一次清理维持当前的目标
+            for (size_t i = 0; i < retained; ++i) {
+                chunks[i] = pool->alloc();
+                guarantee(chunks[i] != nullptr, "retained chunk should be a hit");
+            }
+            for (size_t i = 0; i < retained; ++i) {
+                pool->free(chunks[i]);
+            }
+            peak = base_in_use + retained;
+        }
+    }
+    ::printf("test_arena_chunk_pool: ok (%d purges)\n", purges);
+    return 0;
+}
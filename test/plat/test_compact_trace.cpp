@@ -0,0 +1,96 @@
+//
+// Created by aurora on 2026/10/19.
+//
+/**
+ * CompactTraceWriter写出的追踪文件 由离线解析工具(tools/nmt_decode)还原
+ * 用法: plat-test_compact_trace <tools-nmt_decode的路径>
+ *
+ * 三个线程先后申请 释放 再申请同一个地址 写出的顺序与实际的顺序相反
+ * 解析工具需要按照序号恢复顺序 否则释放会被记为孤立的释放 或者存活的申请被记为覆盖了存活的申请
+ */
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include "CompactTraceWriter.hpp"
+#include "plat/stream/FileCharOStream.hpp"
+#include "plat/utils/robust.hpp"
+
+using Unit = DetailLogMemory::Unit;
+using OperationType = MemoryTracer::OperationType;
+
+/**
+ * 超过16位 验证序号不会回绕
+ */
+static constexpr uint64_t OrderBase = (uint64_t) 1 << 40;
+
+static Unit make_unit(uint32_t thread_id, uint64_t order, OperationType type, MEMFLAG F,
+                      uintptr_t addr, size_t bytes, uintptr_t caller) {
+    Unit unit{};
+    unit._memory_tag = (uint8_t) F;
+    unit._operation_type = (uint8_t) type;
+    unit._thread_id = thread_id;
+    unit._order_id = OrderBase + order;
+    unit._addr = addr;
+    unit._bytes = bytes;
+    unit._caller[0] = caller;
+    unit._caller[1] = caller == 0 ? 0 : caller + 0x40;
+    return unit;
+}
+
+static void expect(const char *output, const char *text) {
+    guarantee(::strstr(output, text) != nullptr, "decoder output has no \"%s\":\n%s", text, output);
+}
+
+int main(int argc, char **argv) {
+    guarantee(argc > 1, "usage: %s <tools-nmt_decode>", argv[0]);
+    char path[64];
+    ::snprintf(path, sizeof(path), "/tmp/test-compact-trace-%d.trace", (int) ::getpid());
+    const uintptr_t x = 0x7f0000001000;
+    const uintptr_t z = 0x10000;
+    //线程1: 申请x(1) 申请z(4) 释放z(5)
+    const Unit first[] = {
+            make_unit(1, 1, OperationType::native_alloc, MEMFLAG::Symbol, x, 32, 0x401000),
+            make_unit(1, 4, OperationType::native_alloc, MEMFLAG::Symbol, z, 16, 0x401000),
+            make_unit(1, 5, OperationType::native_free, MEMFLAG::Symbol, z, 16, 0),
+    };
+    //线程2: 释放x(2)
+    const Unit second[] = {
+            make_unit(2, 2, OperationType::native_free, MEMFLAG::Symbol, x, 32, 0),
+    };
+    //线程3: 再次申请x(3)
+    const Unit third[] = {
+            make_unit(3, 3, OperationType::native_alloc, MEMFLAG::Symbol, x, 48, 0x402000),
+    };
+    {
+        FileCharOStream stream(path);
+        guarantee(stream.is_open(), "can not open %s", path);
+        CompactTraceWriter::write_header(&stream);
+        CompactTraceWriter::write(&stream, second, sizeof(second) / sizeof(Unit));
+        CompactTraceWriter::write(&stream, third, sizeof(third) / sizeof(Unit));
+        CompactTraceWriter::write(&stream, first, sizeof(first) / sizeof(Unit));
+        CompactTraceWriter::flush(&stream);
+        stream.flush();
+    }
+    char command[512];
+    ::snprintf(command, sizeof(command), "%s %s 3 /dev/null 2>&1", argv[1], path);
+    const auto pipe = ::popen(command, "r");
+    guarantee(pipe != nullptr, "can not run %s", command);
+    static char output[16 * 1024];
+    const auto n = ::fread(output, 1, sizeof(output) - 1, pipe);
+    output[n] = '\0';
+    const auto status = ::pclose(pipe);
+    ::unlink(path);
+    guarantee(status == 0, "decoder failed:\n%s", output);
+
+    expect(output, "(version 3): 5 records");
+    expect(output, "2 stacks in dictionary, 0 invalid records, 0 trailing bytes ignored, "
+                   "0 records out of reorder window.");
+    expect(output, "Symbol       native_alloc              3 ops               96 bytes");
+    expect(output, "Symbol       native_free               2 ops               48 bytes");
+    //只有线程3申请的x存活
+    expect(output, "Symbol       48 bytes in 1 allocations");
+    expect(output, "0 frees without allocation (before tracing or dropped), "
+                   "0 allocations over a live address (free dropped).");
+    ::printf("compact trace: ok\n");
+    return 0;
+}
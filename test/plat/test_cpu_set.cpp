@@ -0,0 +1,64 @@
+//
+// Created by aurora on 2026/10/19.
+//
+/**
+ * CpuSet::parse_list 解析内核的CPU列表格式 以及print_on输出相同的格式
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "plat/os/cpu.hpp"
+#include "plat/stream/FileCharOStream.hpp"
+#include "plat/utils/robust.hpp"
+
+using os::CpuSet;
+
+/**
+ * 解析list 之后按照列表格式输出 应当与expect相同
+ */
+static void check_list(const char *list, uint32_t count, const char *expect) {
+    CpuSet set;
+    guarantee(set.parse_list(list), "\"%s\" is rejected", list);
+    guarantee(set.count() == count, "\"%s\" has %u cpus, expect %u", list, set.count(), count);
+    char *buf = nullptr;
+    size_t bytes = 0;
+    const auto file = ::open_memstream(&buf, &bytes);
+    guarantee(file != nullptr, "open_memstream failed");
+    {
+        FileCharOStream out(file);
+        set.print_on(&out);
+        out.flush();
+    }
+    ::fclose(file);
+    guarantee(::strcmp(buf, expect) == 0, "\"%s\" is printed as \"%s\", expect \"%s\"", list, buf, expect);
+    ::free(buf);
+}
+
+int main() {
+    check_list("", 0, "");
+    check_list("0", 1, "0");
+    check_list("0-3", 4, "0-3");
+    check_list("0-3,8,10-11", 7, "0-3,8,10-11");
+    //sysfs中的文件以换行结束
+    check_list("2,4-5\n", 3, "2,4-5");
+    //重复以及相邻的部分合并输出
+    check_list("3,1-2,2-4", 4, "1-4");
+    check_list("1023", 1, "1023");
+    //超出MaxCpus的部分被忽略
+    check_list("1022-2000", 2, "1022-1023");
+
+    //解析的结果追加到集合中
+    CpuSet set;
+    guarantee(set.parse_list("0-1") && set.parse_list("4"), "append failed");
+    guarantee(set.count() == 3 && set.contains(0) && set.contains(1) && set.contains(4) && !set.contains(2),
+              "append result is wrong");
+    guarantee(set.next(0) == 0 && set.next(2) == 4 && set.next(5) == CpuSet::MaxCpus, "next is wrong");
+
+    const char *const malformed[] = {"a", "-1", "3-1", "1-", "1,,2", "0-3,x"};
+    for (const auto list: malformed) {
+        CpuSet bad;
+        guarantee(!bad.parse_list(list), "malformed \"%s\" is accepted", list);
+    }
+    ::printf("cpu set: ok\n");
+    return 0;
+}
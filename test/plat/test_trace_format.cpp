@@ -0,0 +1,61 @@
+//
+// Created by aurora on 2026/10/19.
+//
+/**
+ * TraceFormat的varint和zigzag编码 解码之后与原值相同
+ */
+#include <cstdio>
+#include "TraceFormat.hpp"
+#include "plat/utils/robust.hpp"
+
+static void check_zigzag(int64_t value) {
+    guarantee(TraceFormat::unzigzag(TraceFormat::zigzag(value)) == value,
+              "zigzag round trip failed for %ld", (long) value);
+}
+
+static void check_varint(uint64_t value) {
+    uint8_t buf[TraceFormat::MaxVarintBytes];
+    const auto end = TraceFormat::put_varint(buf, value);
+    guarantee(end > buf && (size_t) (end - buf) <= TraceFormat::MaxVarintBytes,
+              "varint of %lu takes %ld bytes", value, (long) (end - buf));
+    uint64_t decoded = ~value;
+    guarantee(TraceFormat::get_varint(buf, end, &decoded) == end && decoded == value,
+              "varint round trip failed for %lu", value);
+    //截断的数据不可以被解码
+    guarantee(TraceFormat::get_varint(buf, end - 1, &decoded) == nullptr,
+              "truncated varint of %lu is accepted", value);
+}
+
+int main() {
+    //绝对值小的数编码之后同样小
+    guarantee(TraceFormat::zigzag(0) == 0 && TraceFormat::zigzag(-1) == 1 &&
+              TraceFormat::zigzag(1) == 2 && TraceFormat::zigzag(-2) == 3, "zigzag mapping is wrong");
+    const int64_t signed_values[] = {0, 1, -1, 63, -64, 64, -65, INT32_MAX, INT32_MIN, INT64_MAX, INT64_MIN};
+    for (const auto value: signed_values) {
+        check_zigzag(value);
+        check_varint(TraceFormat::zigzag(value));
+    }
+    //每7位的边界
+    for (uint32_t shift = 0; shift < 64; ++shift) {
+        const auto value = (uint64_t) 1 << shift;
+        check_varint(value - 1);
+        check_varint(value);
+        check_varint(value + 1);
+    }
+    check_varint(UINT64_MAX);
+    uint8_t buf[TraceFormat::MaxVarintBytes];
+    guarantee(TraceFormat::put_varint(buf, 127) - buf == 1 &&
+              TraceFormat::put_varint(buf, 128) - buf == 2 &&
+              TraceFormat::put_varint(buf, UINT64_MAX) - buf == (ssize_t) TraceFormat::MaxVarintBytes,
+              "varint length is wrong");
+    //超过10个字节的varint是非法的
+    uint8_t overlong[TraceFormat::MaxVarintBytes + 1];
+    for (auto &byte: overlong) {
+        byte = 0x80;
+    }
+    uint64_t decoded;
+    guarantee(TraceFormat::get_varint(overlong, overlong + sizeof(overlong), &decoded) == nullptr,
+              "overlong varint is accepted");
+    ::printf("trace format: ok\n");
+    return 0;
+}
@@ -0,0 +1,106 @@
+//
+// Created by aurora on 2026/10/19.
+//
+/**
+ * os::UncommitBatch 加入时与前后相接的区间合并
+ * 使用dontneed撤销 撤销之后的页读到0 没有撤销的页保持原来的数据
+ */
+#include <cstdio>
+#include "plat/PlatInitialize.hpp"
+#include "plat/os/mem.hpp"
+#include "plat/os/time.hpp"
+#include "plat/utils/robust.hpp"
+#include "kernel/thread/LangThread.hpp"
+#include "global/flag.hpp"
+
+static constexpr size_t NumPages = 80;
+static char *g_base = nullptr;
+static size_t g_page = 0;
+
+static inline void *page(size_t index) {
+    return g_base + index * g_page;
+}
+
+static void fill() {
+    for (size_t i = 0; i < NumPages; ++i) {
+        *(volatile char *) page(i) = 1;
+    }
+}
+
+/**
+ * @param first,last [first,last)之间的页应当已经撤销
+ */
+static void check_uncommitted(size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+        guarantee(*(volatile char *) page(i) == 0, "page %zu is not uncommitted", i);
+    }
+}
+
+static void check_kept(size_t index) {
+    guarantee(*(volatile char *) page(index) == 1, "page %zu is uncommitted", index);
+}
+
+static void add(os::UncommitBatch &batch, size_t first, size_t pages) {
+    guarantee(batch.add(page(first), pages * g_page), "uncommit [%zu, +%zu) failed", first, pages);
+}
+
+static void flush_and_check(os::UncommitBatch &batch, size_t added, size_t calls) {
+    guarantee(batch.flush(), "flush failed");
+    guarantee(batch.num_added() == added && batch.num_calls() == calls,
+              "added %zu calls %zu, expect %zu and %zu", batch.num_added(), batch.num_calls(), added, calls);
+}
+
+int main() {
+    //不写出追踪文件
+    global::NMTLevel = "summary";
+    PlatInitialize::initialize(os::current_stamp(), new LangThread());
+    g_page = os::page_size();
+    g_base = (char *) os::reserve_memory(MEMFLAG::GC, NumPages * g_page);
+    guarantee(g_base != nullptr, "reserve failed");
+    guarantee(os::commit_memory(MEMFLAG::GC, g_base, NumPages * g_page, os::CommitType::rw), "commit failed");
+    fill();
+
+    os::UncommitBatch batch(MEMFLAG::GC, os::UncommitType::dontneed);
+    //填补两个区间之间的空隙 三者合并为一次撤销
+    add(batch, 0, 2);
+    add(batch, 4, 2);
+    add(batch, 2, 2);
+    flush_and_check(batch, 3, 1);
+    check_uncommitted(0, 6);
+    check_kept(6);
+
+    //乱序加入 最后一个同样三者合并
+    add(batch, 10, 1);
+    add(batch, 8, 1);
+    add(batch, 9, 1);
+    flush_and_check(batch, 6, 2);
+    check_uncommitted(8, 11);
+    check_kept(7);
+    check_kept(11);
+
+    //只与前一个合并 只与后一个合并
+    add(batch, 12, 1);
+    add(batch, 13, 1);
+    add(batch, 17, 1);
+    add(batch, 16, 1);
+    flush_and_check(batch, 10, 4);
+    check_uncommitted(12, 14);
+    check_uncommitted(16, 18);
+    check_kept(14);
+    check_kept(15);
+
+    //互不相接的区间超出容量 先撤销已有的区间
+    fill();
+    for (size_t i = 0; i < 33; ++i) {
+        add(batch, 2 * i, 1);
+    }
+    guarantee(batch.num_calls() == 4 + 32, "full batch is not flushed");
+    flush_and_check(batch, 43, 4 + 33);
+    for (size_t i = 0; i < 33; ++i) {
+        check_uncommitted(2 * i, 2 * i + 1);
+        check_kept(2 * i + 1);
+    }
+    guarantee(os::release_memory(MEMFLAG::GC, g_base, NumPages * g_page), "release failed");
+    ::printf("uncommit batch: ok\n");
+    return 0;
+}
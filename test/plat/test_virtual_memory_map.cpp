@@ -0,0 +1,104 @@
+//
+// Created by aurora on 2026/10/19.
+//
+/**
+ * VirtualMemoryMap 区间的合并与分裂
+ * 只维护地址区间 不访问内存 使用虚构的地址
+ */
+#include <cstdio>
+#include "VirtualMemoryMap.hpp"
+#include "plat/utils/robust.hpp"
+
+static constexpr size_t P = 4096;
+static const auto Base = (uintptr_t) 0x7e0000000000ULL;
+
+static inline void *at(size_t pages) {
+    return (void *) (Base + pages * P);
+}
+
+/**
+ * 检查地址所在的保留区间 以及已提交的子区间(committed_pages为0表示未提交)
+ */
+static void check_at(size_t page,
+                     size_t reserved_first, size_t reserved_pages,
+                     size_t committed_first, size_t committed_pages) {
+    VirtualMemoryMap::Info info;
+    guarantee(VirtualMemoryMap::lookup(at(page), &info), "page %zu is not reserved", page);
+    guarantee(info._reserved_base == (uintptr_t) at(reserved_first) && info._reserved_bytes == reserved_pages * P,
+              "page %zu: reserved [%zu, +%zu), expect [%zu, +%zu)", page,
+              (size_t) (info._reserved_base - Base) / P, info._reserved_bytes / P, reserved_first, reserved_pages);
+    if (committed_pages == 0) {
+        guarantee(!info._committed, "page %zu should not be committed", page);
+        return;
+    }
+    guarantee(info._committed, "page %zu should be committed", page);
+    guarantee(info._committed_base == (uintptr_t) at(committed_first) && info._committed_bytes == committed_pages * P,
+              "page %zu: committed [%zu, +%zu), expect [%zu, +%zu)", page,
+              (size_t) (info._committed_base - Base) / P, info._committed_bytes / P, committed_first, committed_pages);
+}
+
+static void check_totals(size_t reserved_pages, size_t committed_pages) {
+    size_t reserved, committed;
+    VirtualMemoryMap::totals(&reserved, &committed);
+    guarantee(reserved == reserved_pages * P && committed == committed_pages * P,
+              "totals reserved %zu committed %zu pages, expect %zu and %zu",
+              reserved / P, committed / P, reserved_pages, committed_pages);
+}
+
+int main() {
+    const NativeCallStack empty;
+    void *pcs[] = {(void *) 0x401000};
+    const NativeCallStack other(pcs, 1);
+
+    VirtualMemoryMap::add_reserved(MEMFLAG::GC, at(0), 16 * P, empty);
+    check_totals(16, 0);
+
+    //首尾相接 类型和调用位置相同的提交区间合并
+    VirtualMemoryMap::add_committed(MEMFLAG::GC, at(0), 4 * P, empty);
+    VirtualMemoryMap::add_committed(MEMFLAG::GC, at(4), 4 * P, empty);
+    check_at(0, 0, 16, 0, 8);
+    check_totals(16, 8);
+
+    //撤销中间的一部分 分裂为两个
+    VirtualMemoryMap::remove_committed(at(2), P);
+    check_at(1, 0, 16, 0, 2);
+    check_at(2, 0, 16, 0, 0);
+    check_at(3, 0, 16, 3, 5);
+    check_totals(16, 7);
+
+    //填补空隙 三者合并
+    VirtualMemoryMap::add_committed(MEMFLAG::GC, at(2), P, empty);
+    check_at(7, 0, 16, 0, 8);
+    check_totals(16, 8);
+
+    //调用位置不同 不合并
+    VirtualMemoryMap::add_committed(MEMFLAG::GC, at(8), 2 * P, other);
+    check_at(8, 0, 16, 8, 2);
+    check_at(7, 0, 16, 0, 8);
+    check_totals(16, 10);
+
+    //释放保留区间的中间部分 保留区间分裂 提交的子区间被截断
+    VirtualMemoryMap::remove_reserved(at(6), 6 * P);
+    check_at(5, 0, 6, 0, 6);
+    check_at(12, 12, 4, 12, 0);
+    VirtualMemoryMap::Info info;
+    guarantee(!VirtualMemoryMap::lookup(at(8), &info), "released page is still reserved");
+    check_totals(10, 6);
+
+    //重新保留空隙 与前后两个保留区间合并
+    VirtualMemoryMap::add_reserved(MEMFLAG::GC, at(6), 6 * P, empty);
+    check_at(13, 0, 16, 0, 0);
+    check_at(0, 0, 16, 0, 6);
+    check_totals(16, 6);
+
+    //类型不同的保留区间不合并
+    VirtualMemoryMap::add_reserved(MEMFLAG::Metaspace, at(16), 4 * P, empty);
+    check_at(16, 16, 4, 0, 0);
+    check_at(15, 0, 16, 0, 0);
+
+    VirtualMemoryMap::remove_reserved(at(0), 20 * P);
+    check_totals(0, 0);
+    guarantee(!VirtualMemoryMap::lookup(at(0), &info), "all pages are released");
+    ::printf("virtual memory map: ok\n");
+    return 0;
+}
@@ -0,0 +1,33 @@
+//
+// Created by aurora on 2026/10/19.
+//
+/**
+ * 输出VM看到的CPU拓扑 用于检查容器中的CPU配额和cpuset是否被正确识别
+ * 用法: tools-cpu_topology [cpu...]
+ *
+ * 1 汇总 在线/允许/有效的CPU数量 节点 插槽 核心 以及缓存的大小
+ * 2 对于参数中给出的每个CPU 输出所在的节点 同一核心的超线程 以及共享最后一级缓存的CPU
+ */
+#include <cstdlib>
+#include "plat/os/cpu.hpp"
+#include "plat/stream/FileCharOStream.hpp"
+#include "inner_os.hpp"
+
+int main(int argc, char **argv) {
+    os::cpu_topology_initialize();
+    const auto out = FileCharOStream::default_stream();
+    os::print_cpu_topology(out);
+    for (int i = 1; i < argc; ++i) {
+        const auto cpu = (uint32_t) ::strtoul(argv[i], nullptr, 10);
+        os::CpuSet set;
+        out->print("cpu %u: node %d core siblings ", cpu, os::cpu_node(cpu));
+        os::cpu_core_siblings(cpu, &set);
+        set.print_on(out);
+        out->print(" llc siblings ");
+        os::cpu_llc_siblings(cpu, &set);
+        set.print_on(out);
+        out->cr();
+    }
+    FileCharOStream::flush_default_stream();
+    return 0;
+}
@@ -0,0 +1,1121 @@
+//
+// Created by aurora on 2026/10/19.
+//
+/**
+ * 详细内存追踪文件(DetailLogMemory)的离线解析工具
+ * 用法: tools-nmt_decode <trace> [top_n] [maps]
+ *
+ * 按照固定大小的窗口依次映射追踪文件 顺序读取记录 读完的窗口立即解除映射
+ * 根据文件头识别raw和compact两种格式(见TraceFormat) 没有文件头的是旧的raw格式
+ * 1 按照内存类型和操作类型 汇总次数和字节数
+ * 2 本地内存和快速内存按照地址配对申请和释放 文件结束时仍然存活的视为泄漏 按照内存类型和调用位置汇总
+ * 3 调用位置通过模块映射文件(默认为 <trace>.maps)还原为模块内的偏移 再借助模块文件中的ELF符号表还原为符号
+ *
+ * 占用的内存只与调用位置(compact格式还有堆栈字典)的数量 以及同一时刻存活的申请数量有关 与追踪文件的大小无关
+ *
+ * 不同线程的记录按照缓冲区写出 文件中的先后顺序并不严格
+ * 在固定大小的窗口内按照序号重新排序 恢复实际发生的先后顺序
+ * 超出窗口的乱序无法恢复 先于申请出现的释放记为孤立的释放 之后同一地址序号更大的申请与其抵消
+ * 虚拟内存的操作以区间为单位 不进行配对 只做汇总
+ */
+#include <algorithm>
+#include <queue>
+#include <type_traits>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <fcntl.h>
+#include <elf.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "stdtype.hpp"
+#include "plat/constants.hpp"
+#include "plat/utils/ByteOrder.hpp"
+#include "plat/stream/FileCharOStream.hpp"
+#include "DetailLogMemory.hpp"
+#include "TraceFormat.hpp"
+
+using Unit = DetailLogMemory::Unit;
+using OperationType = MemoryTracer::OperationType;
+
+static constexpr int32_t NumOfFlag = (int32_t) MEMFLAG::num_of_type;
+static constexpr int32_t NumOfType = (int32_t) OperationType::max;
+static constexpr int32_t MaxDepth = NativeCallStack::MAX_DEPTH;
+
+/**
+ * 旧的raw格式(版本1)的记录 见TraceFormat
+ */
+struct LegacyUnit {
+    uint8_t _memory_tag;
+    uint8_t _operation_type;
+    uint16_t _order_id;
+    uint32_t _thread_id;
+    uintptr_t _addr;
+    size_t _bytes;
+    uintptr_t _caller[MaxDepth];
+};
+
+/**
+ * 每次映射的窗口大小
+ */
+static constexpr size_t WindowBytes = 64 * M;
+
+/**
+ * 重新排序时保留的记录数量
+ * 一次写出包含全部线程缓冲区中的记录 乱序的距离通常不超过缓冲区的总容量
+ */
+static constexpr size_t ReorderRecords = 256 * K;
+
+static const char *const TYPE_NAMES[NumOfType] = {
+        "reserve", "commit", "uncommit", "release",
+        "native_alloc", "native_free", "arena_alloc", "arena_free"
+};
+
+static void *checked_realloc(void *p, size_t bytes) {
+    const auto result = ::realloc(p, bytes);
+    if (result == nullptr) {
+        ::fprintf(stderr, "error: out of memory (" SIZE_FORMAT " bytes).\n", bytes);
+        ::exit(1);
+    }
+    return result;
+}
+
+/**
+ * 转换为主机序之后的记录
+ */
+struct Record {
+    MEMFLAG _flag;
+    OperationType _type;
+    /**
+     * 全局序号 表示实际发生的先后顺序
+     */
+    uint64_t _order;
+    uintptr_t _addr;
+    size_t _bytes;
+    uintptr_t _caller[MaxDepth];
+
+    /**
+     * @param index 记录在文件中的位置
+     * @return 内存类型或者操作类型非法时返回false
+     */
+    template<typename RawUnit>
+    bool decode(const RawUnit &unit, uint64_t index) {
+        if (unit._memory_tag >= NumOfFlag || unit._operation_type >= NumOfType) {
+            return false;
+        }
+        this->_flag = (MEMFLAG) unit._memory_tag;
+        this->_type = (OperationType) unit._operation_type;
+        //旧格式的序号只有16位 会回绕 只能按照文件中的顺序处理
+        if constexpr (std::is_same_v<RawUnit, LegacyUnit>) {
+            this->_order = index;
+        } else {
+            this->_order = ByteOrder::host(unit._order_id);
+        }
+        this->_addr = ByteOrder::host(unit._addr);
+        this->_bytes = ByteOrder::host(unit._bytes);
+        for (int32_t i = 0; i < MaxDepth; ++i) {
+            this->_caller[i] = ByteOrder::host(unit._caller[i]);
+        }
+        return true;
+    };
+};
+
+/**
+ * 按照序号恢复记录的先后顺序
+ * 保留最多ReorderRecords条记录 超出时交出序号最小的一条
+ */
+class Reorderer {
+private:
+    struct Later {
+        bool operator()(const Record &l, const Record &r) const {
+            return l._order > r._order;
+        };
+    };
+
+    std::priority_queue<Record, std::vector<Record>, Later> _pending;
+    /**
+     * 已经交出的最大序号 以及晚于它到达的记录数量(无法恢复顺序)
+     */
+    uint64_t _last;
+    size_t _late;
+    bool _emitted;
+
+    template<typename Closure>
+    void emit(Closure &closure) {
+        const auto record = this->_pending.top();
+        this->_pending.pop();
+        if (this->_emitted && record._order < this->_last) {
+            ++this->_late;
+        } else {
+            this->_last = record._order;
+            this->_emitted = true;
+        }
+        closure(record);
+    };
+
+public:
+    Reorderer() : _last(0), _late(0), _emitted(false) {};
+
+    template<typename Closure>
+    void accept(const Record &record, Closure &closure) {
+        this->_pending.push(record);
+        if (this->_pending.size() > ReorderRecords) {
+            this->emit(closure);
+        }
+    };
+
+    /**
+     * 交出剩余的全部记录
+     */
+    template<typename Closure>
+    void finish(Closure &closure) {
+        while (!this->_pending.empty()) {
+            this->emit(closure);
+        }
+    };
+
+    [[nodiscard]] inline size_t late() const {
+        return this->_late;
+    };
+};
+
+/**
+ * 按照固定大小的窗口顺序读取追踪文件
+ */
+class TraceReader {
+private:
+    int _fd;
+    size_t _file_bytes;
+    size_t _page_bytes;
+    /**
+     * 当前映射的窗口 以及在文件中的起始位置
+     */
+    uint8_t *_window;
+    size_t _window_base;
+    size_t _window_bytes;
+    /**
+     * 下一个读取的位置
+     */
+    size_t _offset;
+    /**
+     * compact格式的堆栈字典 编号为序号加1
+     */
+    std::vector<uintptr_t> _stacks;
+    /**
+     * 内存类型或者操作类型非法的记录数量
+     */
+    size_t _invalid;
+    /**
+     * 文件的格式版本 以及compact格式中记录的堆栈最大深度
+     */
+    uint8_t _version;
+    uint8_t _max_depth;
+
+    /**
+     * 保证从当前位置开始至少bytes字节(或者剩余的全部字节)已经映射
+     * @return 当前位置对应的地址 映射失败时返回nullptr
+     */
+    const uint8_t *map(size_t bytes, const uint8_t **end) {
+        if (this->_window == nullptr ||
+            this->_offset + MIN2(bytes, this->remaining()) > this->_window_base + this->_window_bytes) {
+            if (this->_window != nullptr) {
+                ::munmap(this->_window, this->_window_bytes);
+                this->_window = nullptr;
+            }
+            const auto base = this->_offset / this->_page_bytes * this->_page_bytes;
+            const auto len = MIN2(WindowBytes, this->_file_bytes - base);
+            const auto window = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, this->_fd, (off_t) base);
+            if (window == MAP_FAILED) {
+                return nullptr;
+            }
+            ::madvise(window, len, MADV_SEQUENTIAL);
+            this->_window = (uint8_t *) window;
+            this->_window_base = base;
+            this->_window_bytes = len;
+        }
+        *end = this->_window + this->_window_bytes;
+        return this->_window + (this->_offset - this->_window_base);
+    };
+
+    template<typename RawUnit, typename Closure>
+    ssize_t for_each_raw(size_t begin, Closure closure) {
+        ssize_t count = 0;
+        this->_offset = begin;
+        while (this->remaining() >= sizeof(RawUnit)) {
+            const uint8_t *end;
+            const auto p = this->map(sizeof(RawUnit), &end);
+            if (p == nullptr) {
+                return -1;
+            }
+            RawUnit unit;
+            ::memcpy(&unit, p, sizeof(RawUnit));
+            this->_offset += sizeof(RawUnit);
+            Record record;
+            if (record.decode(unit, count)) {
+                closure(record);
+            } else {
+                ++this->_invalid;
+            }
+            ++count;
+        }
+        return count;
+    };
+
+    /**
+     * @return 读取之后的位置 数据不完整时返回nullptr
+     */
+    const uint8_t *read_stack(const uint8_t *p, const uint8_t *end) {
+        uint64_t depth;
+        p = TraceFormat::get_varint(p, end, &depth);
+        if (p == nullptr || depth > (uint64_t) MaxDepth) {
+            return nullptr;
+        }
+        uintptr_t stack[MaxDepth] = {};
+        uintptr_t prev = 0;
+        for (uint64_t i = 0; i < depth; ++i) {
+            uint64_t delta;
+            p = TraceFormat::get_varint(p, end, &delta);
+            if (p == nullptr) {
+                return nullptr;
+            }
+            prev += (uintptr_t) TraceFormat::unzigzag(delta);
+            stack[i] = prev;
+        }
+        this->_stacks.insert(this->_stacks.end(), stack, stack + MaxDepth);
+        return p;
+    };
+
+    /**
+     * @return 读取之后的位置 数据不完整或者非法时返回nullptr
+     */
+    const uint8_t *read_record(const uint8_t *p, const uint8_t *end, Record *record,
+                               uintptr_t *prev_addr, uint64_t *prev_order, bool *valid) {
+        if (end - p < 2) {
+            return nullptr;
+        }
+        const auto tag = *p++;
+        const auto type = *p++;
+        uint64_t id, addr, order, bytes;
+        if ((p = TraceFormat::get_varint(p, end, &id)) == nullptr ||
+            (p = TraceFormat::get_varint(p, end, &addr)) == nullptr ||
+            (p = TraceFormat::get_varint(p, end, &order)) == nullptr ||
+            (p = TraceFormat::get_varint(p, end, &bytes)) == nullptr) {
+            return nullptr;
+        }
+        *prev_addr += (uintptr_t) TraceFormat::unzigzag(addr);
+        *prev_order += (uint64_t) TraceFormat::unzigzag(order);
+        *valid = tag < NumOfFlag && type < NumOfType && id * MaxDepth <= this->_stacks.size();
+        if (!*valid) {
+            return p;
+        }
+        record->_flag = (MEMFLAG) tag;
+        record->_type = (OperationType) type;
+        record->_order = *prev_order;
+        record->_addr = *prev_addr;
+        record->_bytes = bytes;
+        if (id == 0) {
+            ::memset(record->_caller, 0, sizeof(record->_caller));
+        } else {
+            ::memcpy(record->_caller, this->_stacks.data() + (id - 1) * MaxDepth, sizeof(record->_caller));
+        }
+        return p;
+    };
+
+    template<typename Closure>
+    ssize_t for_each_compact(Closure closure) {
+        //一个条目或者一条记录最多占用的字节数
+        constexpr size_t MaxEntryBytes = 2 + TraceFormat::MaxVarintBytes * (MaxDepth + 4);
+        ssize_t count = 0;
+        this->_offset = TraceFormat::HeaderBytes;
+        while (this->remaining() > 0) {
+            const uint8_t *end;
+            auto p = this->map(MaxEntryBytes, &end);
+            if (p == nullptr) {
+                return -1;
+            }
+            const auto tag = *p++;
+            if (tag == TraceFormat::StackTag) {
+                p = this->read_stack(p, end);
+                if (p == nullptr) {
+                    break;
+                }
+                this->_offset = this->_window_base + (p - this->_window);
+                continue;
+            }
+            uint64_t thread_id, num;
+            if (tag != TraceFormat::BlockTag ||
+                (p = TraceFormat::get_varint(p, end, &thread_id)) == nullptr ||
+                (p = TraceFormat::get_varint(p, end, &num)) == nullptr) {
+                break;
+            }
+            this->_offset = this->_window_base + (p - this->_window);
+            uintptr_t prev_addr = 0;
+            uint64_t prev_order = 0;
+            for (uint64_t i = 0; i < num; ++i) {
+                p = this->map(MaxEntryBytes, &end);
+                if (p == nullptr) {
+                    return -1;
+                }
+                Record record;
+                bool valid;
+                p = this->read_record(p, end, &record, &prev_addr, &prev_order, &valid);
+                if (p == nullptr) {
+                    return count;
+                }
+                this->_offset = this->_window_base + (p - this->_window);
+                if (valid) {
+                    closure(record);
+                } else {
+                    ++this->_invalid;
+                }
+                ++count;
+            }
+        }
+        return count;
+    };
+
+public:
+    TraceReader() : _fd(-1), _file_bytes(0), _page_bytes(::sysconf(_SC_PAGESIZE)),
+                    _window(nullptr), _window_base(0), _window_bytes(0), _offset(0), _invalid(0),
+                    _version(TraceFormat::LegacyRawVersion), _max_depth(MaxDepth) {};
+
+    ~TraceReader() {
+        if (this->_window != nullptr) {
+            ::munmap(this->_window, this->_window_bytes);
+        }
+        if (this->_fd >= 0) {
+            ::close(this->_fd);
+        }
+    };
+
+    bool open(const char *path) {
+        this->_fd = ::open(path, O_RDONLY);
+        struct stat st{};
+        if (this->_fd < 0 || ::fstat(this->_fd, &st) != 0) {
+            return false;
+        }
+        this->_file_bytes = st.st_size;
+        //没有文件头的是旧的raw格式
+        uint8_t header[TraceFormat::HeaderBytes];
+        if (::pread(this->_fd, header, sizeof(header), 0) == (ssize_t) sizeof(header) &&
+            ::memcmp(header, TraceFormat::Magic, sizeof(TraceFormat::Magic)) == 0) {
+            this->_version = header[sizeof(TraceFormat::Magic)];
+            this->_max_depth = header[sizeof(TraceFormat::Magic) + 1];
+        }
+        return true;
+    };
+
+    [[nodiscard]] inline size_t file_bytes() const {
+        return this->_file_bytes;
+    };
+
+    /**
+     * 没有读取的字节数 读取结束后即为末尾不完整的数据
+     */
+    [[nodiscard]] inline size_t remaining() const {
+        return this->_file_bytes - this->_offset;
+    };
+
+    [[nodiscard]] inline size_t invalid() const {
+        return this->_invalid;
+    };
+
+    [[nodiscard]] inline size_t num_stacks() const {
+        return this->_stacks.size() / MaxDepth;
+    };
+
+    [[nodiscard]] inline uint8_t version() const {
+        return this->_version;
+    };
+
+    /**
+     * 依次处理每一条完整的记录
+     * @return 读取的记录数量 映射失败或者格式不支持时返回-1
+     */
+    template<typename Closure>
+    ssize_t for_each(Closure closure) {
+        if (this->_version == TraceFormat::LegacyRawVersion) {
+            return this->for_each_raw<LegacyUnit>(0, closure);
+        }
+        //堆栈的深度不同时 记录的结构也不同
+        if (this->_max_depth != MaxDepth) {
+            return -1;
+        }
+        if (this->_version == TraceFormat::RawVersion) {
+            return this->for_each_raw<Unit>(TraceFormat::HeaderBytes, closure);
+        }
+        if (this->_version == TraceFormat::CompactVersion) {
+            return this->for_each_compact(closure);
+        }
+        return -1;
+    };
+};
+
+/**
+ * 调用位置 由内存类型和调用堆栈确定
+ */
+class SiteTable {
+public:
+    struct Site {
+        uint64_t _hash;
+        MEMFLAG _flag;
+        uintptr_t _stack[MaxDepth];
+        size_t _alloc_count;
+        size_t _alloc_bytes;
+        size_t _live_count;
+        size_t _live_bytes;
+    };
+private:
+    /**
+     * 开放寻址的哈希表 值为_sites中的序号加1 0表示空闲
+     */
+    uint32_t *_slots;
+    uint32_t _num_slots;
+    Site *_sites;
+    uint32_t _num_sites;
+    uint32_t _cap_sites;
+
+    static uint64_t hash_of(MEMFLAG F, const uintptr_t *stack) {
+        uint64_t hash = (uint64_t) F;
+        for (int32_t i = 0; i < MaxDepth; ++i) {
+            //splitmix64 的混合函数
+            auto x = hash ^ (stack[i] + 0x9E3779B97F4A7C15ULL);
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+            hash = x ^ (x >> 31);
+        }
+        return hash;
+    };
+
+    void rehash(uint32_t num_slots) {
+        ::free(this->_slots);
+        this->_slots = (uint32_t *) checked_realloc(nullptr, num_slots * sizeof(uint32_t));
+        ::memset(this->_slots, 0, num_slots * sizeof(uint32_t));
+        this->_num_slots = num_slots;
+        for (uint32_t i = 0; i < this->_num_sites; ++i) {
+            auto slot = (uint32_t) this->_sites[i]._hash & (num_slots - 1);
+            while (this->_slots[slot] != 0) {
+                slot = (slot + 1) & (num_slots - 1);
+            }
+            this->_slots[slot] = i + 1;
+        }
+    };
+
+public:
+    SiteTable() : _slots(nullptr), _num_slots(0), _sites(nullptr), _num_sites(0), _cap_sites(0) {
+        this->rehash(1024);
+    };
+
+    ~SiteTable() {
+        ::free(this->_slots);
+        ::free(this->_sites);
+    };
+
+    /**
+     * @return 调用位置的序号
+     */
+    uint32_t find_or_add(MEMFLAG F, const uintptr_t *stack) {
+        const auto hash = hash_of(F, stack);
+        auto slot = (uint32_t) hash & (this->_num_slots - 1);
+        for (; this->_slots[slot] != 0; slot = (slot + 1) & (this->_num_slots - 1)) {
+            const auto index = this->_slots[slot] - 1;
+            const auto &site = this->_sites[index];
+            if (site._hash == hash && site._flag == F &&
+                ::memcmp(site._stack, stack, sizeof(site._stack)) == 0) {
+                return index;
+            }
+        }
+        if (this->_num_sites == this->_cap_sites) {
+            this->_cap_sites = MAX2<uint32_t>(this->_cap_sites * 2, 256);
+            this->_sites = (Site *) checked_realloc(this->_sites, this->_cap_sites * sizeof(Site));
+        }
+        const auto index = this->_num_sites++;
+        auto &site = this->_sites[index];
+        ::memset(&site, 0, sizeof(Site));
+        site._hash = hash;
+        site._flag = F;
+        ::memcpy(site._stack, stack, sizeof(site._stack));
+        this->_slots[slot] = index + 1;
+        //负载因子不超过1/2
+        if (this->_num_sites * 2 > this->_num_slots) {
+            this->rehash(this->_num_slots * 2);
+        }
+        return index;
+    };
+
+    inline Site &at(uint32_t index) {
+        return this->_sites[index];
+    };
+
+    [[nodiscard]] inline uint32_t size() const {
+        return this->_num_sites;
+    };
+};
+
+/**
+ * 存活的申请 按照地址索引
+ * 地址至少按照字对齐 最低位用于区分本地内存和快速内存
+ */
+class LiveTable {
+public:
+    struct Entry {
+        uintptr_t _key;
+        size_t _bytes;
+        /**
+         * 申请或者孤立的释放的序号
+         */
+        uint64_t _order;
+        uint32_t _site;
+        /**
+         * 孤立的释放 即释放先于申请出现
+         */
+        bool _orphan;
+    };
+private:
+    Entry *_entries;
+    size_t _num_entries;
+    size_t _size;
+
+    inline size_t slot_of(uintptr_t key) const {
+        return (size_t) ((key * 0x9E3779B97F4A7C15ULL) >> 17) & (this->_num_entries - 1);
+    };
+
+    void grow() {
+        const auto old_entries = this->_entries;
+        const auto old_num = this->_num_entries;
+        this->_num_entries = old_num * 2;
+        this->_entries = (Entry *) checked_realloc(nullptr, this->_num_entries * sizeof(Entry));
+        ::memset(this->_entries, 0, this->_num_entries * sizeof(Entry));
+        for (size_t i = 0; i < old_num; ++i) {
+            if (old_entries[i]._key != 0) {
+                *this->probe(old_entries[i]._key) = old_entries[i];
+            }
+        }
+        ::free(old_entries);
+    };
+
+public:
+    LiveTable() : _entries(nullptr), _num_entries(1 << 16), _size(0) {
+        this->_entries = (Entry *) checked_realloc(nullptr, this->_num_entries * sizeof(Entry));
+        ::memset(this->_entries, 0, this->_num_entries * sizeof(Entry));
+    };
+
+    ~LiveTable() {
+        ::free(this->_entries);
+    };
+
+    /**
+     * @return key所在的位置 或者应当插入的空闲位置(_key为0)
+     */
+    Entry *probe(uintptr_t key) {
+        auto slot = this->slot_of(key);
+        while (this->_entries[slot]._key != 0 && this->_entries[slot]._key != key) {
+            slot = (slot + 1) & (this->_num_entries - 1);
+        }
+        return this->_entries + slot;
+    };
+
+    /**
+     * 占用probe返回的空闲位置
+     */
+    Entry *insert(Entry *entry, uintptr_t key) {
+        entry->_key = key;
+        if (++this->_size * 2 > this->_num_entries) {
+            this->grow();
+            return this->probe(key);
+        }
+        return entry;
+    };
+
+    /**
+     * 删除之后 将后续同一探测链上的条目前移 不需要墓碑
+     */
+    void remove(Entry *entry) {
+        auto hole = (size_t) (entry - this->_entries);
+        auto slot = hole;
+        const auto mask = this->_num_entries - 1;
+        while (true) {
+            slot = (slot + 1) & mask;
+            const auto &next = this->_entries[slot];
+            if (next._key == 0) {
+                break;
+            }
+            const auto home = this->slot_of(next._key);
+            //home 不在 (hole, slot] 之间时可以前移到hole
+            if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+                this->_entries[hole] = next;
+                hole = slot;
+            }
+        }
+        this->_entries[hole]._key = 0;
+        --this->_size;
+    };
+};
+
+/**
+ * 直接读取ELF文件中的符号表(.symtab 没有时使用.dynsym)
+ * 只映射文件 不加载模块 不会执行模块的初始化代码
+ */
+class ElfSymbols {
+private:
+    struct Symbol {
+        uintptr_t _addr;
+        size_t _size;
+        /**
+         * 名字在字符串表中的偏移
+         */
+        uint32_t _name;
+    };
+
+    void *_file;
+    size_t _file_bytes;
+    const char *_strtab;
+    size_t _strtab_bytes;
+    /**
+     * 第一个可加载段的虚拟地址减去文件偏移 对应文件偏移为0的映射的起始地址
+     */
+    uintptr_t _bias;
+    /**
+     * 按照地址从小到大排序的函数
+     */
+    std::vector<Symbol> _symbols;
+
+    inline bool contains(size_t offset, size_t bytes) const {
+        return offset <= this->_file_bytes && bytes <= this->_file_bytes - offset;
+    };
+
+public:
+    ElfSymbols() : _file(nullptr), _file_bytes(0), _strtab(nullptr), _strtab_bytes(0), _bias(0) {};
+
+    ~ElfSymbols() {
+        if (this->_file != nullptr) {
+            ::munmap(this->_file, this->_file_bytes);
+        }
+    };
+
+    /**
+     * @return 不是64位的ELF文件 或者没有符号表时返回false
+     */
+    bool load(const char *path) {
+        const auto fd = ::open(path, O_RDONLY);
+        struct stat st{};
+        if (fd < 0 || ::fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(Elf64_Ehdr)) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            return false;
+        }
+        const auto file = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (file == MAP_FAILED) {
+            return false;
+        }
+        this->_file = file;
+        this->_file_bytes = st.st_size;
+        const auto base = (const uint8_t *) file;
+        const auto ehdr = (const Elf64_Ehdr *) base;
+        if (::memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 || ehdr->e_ident[EI_CLASS] != ELFCLASS64 ||
+            !this->contains(ehdr->e_phoff, ehdr->e_phnum * sizeof(Elf64_Phdr)) ||
+            !this->contains(ehdr->e_shoff, ehdr->e_shnum * sizeof(Elf64_Shdr))) {
+            return false;
+        }
+        const auto phdrs = (const Elf64_Phdr *) (base + ehdr->e_phoff);
+        for (uint32_t i = 0; i < ehdr->e_phnum; ++i) {
+            if (phdrs[i].p_type == PT_LOAD) {
+                this->_bias = phdrs[i].p_vaddr - phdrs[i].p_offset;
+                break;
+            }
+        }
+        const auto shdrs = (const Elf64_Shdr *) (base + ehdr->e_shoff);
+        const Elf64_Shdr *symtab = nullptr;
+        for (uint32_t i = 0; i < ehdr->e_shnum; ++i) {
+            if (shdrs[i].sh_type == SHT_SYMTAB ||
+                (shdrs[i].sh_type == SHT_DYNSYM && symtab == nullptr)) {
+                symtab = shdrs + i;
+            }
+        }
+        if (symtab == nullptr || symtab->sh_link >= ehdr->e_shnum ||
+            !this->contains(symtab->sh_offset, symtab->sh_size)) {
+            return false;
+        }
+        const auto strtab = shdrs + symtab->sh_link;
+        if (!this->contains(strtab->sh_offset, strtab->sh_size)) {
+            return false;
+        }
+        this->_strtab = (const char *) base + strtab->sh_offset;
+        this->_strtab_bytes = strtab->sh_size;
+        const auto syms = (const Elf64_Sym *) (base + symtab->sh_offset);
+        const auto num_syms = symtab->sh_size / sizeof(Elf64_Sym);
+        for (size_t i = 0; i < num_syms; ++i) {
+            const auto &sym = syms[i];
+            if (ELF64_ST_TYPE(sym.st_info) == STT_FUNC && sym.st_shndx != SHN_UNDEF &&
+                sym.st_value != 0 && sym.st_name < this->_strtab_bytes) {
+                this->_symbols.push_back({sym.st_value, sym.st_size, sym.st_name});
+            }
+        }
+        std::sort(this->_symbols.begin(), this->_symbols.end(), [](const Symbol &l, const Symbol &r) {
+            return l._addr < r._addr;
+        });
+        return !this->_symbols.empty();
+    };
+
+    /**
+     * @param offset 相对于文件偏移为0的映射的偏移
+     * @param delta 相对于函数起始地址的偏移
+     * @return 所在的函数 没有找到时返回nullptr
+     */
+    const char *find(uintptr_t offset, uintptr_t *delta) const {
+        const auto addr = offset + this->_bias;
+        auto it = std::upper_bound(this->_symbols.begin(), this->_symbols.end(), addr,
+                                   [](uintptr_t value, const Symbol &symbol) {
+                                       return value < symbol._addr;
+                                   });
+        if (it == this->_symbols.begin()) {
+            return nullptr;
+        }
+        --it;
+        //大小未知的函数 只接受恰好是起始地址的情况
+        if (addr - it->_addr >= MAX2<size_t>(it->_size, 1)) {
+            return nullptr;
+        }
+        *delta = addr - it->_addr;
+        return this->_strtab + it->_name;
+    };
+};
+
+/**
+ * 通过模块映射和模块文件中的符号表还原符号
+ */
+class Symbolizer {
+private:
+    struct Module {
+        uintptr_t _start;
+        uintptr_t _end;
+        /**
+         * 模块在追踪的进程中的加载地址 即同一文件偏移为0的映射的起始地址
+         */
+        uintptr_t _base;
+        char *_path;
+        /**
+         * 第一次用到时读取 nullptr表示无法读取
+         */
+        ElfSymbols *_symbols;
+        bool _resolved;
+    };
+
+    std::vector<Module> _modules;
+
+    static void resolve(Module &module) {
+        module._resolved = true;
+        const auto symbols = new ElfSymbols();
+        if (symbols->load(module._path)) {
+            module._symbols = symbols;
+        } else {
+            delete symbols;
+        }
+    };
+
+public:
+    ~Symbolizer() {
+        for (auto &module: this->_modules) {
+            ::free(module._path);
+            delete module._symbols;
+        }
+    };
+
+    /**
+     * 读取模块映射文件 只保留可执行的映射
+     */
+    bool load(const char *maps_path) {
+        const auto file = ::fopen(maps_path, "r");
+        if (file == nullptr) {
+            return false;
+        }
+        struct Mapping {
+            uintptr_t _start;
+            uintptr_t _end;
+            uintptr_t _offset;
+            bool _exec;
+            char *_path;
+        };
+        std::vector<Mapping> mappings;
+        char line[4096];
+        while (::fgets(line, sizeof(line), file) != nullptr) {
+            unsigned long start, end, offset;
+            char perms[8];
+            int path_pos = 0;
+            if (::sscanf(line, "%lx-%lx %7s %lx %*s %*s %n", &start, &end, perms, &offset, &path_pos) < 4 ||
+                path_pos == 0 || line[path_pos] != '/') {
+                continue;
+            }
+            line[::strcspn(line, "\n")] = '\0';
+            mappings.push_back({start, end, offset, perms[2] == 'x', ::strdup(line + path_pos)});
+        }
+        ::fclose(file);
+        for (auto &mapping: mappings) {
+            if (!mapping._exec) {
+                continue;
+            }
+            auto base = mapping._start - mapping._offset;
+            for (const auto &other: mappings) {
+                if (other._offset == 0 && ::strcmp(other._path, mapping._path) == 0) {
+                    base = other._start;
+                    break;
+                }
+            }
+            this->_modules.push_back({mapping._start, mapping._end, base, ::strdup(mapping._path), nullptr, false});
+        }
+        for (auto &mapping: mappings) {
+            ::free(mapping._path);
+        }
+        return true;
+    };
+
+    void print(CharOStream *out, uintptr_t pc) {
+        for (auto &module: this->_modules) {
+            if (pc < module._start || pc >= module._end) {
+                continue;
+            }
+            if (!module._resolved) {
+                resolve(module);
+            }
+            const auto offset = pc - module._base;
+            uintptr_t delta;
+            const auto name = module._symbols != nullptr ? module._symbols->find(offset, &delta) : nullptr;
+            if (name != nullptr) {
+                int status = -1;
+                const auto demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+                out->print_cr("        " PTR_FORMAT " %s+0x%lx (%s)", pc,
+                              status == 0 ? demangled : name, (unsigned long) delta, module._path);
+                ::free(demangled);
+                return;
+            }
+            //没有符号表的模块 输出偏移 交给addr2line
+            out->print_cr("        " PTR_FORMAT " %s+0x%lx", pc, module._path, (unsigned long) offset);
+            return;
+        }
+        out->print_cr("        " PTR_FORMAT " ??", pc);
+    };
+};
+
+/**
+ * 汇总的结果
+ */
+class Aggregator {
+private:
+    size_t _count[NumOfFlag][NumOfType];
+    size_t _bytes[NumOfFlag][NumOfType];
+    /**
+     * 孤立的释放 以及覆盖了存活申请的申请
+     */
+    size_t _orphan_frees;
+    size_t _overwritten;
+    SiteTable _sites;
+    LiveTable _live;
+
+    static inline uintptr_t key_of(const Record &record, bool arena) {
+        return record._addr | (arena ? 1 : 0);
+    };
+
+    void on_alloc(const Record &record, bool arena) {
+        const auto key = key_of(record, arena);
+        auto entry = this->_live.probe(key);
+        if (entry->_key != 0) {
+            if (entry->_orphan) {
+                if (entry->_order > record._order) {
+                    //释放先于申请写出 二者抵消
+                    --this->_orphan_frees;
+                    this->_live.remove(entry);
+                    return;
+                }
+                //释放的是更早的申请(追踪之前或者丢失) 仍然是孤立的 当前的申请存活
+            } else {
+                //释放的记录丢失
+                ++this->_overwritten;
+                auto &old = this->_sites.at(entry->_site);
+                --old._live_count;
+                old._live_bytes -= entry->_bytes;
+            }
+        } else {
+            entry = this->_live.insert(entry, key);
+        }
+        const auto index = this->_sites.find_or_add(record._flag, record._caller);
+        auto &site = this->_sites.at(index);
+        ++site._alloc_count;
+        site._alloc_bytes += record._bytes;
+        ++site._live_count;
+        site._live_bytes += record._bytes;
+        entry->_bytes = record._bytes;
+        entry->_order = record._order;
+        entry->_site = index;
+        entry->_orphan = false;
+    };
+
+    void on_free(const Record &record, bool arena) {
+        const auto key = key_of(record, arena);
+        auto entry = this->_live.probe(key);
+        if (entry->_key == 0) {
+            entry = this->_live.insert(entry, key);
+            entry->_bytes = record._bytes;
+            entry->_order = record._order;
+            entry->_orphan = true;
+            ++this->_orphan_frees;
+            return;
+        }
+        if (entry->_orphan) {
+            //重复的释放
+            ++this->_orphan_frees;
+            return;
+        }
+        auto &site = this->_sites.at(entry->_site);
+        --site._live_count;
+        site._live_bytes -= entry->_bytes;
+        this->_live.remove(entry);
+    };
+
+    /**
+     * 按照key从大到小 输出前top_n个调用位置
+     */
+    template<typename Key>
+    void print_sites(CharOStream *out, Symbolizer *symbolizer, int top_n, Key key) {
+        std::vector<uint32_t> order;
+        for (uint32_t i = 0; i < this->_sites.size(); ++i) {
+            if (key(this->_sites.at(i)) > 0) {
+                order.push_back(i);
+            }
+        }
+        const auto n = MIN2<size_t>(order.size(), top_n);
+        std::partial_sort(order.begin(), order.begin() + n, order.end(), [&](uint32_t l, uint32_t r) {
+            return key(this->_sites.at(l)) > key(this->_sites.at(r));
+        });
+        for (size_t k = 0; k < n; ++k) {
+            const auto &site = this->_sites.at(order[k]);
+            out->print_cr("  [" SIZE_FORMAT "] %s live " SIZE_FORMAT " bytes in " SIZE_FORMAT
+                          " allocations, total " SIZE_FORMAT " bytes in " SIZE_FORMAT " allocations",
+                          k, MEMFLAG_NAME(site._flag), site._live_bytes, site._live_count,
+                          site._alloc_bytes, site._alloc_count);
+            for (auto pc: site._stack) {
+                if (pc == 0) {
+                    break;
+                }
+                symbolizer->print(out, pc);
+            }
+        }
+    };
+
+public:
+    Aggregator() : _count(), _bytes(), _orphan_frees(0), _overwritten(0) {};
+
+    void accept(const Record &record) {
+        const auto F = (int32_t) record._flag;
+        const auto T = (int32_t) record._type;
+        ++this->_count[F][T];
+        this->_bytes[F][T] += record._bytes;
+        switch (record._type) {
+            case OperationType::native_alloc:
+                this->on_alloc(record, false);
+                break;
+            case OperationType::arena_alloc:
+                this->on_alloc(record, true);
+                break;
+            case OperationType::native_free:
+                this->on_free(record, false);
+                break;
+            case OperationType::arena_free:
+                this->on_free(record, true);
+                break;
+            default:
+                break;
+        }
+    };
+
+    void print(CharOStream *out, Symbolizer *symbolizer, int top_n) {
+        out->print_cr("operations by memory type:");
+        for (int32_t F = 0; F < NumOfFlag; ++F) {
+            for (int32_t T = 0; T < NumOfType; ++T) {
+                if (this->_count[F][T] == 0) {
+                    continue;
+                }
+                out->print_cr("  %-12s %-14s %12lu ops %16lu bytes",
+                              MEMFLAG_NAME((MEMFLAG) F), TYPE_NAMES[T],
+                              this->_count[F][T], this->_bytes[F][T]);
+            }
+        }
+        size_t live_count[NumOfFlag] = {};
+        size_t live_bytes[NumOfFlag] = {};
+        for (uint32_t i = 0; i < this->_sites.size(); ++i) {
+            const auto &site = this->_sites.at(i);
+            live_count[(int32_t) site._flag] += site._live_count;
+            live_bytes[(int32_t) site._flag] += site._live_bytes;
+        }
+        out->print_cr("live at end of trace (leaks) by memory type:");
+        for (int32_t F = 0; F < NumOfFlag; ++F) {
+            if (live_count[F] != 0) {
+                out->print_cr("  %-12s " SIZE_FORMAT " bytes in " SIZE_FORMAT " allocations",
+                              MEMFLAG_NAME((MEMFLAG) F), live_bytes[F], live_count[F]);
+            }
+        }
+        out->print_cr("top %d leak sites:", top_n);
+        this->print_sites(out, symbolizer, top_n, [](const SiteTable::Site &site) {
+            return site._live_bytes;
+        });
+        out->print_cr("top %d allocation sites:", top_n);
+        this->print_sites(out, symbolizer, top_n, [](const SiteTable::Site &site) {
+            return site._alloc_bytes;
+        });
+        out->print_cr(SIZE_FORMAT " call sites, "
+                      SIZE_FORMAT " frees without allocation (before tracing or dropped), "
+                      SIZE_FORMAT " allocations over a live address (free dropped).",
+                      (size_t) this->_sites.size(), this->_orphan_frees, this->_overwritten);
+    };
+};
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        ::fprintf(stderr, "usage: %s <trace> [top_n] [maps]\n", argv[0]);
+        return 2;
+    }
+    const auto trace_path = argv[1];
+    const auto top_n = argc > 2 ? ::atoi(argv[2]) : 10;
+    char maps_path[4096];
+    if (argc > 3) {
+        ::snprintf(maps_path, sizeof(maps_path), "%s", argv[3]);
+    } else {
+        ::snprintf(maps_path, sizeof(maps_path), "%s%s", trace_path, DetailLogMemory::MapsSuffix);
+    }
+    FileCharOStream out(stdout);
+    TraceReader reader;
+    if (!reader.open(trace_path)) {
+        ::fprintf(stderr, "error: can not open trace file %s.\n", trace_path);
+        return 1;
+    }
+    Symbolizer symbolizer;
+    if (!symbolizer.load(maps_path)) {
+        ::fprintf(stderr, "warning: can not open module maps %s, call sites are not symbolized.\n", maps_path);
+    }
+    Aggregator aggregator;
+    Reorderer reorderer;
+    auto accept = [&aggregator](const Record &record) {
+        aggregator.accept(record);
+    };
+    const auto records = reader.for_each([&reorderer, &accept](const Record &record) {
+        reorderer.accept(record, accept);
+    });
+    reorderer.finish(accept);
+    if (records < 0) {
+        ::fprintf(stderr, "error: can not map trace file %s or format version %u is not supported.\n",
+                  trace_path, reader.version());
+        return 1;
+    }
+    out.print_cr("trace %s (version %u): " SIZE_FORMAT " records, " SIZE_FORMAT " bytes, "
+                 SIZE_FORMAT " stacks in dictionary, " SIZE_FORMAT " invalid records, "
+                 SIZE_FORMAT " trailing bytes ignored, " SIZE_FORMAT " records out of reorder window.",
+                 trace_path, reader.version(), (size_t) records, reader.file_bytes(),
+                 reader.num_stacks(), reader.invalid(), reader.remaining(), reorderer.late());
+    aggregator.print(&out, &symbolizer, top_n);
+    out.flush();
+    return 0;
+}